@@ -0,0 +1,273 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "tiny_dnn/tiny_dnn.h"
+#include "tiny_dnn/util/batching_engine.h"
+
+typedef std::chrono::steady_clock clock_type;
+
+static void construct_net(tiny_dnn::network<tiny_dnn::sequential> &nn) {
+  using fc       = tiny_dnn::layers::fc;
+  using conv     = tiny_dnn::layers::conv;
+  using max_pool = tiny_dnn::layers::max_pool;
+  using relu     = tiny_dnn::activation::relu;
+  using softmax  = tiny_dnn::activation::softmax;
+
+  nn << conv(28, 28, 5, 1, 6) << relu() << max_pool(24, 24, 6, 2)
+     << conv(12, 12, 5, 6, 16) << relu() << max_pool(8, 8, 16, 2)
+     << fc(4 * 4 * 16, 120) << relu() << fc(120, 10) << softmax();
+  nn.init_weight();
+}
+
+// value at the given fraction of the sorted samples
+static double percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty()) return 0.0;
+  const size_t i = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(i, sorted.size() - 1)];
+}
+
+/**
+ * one client of the load test: requests sent at random intervals (Poisson
+ * arrivals at the given rate) until the given time, without waiting for
+ * the replies, and a receiver timing the replies as they come; the engine
+ * serves requests in order, so the receiver waits for them in order too
+ **/
+class client {
+ public:
+  client(tiny_dnn::batching_engine<tiny_dnn::sequential> &engine,
+         size_t in_size,
+         unsigned int seed)
+    : engine_(engine), in_(in_size), gen_(seed), done_(false) {
+    tiny_dnn::uniform_rand(in_.begin(), in_.end(), -1.0, 1.0);
+  }
+
+  void run(double rate, clock_type::time_point end) {
+    std::thread receiver([this] { receive(); });
+    std::exponential_distribution<double> interval(rate);
+    auto next = clock_type::now();
+    while (next < end) {
+      std::this_thread::sleep_until(next);
+      const auto sent = clock_type::now();
+      auto reply      = engine_.predict(in_);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sent_.emplace_back(sent, std::move(reply));
+      }
+      ready_.notify_one();
+      next += std::chrono::duration_cast<clock_type::duration>(
+        std::chrono::duration<double>(interval(gen_)));
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_ = true;
+    }
+    ready_.notify_one();
+    receiver.join();
+  }
+
+  // in milliseconds
+  const std::vector<double> &latencies() const { return latencies_; }
+
+ private:
+  typedef std::pair<clock_type::time_point, std::future<tiny_dnn::vec_t>>
+    request;
+
+  void receive() {
+    for (;;) {
+      request r;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this] { return done_ || !sent_.empty(); });
+        if (sent_.empty()) return;
+        r = std::move(sent_.front());
+        sent_.pop_front();
+      }
+      r.second.wait();
+      latencies_.push_back(
+        std::chrono::duration<double, std::milli>(clock_type::now() - r.first)
+          .count());
+    }
+  }
+
+  tiny_dnn::batching_engine<tiny_dnn::sequential> &engine_;
+  tiny_dnn::vec_t in_;
+  std::mt19937 gen_;
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<request> sent_;
+  bool done_;
+  std::vector<double> latencies_;
+};
+
+/**
+ * clients sending requests for the given time, all together at the given
+ * rate, then the throughput and the latencies seen by the clients
+ **/
+static void load_test(tiny_dnn::batching_engine<tiny_dnn::sequential> &engine,
+                      size_t in_size,
+                      int clients,
+                      double rate,
+                      double seconds) {
+  std::vector<std::unique_ptr<client>> all;
+  for (int c = 0; c < clients; c++) {
+    all.emplace_back(new client(engine, in_size, static_cast<unsigned>(c)));
+  }
+
+  const auto start = clock_type::now();
+  const auto end =
+    start + std::chrono::duration_cast<clock_type::duration>(
+              std::chrono::duration<double>(seconds));
+  std::vector<std::thread> threads;
+  for (auto &c : all) {
+    client *cl = c.get();
+    threads.emplace_back([=] { cl->run(rate / clients, end); });
+  }
+  for (auto &t : threads) t.join();
+  const double elapsed =
+    std::chrono::duration<double>(clock_type::now() - start).count();
+
+  std::vector<double> latencies;
+  for (auto &c : all) {
+    latencies.insert(latencies.end(), c->latencies().begin(),
+                     c->latencies().end());
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << "requests:   " << latencies.size() << std::endl;
+  std::cout << "throughput: " << latencies.size() / elapsed << " req/s"
+            << std::endl;
+  std::cout << "batches:    " << engine.batches() << " (mean size "
+            << double(engine.requests()) / std::max<size_t>(1, engine.batches())
+            << ")" << std::endl;
+  std::cout << "latency p50: " << percentile(latencies, 0.50) << " ms"
+            << std::endl;
+  std::cout << "latency p99: " << percentile(latencies, 0.99) << " ms"
+            << std::endl;
+}
+
+/**
+ * stand-in for an RPC front end: one request per line of stdin (the input
+ * values separated by spaces), its output written to stdout in the same order
+ * as soon as it is ready, while the next lines are being read
+ **/
+static void serve_stdin(tiny_dnn::batching_engine<tiny_dnn::sequential> &engine,
+                        size_t in_size) {
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::deque<std::future<tiny_dnn::vec_t>> replies;
+  bool done = false;
+
+  std::thread printer([&] {
+    for (;;) {
+      std::future<tiny_dnn::vec_t> reply;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [&] { return done || !replies.empty(); });
+        if (replies.empty()) return;
+        reply = std::move(replies.front());
+        replies.pop_front();
+      }
+      const tiny_dnn::vec_t out = reply.get();
+      for (size_t i = 0; i < out.size(); i++) {
+        std::cout << (i ? " " : "") << out[i];
+      }
+      std::cout << std::endl;
+    }
+  });
+
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    std::istringstream ss(line);
+    tiny_dnn::vec_t in;
+    tiny_dnn::float_t x;
+    while (ss >> x) in.push_back(x);
+    if (in.empty()) continue;
+    if (in.size() != in_size) {
+      std::cerr << "expected " << in_size << " values, got " << in.size()
+                << std::endl;
+      continue;
+    }
+    auto reply = engine.predict(in);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      replies.push_back(std::move(reply));
+    }
+    ready.notify_one();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+  }
+  ready.notify_one();
+  printer.join();
+}
+
+static void usage(const char *argv0) {
+  std::cout << "Usage: " << argv0 << " [--stdin] [--clients 8]"
+            << " [--rate 2000] [--seconds 5] [--max_batch 32]"
+            << " [--max_delay_us 2000]" << std::endl;
+}
+
+int main(int argc, char **argv) {
+  bool from_stdin = false;
+  int clients     = 8;
+  double rate     = 2000;  // requests per second, all clients together
+  double seconds  = 5;
+  tiny_dnn::batching_params params;
+  params.max_delay = std::chrono::microseconds(2000);
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "--stdin") {
+      from_stdin = true;
+    } else if (i + 1 < argc && arg == "--clients") {
+      clients = std::atoi(argv[++i]);
+    } else if (i + 1 < argc && arg == "--rate") {
+      rate = std::atof(argv[++i]);
+    } else if (i + 1 < argc && arg == "--seconds") {
+      seconds = std::atof(argv[++i]);
+    } else if (i + 1 < argc && arg == "--max_batch") {
+      params.max_batch = static_cast<size_t>(std::atoi(argv[++i]));
+    } else if (i + 1 < argc && arg == "--max_delay_us") {
+      params.max_delay = std::chrono::microseconds(std::atoi(argv[++i]));
+    } else {
+      usage(argv[0]);
+      return -1;
+    }
+  }
+  if (clients <= 0 || rate <= 0 || seconds <= 0 || params.max_batch == 0) {
+    usage(argv[0]);
+    return -1;
+  }
+
+  tiny_dnn::network<tiny_dnn::sequential> nn;
+  construct_net(nn);
+  tiny_dnn::batching_engine<tiny_dnn::sequential> engine(nn, params);
+
+  if (from_stdin) {
+    serve_stdin(engine, nn.in_data_size());
+  } else {
+    load_test(engine, nn.in_data_size(), clients, rate, seconds);
+  }
+  return 0;
+}
@@ -19,6 +19,7 @@ using namespace tiny_dnn::activation;
 // TODO(yida): fix broken test
 // #include "test_average_unpooling_layer.h"
 #include "test_batch_norm_layer.h"
+#include "test_batching_engine.h"
 #include "test_concat_layer.h"
 #include "test_convolutional_layer.h"
 #include "test_core.h"
@@ -28,6 +29,7 @@ using namespace tiny_dnn::activation;
 #include "test_global_average_pooling_layer.h"
 #include "test_large_thread_count.h"
 #include "test_lrn_layer.h"
+#include "test_lstm_cell_layer.h"
 #include "test_max_pooling_layer.h"
 #include "test_models.h"
 #include "test_node.h"
@@ -36,7 +38,11 @@ using namespace tiny_dnn::activation;
 #include "test_quantization.h"
 #include "test_quantized_convolutional_layer.h"
 #include "test_quantized_deconvolutional_layer.h"
+#include "test_quantized_fully_connected_layer.h"
+#include "test_random.h"
 #include "test_recurrent_cell_layer.h"
+#include "test_recurrent_layer.h"
+#include "test_scratch_arena.h"
 #include "test_slice_layer.h"
 #include "test_target_cost.h"
 #include "test_tensor.h"
@@ -46,10 +52,6 @@ using namespace tiny_dnn::activation;
 #include "test_serialization.h"
 #endif  // CNN_NO_SERIALIZATION
 
-#ifdef CNN_USE_GEMMLOWP
-#include "test_quantized_fully_connected_layer.h"
-#endif  // CNN_USE_GEMMLOOP
-
 #ifdef CNN_USE_CAFFE_CONVERTER
 #include "test_caffe_converter.h"
 #endif  // CNN_USE_CAFFE_CONVERTER
@@ -223,6 +223,37 @@ TEST(batchnorm, forward) {
   }
 }
 
+TEST(batchnorm, moments) {
+  // more samples than blocks, values far from zero
+  const size_t num = 37, spatial_dim = 9, channels = 3;
+  tensor_t in(num, vec_t(spatial_dim * channels));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), 999.0, 1001.0);
+
+  vec_t mean, variance;
+  moments(in, spatial_dim, channels, mean, variance);
+
+  for (size_t j = 0; j < channels; j++) {
+    double sum = 0, sq = 0;
+    for (size_t i = 0; i < num; i++) {
+      const float_t *x = &in[i][j * spatial_dim];
+      for (size_t k = 0; k < spatial_dim; k++) sum += x[k];
+    }
+    const double m = sum / (num * spatial_dim);
+    for (size_t i = 0; i < num; i++) {
+      const float_t *x = &in[i][j * spatial_dim];
+      for (size_t k = 0; k < spatial_dim; k++) sq += (x[k] - m) * (x[k] - m);
+    }
+    EXPECT_NEAR(m, mean[j], 1e-3);
+    EXPECT_NEAR(sq / (num * spatial_dim - 1), variance[j], 1e-3);
+  }
+
+  vec_t mean_only;
+  moments(in, spatial_dim, channels, mean_only);
+  for (size_t j = 0; j < channels; j++) {
+    EXPECT_NEAR(mean[j], mean_only[j], 1e-3);
+  }
+}
+
 TEST(batchnorm, read_write) {
   batch_normalization_layer l1(100, 100);
   batch_normalization_layer l2(100, 100);
@@ -0,0 +1,84 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "test/testhelper.h"
+#include "tiny_dnn/tiny_dnn.h"
+#include "tiny_dnn/util/batching_engine.h"
+
+namespace tiny_dnn {
+
+TEST(batching_engine, concurrent_requests) {
+  network<sequential> nn;
+  nn << fully_connected_layer(6, 10) << tanh_layer()
+     << fully_connected_layer(10, 3) << softmax();
+  nn.init_weight();
+  nn.set_netphase(net_phase::test);
+
+  const size_t clients = 4, per_client = 25;
+  std::vector<vec_t> in(clients * per_client, vec_t(6));
+  std::vector<vec_t> expected;
+  for (auto &v : in) {
+    uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+    expected.push_back(nn.predict(v));
+  }
+
+  std::vector<vec_t> out(in.size());
+  batching_params params;
+  params.max_batch = 8;
+  {
+    batching_engine<sequential> engine(nn, params);
+    std::vector<std::thread> threads;
+    for (size_t c = 0; c < clients; c++) {
+      threads.emplace_back([&, c] {
+        std::vector<std::future<vec_t>> futures;
+        for (size_t i = c * per_client; i < (c + 1) * per_client; i++) {
+          futures.push_back(engine.predict(in[i]));
+        }
+        for (size_t i = 0; i < per_client; i++) {
+          out[c * per_client + i] = futures[i].get();
+        }
+      });
+    }
+    for (auto &t : threads) t.join();
+
+    EXPECT_EQ(in.size(), engine.requests());
+    EXPECT_LE((in.size() + params.max_batch - 1) / params.max_batch,
+              engine.batches());
+    EXPECT_THROW(engine.predict(vec_t(5)), nn_error);
+  }
+
+  for (size_t i = 0; i < in.size(); i++) {
+    for (size_t j = 0; j < 3; j++) EXPECT_FLOAT_EQ(expected[i][j], out[i][j]);
+  }
+}
+
+TEST(batching_engine, pending_requests_served) {
+  network<sequential> nn;
+  nn << fully_connected_layer(2, 2);
+  nn.init_weight();
+
+  // a long delay: the engine being destroyed runs the last batch at once
+  batching_params params;
+  params.max_delay = std::chrono::microseconds(10000000);
+  std::future<vec_t> out;
+  {
+    batching_engine<sequential> engine(nn, params);
+    out = engine.predict(vec_t(2, float_t(1)));
+  }
+  EXPECT_EQ(std::future_status::ready, out.wait_for(std::chrono::seconds(0)));
+  EXPECT_EQ(size_t(2), out.get().size());
+}
+
+}  // namespace tiny_dnn
@@ -78,4 +78,28 @@ TEST(concat, forward_data) {
   }
 }
 
+TEST(concat, zero_copy) {
+  input_layer in(shape3d(1, 1, 6));
+  slice_layer sl(shape3d(1, 1, 6), slice_type::slice_channels, 2);
+  fully_connected_layer f1(3, 3), f2(3, 2);
+  concat_layer cl({shape3d(1, 1, 3), shape3d(1, 1, 2)});
+  fully_connected_layer f3(5, 2);
+
+  in << sl;
+  sl << (f1, f2) << cl << f3;
+
+  network<graph> net;
+  construct_graph(net, {&in}, {&f3});
+  net.predict(vec_t{1, 2, 3, 4, 5, 6});
+
+  // the producers of the inputs wrote the concatenation in place
+  const tensor_t &cat = *cl.outputs()[0]->get_data();
+  EXPECT_EQ(&cat[0][0], &(*f1.outputs()[0]->get_data())[0][0]);
+  EXPECT_EQ(&cat[0][3], &(*f2.outputs()[0]->get_data())[0][0]);
+
+  const auto test_data = generate_gradient_check_data(6);
+  EXPECT_TRUE(net.gradient_check<mse>(test_data.first, test_data.second,
+                                      epsilon<float_t>(), GRAD_CHECK_ALL));
+}
+
 }  // namespace tiny_dnn
@@ -196,6 +196,51 @@ TEST(deconvolutional, fprop2) {
   }
 }
 
+#ifdef CNN_USE_AVX
+TEST(deconvolutional, fprop_gemm) {
+#define O true
+#define X false
+  static const bool connection[] = {O, X, O,
+                                    O, O, X};
+#undef O
+#undef X
+  const core::connection_table tbl(connection, 2, 3);
+  deconvolutional_layer l1(4, 3, 3, 2, 2, 3, tbl, padding::same, true, 2, 2);
+  deconvolutional_layer l2(4, 3, 3, 2, 2, 3, tbl, padding::same, true, 2, 2,
+                           core::backend_t::avx);
+  l1.setup(false);
+  l2.setup(false);
+  uniform_rand(l1.weights()[1]->begin(), l1.weights()[1]->end(), -1.0, 1.0);
+  *l2.weights()[0] = *l1.weights()[0];
+  *l2.weights()[1] = *l1.weights()[1];
+
+  tensor_t in(3, vec_t(4 * 3 * 2));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+  std::vector<const tensor_t *> o1, o2;
+
+  l1.forward({in}, o1);
+  l2.forward({in}, o2);
+  for (size_t s = 0; s < in.size(); s++) {
+    ASSERT_EQ((*o1[0])[s].size(), (*o2[0])[s].size());
+    for (size_t i = 0; i < (*o1[0])[s].size(); i++) {
+      EXPECT_NEAR((*o1[0])[s][i], (*o2[0])[s][i], 1e-5);
+    }
+  }
+}
+
+TEST(deconvolutional, gradient_check_gemm) {  // tanh - mse
+  network<sequential> nn;
+  nn << deconvolutional_layer(3, 2, 3, 2, 2, padding::valid, true, 2, 2,
+                              core::backend_t::avx)
+     << tanh_layer();
+
+  const auto test_data = generate_gradient_check_data(nn.in_data_size());
+  nn.init_weight();
+  EXPECT_TRUE(nn.gradient_check<mse>(test_data.first, test_data.second,
+                                     epsilon<float_t>(), GRAD_CHECK_ALL));
+}
+#endif  // CNN_USE_AVX
+
 /*
 TEST(deconvolutional, gradient_check) {  // tanh - mse
   network<sequential> nn;
@@ -44,6 +44,72 @@ TEST(dropout, randomized) {
   EXPECT_GE(num_units * dropout_rate / margin_factor, num_on2);
 }
 
+TEST(dropout, seeded) {
+  const size_t num_units = 1000;
+  tensor_t in(8, vec_t(num_units, 1.0));
+
+  auto masks = [&](unsigned int seed) {
+    set_random_seed(seed);
+    dropout_layer l(num_units, 0.5, net_phase::train);
+    std::vector<const tensor_t *> out;
+    std::vector<std::vector<uint8_t>> m;
+    for (int pass = 0; pass < 2; pass++) {
+      l.forward({in}, out);
+      for (size_t s = 0; s < in.size(); s++) m.push_back(l.get_mask(s));
+    }
+    return m;
+  };
+
+  const auto m1 = masks(7), m2 = masks(7), m3 = masks(8);
+  // same seed, same masks; every sample and every pass masked differently
+  EXPECT_EQ(m1, m2);
+  EXPECT_NE(m1, m3);
+  for (size_t i = 1; i < m1.size(); i++) {
+    EXPECT_TRUE(is_different_container(m1[0], m1[i]));
+  }
+}
+
+TEST(dropout, packed_mask) {
+  // not a multiple of the register or word size
+  const size_t num_units = 75;
+  dropout_layer l(num_units, 0.3, net_phase::train);
+  tensor_t in(3, vec_t(num_units)), delta(3, vec_t(num_units));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+  for (auto &v : delta) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+
+  std::vector<const tensor_t *> out;
+  l.forward({in}, out);
+  const auto grads = l.backward({delta});
+
+  const float_t scale = float_t(1) / (float_t(1) - float_t(0.3));
+  for (size_t s = 0; s < in.size(); s++) {
+    const auto mask = l.get_mask(s);
+    for (size_t i = 0; i < num_units; i++) {
+      EXPECT_FLOAT_EQ(mask[i] * scale * in[s][i], (*out[0])[s][i]);
+      EXPECT_FLOAT_EQ(mask[i] * scale * delta[s][i], grads[0][s][i]);
+    }
+  }
+}
+
+TEST(dropout, test_phase_pass_through) {
+  network<sequential> nn;
+  nn << fully_connected_layer(4, 10) << dropout_layer(10, 0.5);
+  nn.set_netphase(net_phase::test);
+
+  vec_t in        = {1.0, 2.0, -1.0, 0.5};
+  const vec_t out = nn.predict(in);
+
+  // no copy: the output of the dropout layer is the data of its input
+  const tensor_t *fc_out = nn[0]->outputs()[0]->get_data();
+  EXPECT_EQ(fc_out, nn[1]->outputs()[0]->get_data());
+  EXPECT_EQ((*fc_out)[0], out);
+
+  // back to training, the layer writes its own output again
+  nn.set_netphase(net_phase::train);
+  nn.predict(in);
+  EXPECT_NE(fc_out, nn[1]->outputs()[0]->get_data());
+}
+
 TEST(dropout, read_write) {
   dropout_layer l1(1024, 0.5, net_phase::test);
   dropout_layer l2(1024, 0.5, net_phase::test);
@@ -211,4 +211,38 @@ TEST(fully_connected, forward_nobias) {
   }
 }
 
+TEST(fully_connected, fake_quantization) {
+  fully_connected_layer l(4, 2);
+  l.weight_init(weight_init::constant(1.0));
+  l.bias_init(weight_init::constant(0.5));
+  l.enable_fake_quantization(float_t(0.5));
+  EXPECT_TRUE(l.fake_quantization());
+
+  vec_t in = {0, 1, 2, 3};
+  std::vector<const tensor_t *> o;
+  l.forward({{in}}, o);
+
+  // the first batch sets the ranges, zero included
+  EXPECT_FLOAT_EQ(0.0f, l.input_range().min);
+  EXPECT_FLOAT_EQ(3.0f, l.input_range().max);
+  EXPECT_NEAR(6.5f, l.output_range().max, 1e-3);
+  for (auto x : (*o[0])[0]) EXPECT_NEAR(6.5f, x, 6.5f / 255);
+
+  // moving average of the ranges in train phase, frozen in test phase
+  vec_t in2 = {0, 1, 2, 5};
+  l.forward({{in2}}, o);
+  EXPECT_FLOAT_EQ(4.0f, l.input_range().max);
+  l.set_context(net_phase::test);
+  l.forward({{in}}, o);
+  EXPECT_FLOAT_EQ(4.0f, l.input_range().max);
+
+  // straight-through: the gradient of the input is W^T dy, W rounded
+  auto grad = l.backward({{vec_t{1, 1}}});
+  for (auto g : grad[0][0]) EXPECT_NEAR(2.0f, g, 1e-3);
+
+  l.disable_fake_quantization();
+  l.forward({{in}}, o);
+  for (auto x : (*o[0])[0]) EXPECT_FLOAT_EQ(6.5f, x);
+}
+
 }  // namespace tiny_dnn
@@ -0,0 +1,190 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "test/testhelper.h"
+#include "tiny_dnn/tiny_dnn.h"
+
+namespace tiny_dnn {
+
+namespace {
+
+// runs the cell on one sample, h(t-1) and c(t-1) being set on the aux inputs
+void lstm_step(lstm_cell_layer &l,
+               const vec_t &x,
+               const vec_t &h,
+               const vec_t &c,
+               vec_t *h_out,
+               vec_t *c_out) {
+  *l.inputs()[1]->get_data() = tensor_t{h};
+  *l.inputs()[2]->get_data() = tensor_t{c};
+  std::vector<const tensor_t *> o;
+  l.forward({{x}}, o);
+  *h_out = (*o[0])[0];
+  *c_out = (*l.outputs()[1]->get_data())[0];
+}
+
+}  // namespace
+
+TEST(lstm_cell, forward) {
+  const size_t in_dim = 3, out_dim = 4;
+  lstm_cell_layer l(in_dim, out_dim);
+  l.setup(true);
+  const vec_t &W = *l.weights()[0];
+  vec_t &b       = *l.weights()[1];
+  uniform_rand(b.begin(), b.end(), -1.0, 1.0);
+
+  vec_t x(in_dim), h(out_dim), c(out_dim);
+  uniform_rand(x.begin(), x.end(), -1.0, 1.0);
+  uniform_rand(h.begin(), h.end(), -1.0, 1.0);
+  uniform_rand(c.begin(), c.end(), -1.0, 1.0);
+
+  vec_t h_out, c_out;
+  lstm_step(l, x, h, c, &h_out, &c_out);
+
+  auto sigmoid = [](float_t v) { return float_t(1) / (1 + std::exp(-v)); };
+  vec_t xh(x);
+  xh.insert(xh.end(), h.begin(), h.end());
+  for (size_t j = 0; j < out_dim; j++) {
+    float_t a[4];
+    for (size_t gate = 0; gate < 4; gate++) {
+      a[gate] = b[gate * out_dim + j];
+      for (size_t k = 0; k < xh.size(); k++) {
+        a[gate] += xh[k] * W[k * 4 * out_dim + gate * out_dim + j];
+      }
+    }
+    const float_t c_ref =
+      sigmoid(a[1]) * c[j] + sigmoid(a[0]) * std::tanh(a[2]);
+    const float_t h_ref = sigmoid(a[3]) * std::tanh(c_ref);
+
+    EXPECT_NEAR(c_ref, c_out[j], 1e-5);
+    EXPECT_NEAR(h_ref, h_out[j], 1e-5);
+  }
+}
+
+TEST(lstm_cell, gate_activations) {
+  // every alignment and tail length of the vectorized sigmoid and tanh
+  vec_t x(67), y(67);
+  for (size_t k = 0; k < x.size(); k++) {
+    x[k] = float_t(-30) + float_t(60) * k / (x.size() - 1);
+  }
+  x[33] = float_t(1e-4);
+  for (size_t first = 0; first < 8; first++) {
+    for (size_t n = 0; first + n <= x.size(); n += 7) {
+      vectorize::sigmoid(&x[first], n, &y[first]);
+      for (size_t k = first; k < first + n; k++) {
+        EXPECT_NEAR(float_t(1) / (1 + std::exp(-x[k])), y[k], 1e-6);
+      }
+      vectorize::tanh(&x[first], n, &y[first]);
+      for (size_t k = first; k < first + n; k++) {
+        EXPECT_NEAR(std::tanh(x[k]), y[k], 1e-6);
+      }
+    }
+  }
+}
+
+TEST(lstm_cell, gradient_check) {
+  network<sequential> nn;
+  nn << lstm_cell_layer(10, 6) << tanh_layer();
+
+  const auto test_data = generate_gradient_check_data(nn.in_data_size());
+  nn.init_weight();
+  EXPECT_TRUE(nn.gradient_check<mse>(test_data.first, test_data.second,
+                                     epsilon<float_t>(), GRAD_CHECK_ALL));
+}
+
+TEST(lstm_cell, state_gradients) {
+  const size_t in_dim = 3, out_dim = 2;
+  lstm_cell_layer l(in_dim, out_dim);
+  l.setup(true);
+
+  vec_t in[3] = {vec_t(in_dim), vec_t(out_dim), vec_t(out_dim)};
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+  // loss = dh . h(t) + dc . c(t)
+  vec_t dh(out_dim), dc(out_dim);
+  uniform_rand(dh.begin(), dh.end(), -1.0, 1.0);
+  uniform_rand(dc.begin(), dc.end(), -1.0, 1.0);
+
+  auto loss = [&]() {
+    vec_t h_out, c_out;
+    lstm_step(l, in[0], in[1], in[2], &h_out, &c_out);
+    float_t e = 0;
+    for (size_t j = 0; j < out_dim; j++) {
+      e += dh[j] * h_out[j] + dc[j] * c_out[j];
+    }
+    return e;
+  };
+
+  loss();
+  *l.outputs()[1]->get_gradient() = tensor_t{dc};
+  const auto grads = l.backward({{dh}});
+
+  const float_t delta = float_t(1e-3);
+  for (size_t n = 0; n < 3; n++) {
+    for (size_t k = 0; k < in[n].size(); k++) {
+      const float_t v = in[n][k];
+      in[n][k]        = v + delta;
+      const float_t p = loss();
+      in[n][k]        = v - delta;
+      const float_t m = loss();
+      in[n][k]        = v;
+      EXPECT_NEAR((p - m) / (2 * delta), grads[n][0][k], 1e-3);
+    }
+  }
+}
+
+TEST(lstm_cell, stream) {
+  const size_t in_dim = 3, out_dim = 2;
+  lstm_cell_layer ref(in_dim, out_dim);
+  network<sequential> nn;
+  nn << lstm_cell_layer(in_dim, out_dim);
+  nn.init_weight();
+  ref.setup(true);
+  auto w = ref.weights();
+  for (size_t i = 0; i < w.size(); i++) *w[i] = *nn[0]->weights()[i];
+
+  stream_state state = nn.create_stream_state();
+  ASSERT_EQ(state.size(), size_t(2));
+  vec_t h(out_dim, float_t{0}), c(out_dim, float_t{0});
+  for (size_t t = 0; t < 4; t++) {
+    vec_t x(in_dim);
+    uniform_rand(x.begin(), x.end(), -1.0, 1.0);
+
+    const vec_t y = nn.step(state, x);
+    lstm_step(ref, x, vec_t(h), vec_t(c), &h, &c);
+    for (size_t i = 0; i < out_dim; i++) {
+      EXPECT_NEAR(h[i], y[i], 1e-5);
+      EXPECT_NEAR(c[i], state[1][i], 1e-5);
+    }
+  }
+}
+
+TEST(lstm_cell, read_write) {
+  lstm_cell_layer l1(20, 10);
+  lstm_cell_layer l2(20, 10);
+
+  l1.setup(true);
+  l2.setup(true);
+
+  serialization_test(l1, l2);
+}
+
+TEST(lstm_cell, serialize_network) {
+  network<sequential> n1, n2;
+  n1 << lstm_cell_layer(5, 3) << tanh_layer();
+  n1.init_weight();
+
+  network_serialization_test(n1, n2);
+}
+
+}  // namespace tiny_dnn
@@ -11,6 +11,7 @@
 
 #include <functional>
 #include <memory>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -450,6 +451,45 @@ TEST(network, bias_init_per_layer) {
   for (size_t i = 0; i < w2.size(); i++) EXPECT_NEAR(w2[i], 1.0, 1e-10);
 }
 
+TEST(network, weight_init_seeded) {
+  auto init = [](size_t seed) {
+    set_random_seed(static_cast<unsigned int>(seed));
+    network<sequential> net;
+    net << fully_connected_layer(300, 1024) << tanh_layer()
+        << convolutional_layer(16, 16, 3, 4, 8);
+    net[2]->weight_init(weight_init::he());
+    net.init_weight();
+    return net;
+  };
+
+  auto a = init(3), b = init(3), c = init(4);
+  for (size_t l = 0; l < a.depth(); l++) {
+    auto wa = a[l]->weights(), wb = b[l]->weights(), wc = c[l]->weights();
+    for (size_t i = 0; i < wa.size(); i++) {
+      EXPECT_EQ(*wa[i], *wb[i]);
+      if (i == 0 && l != 1) {
+        EXPECT_NE(*wa[i], *wc[i]);  // the biases are all zero
+      }
+    }
+  }
+
+  // xavier is uniform in +-sqrt(6 / (fan_in + fan_out)), he is gaussian
+  const vec_t &u = *a[0]->weights()[0];
+  const float_t base = std::sqrt(float_t(6) / (300 + 1024));
+  float_t mean = 0;
+  for (auto w : u) {
+    EXPECT_LE(std::abs(w), base);
+    mean += w / u.size();
+  }
+  EXPECT_NEAR(mean, 0, base * 0.01);
+
+  const vec_t &g = *a[2]->weights()[0];
+  const float_t sigma = std::sqrt(float_t(2) / (4 * 3 * 3));
+  float_t var = 0;
+  for (auto w : g) var += w * w / g.size();
+  EXPECT_NEAR(std::sqrt(var), sigma, sigma * 0.1);
+}
+
 TEST(network, gradient_check) {  // sigmoid - cross-entropy
   using loss_func  = cross_entropy;
   using activation = sigmoid;
@@ -714,4 +754,268 @@ TEST(network, trainable) {
   EXPECT_NE(w4, w4_after_update);
 }
 
+TEST(network, checkpoints) {
+  network<sequential> nn;
+  nn << fully_connected_layer(6, 8) << tanh_layer()
+     << fully_connected_layer(8, 8) << tanh_layer()
+     << fully_connected_layer(8, 8) << tanh_layer()
+     << fully_connected_layer(8, 3);
+
+  // 7 layers, a checkpoint every round(sqrt(7)) = 3 of them
+  EXPECT_EQ(std::vector<size_t>({2, 5}), nn.set_checkpoints_sqrt());
+
+  const auto test_data = generate_gradient_check_data(nn.in_data_size());
+  nn.init_weight();
+  EXPECT_TRUE(nn.gradient_check<mse>(test_data.first, test_data.second,
+                                     epsilon<float_t>(), GRAD_CHECK_ALL));
+
+  // only the checkpoints and the output keep their activations
+  for (size_t l = 0; l < nn.depth(); l++) {
+    const bool kept = l == 2 || l == 5 || l == 6;
+    EXPECT_EQ(kept, !nn[l]->outputs()[0]->get_data()->empty());
+  }
+}
+
+TEST(network, checkpoints_train) {
+  // relu runs in place and dropout can't be run twice, same weights anyway
+  auto train = [](bool checkpoints) {
+    set_random_seed(3);
+    network<sequential> nn;
+    nn << fully_connected_layer(4, 10) << relu()
+       << fully_connected_layer(10, 10) << relu() << dropout_layer(10, 0.3)
+       << fully_connected_layer(10, 2) << sigmoid();
+    nn.init_weight();
+    if (checkpoints) nn.set_checkpoints({1, 4});
+
+    std::vector<vec_t> in(20, vec_t(4)), t(20, vec_t(2));
+    for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+    for (auto &v : t) uniform_rand(v.begin(), v.end(), 0.0, 1.0);
+    gradient_descent opt;
+    nn.train<mse>(opt, in, t, 5, 3);
+    return *nn[5]->weights()[0];
+  };
+
+  const vec_t expected = train(false);
+  const vec_t w        = train(true);
+  for (size_t i = 0; i < w.size(); i++) EXPECT_FLOAT_EQ(expected[i], w[i]);
+}
+
+TEST(network, checkpoints_graph) {
+  // sorted as in, fc2, e2, fc1, e1, add, out: e2 runs in place over the
+  // checkpoint, fc1 and e1 are computed again, the input is read by both
+  // segments
+  input_layer in(shape3d(4, 1, 1));
+  fully_connected_layer fc1(4, 6), fc2(4, 6);
+  elu_layer e1(6), e2(6);
+  elementwise_add_layer add(2, 6);
+  fully_connected_layer out(6, 3);
+
+  in << fc1 << e1;
+  in << fc2 << e2;
+  (e1, e2) << add << out;
+
+  network<graph> net;
+  construct_graph(net, {&in}, {&out});
+  net.set_checkpoints({1});
+
+  const auto test_data = generate_gradient_check_data(net.in_data_size());
+  net.init_weight();
+  EXPECT_TRUE(net.gradient_check<mse>(test_data.first, test_data.second,
+                                      epsilon<float_t>(), GRAD_CHECK_ALL));
+  EXPECT_EQ(&fc2, net[1]);
+  EXPECT_TRUE(e1.outputs()[0]->get_data()->empty());
+  EXPECT_FALSE(e2.outputs()[0]->get_data()->empty());
+}
+
+TEST(network, predict_batch) {
+  // the output of softmax is written in place, that of relu (running over
+  // the output of fc) is copied
+  for (bool in_place_output : {false, true}) {
+    network<sequential> nn;
+    nn << fully_connected_layer(5, 8) << tanh_layer()
+       << fully_connected_layer(8, 4);
+    if (in_place_output) {
+      nn << relu();
+    } else {
+      nn << softmax();
+    }
+    nn.init_weight();
+    nn.set_netphase(net_phase::test);
+
+    const size_t batch = 3;
+    vec_t in(batch * 5);
+    uniform_rand(in.begin(), in.end(), -1.0, 1.0);
+    const vec_t in_copy = in;
+    std::vector<tensor_t> samples;
+    for (size_t s = 0; s < batch; s++) {
+      samples.push_back({vec_t(in.begin() + s * 5, in.begin() + s * 5 + 5)});
+    }
+    const std::vector<tensor_t> expected = nn.predict(samples);
+
+    for (int pass = 0; pass < 2; pass++) {
+      vec_t out(batch * 4);
+      nn.predict(&in[0], batch, &out[0]);
+      for (size_t s = 0; s < batch; s++) {
+        for (size_t i = 0; i < 4; i++) {
+          EXPECT_FLOAT_EQ(expected[s][0][i], out[s * 4 + i]);
+        }
+      }
+      EXPECT_EQ(size_t(0), nn.forward_allocations());
+    }
+    EXPECT_EQ(in_copy, in);
+
+    // back to the edges' own buffers
+    EXPECT_EQ(expected, nn.predict(samples));
+  }
+}
+
+// a fully-connected layer whose forward pass can be made to throw
+class failing_fc_layer : public fully_connected_layer {
+ public:
+  failing_fc_layer(size_t in_dim, size_t out_dim)
+    : fully_connected_layer(in_dim, out_dim), fail(false) {}
+
+  void forward_propagation(const std::vector<tensor_t *> &in_data,
+                           std::vector<tensor_t *> &out_data) override {
+    if (fail) throw nn_error("failing layer");
+    fully_connected_layer::forward_propagation(in_data, out_data);
+  }
+
+  bool fail;
+};
+
+TEST(network, predict_batch_throws) {
+  network<sequential> nn;
+  nn << fully_connected_layer(5, 8) << tanh_layer()
+     << failing_fc_layer(8, 4);
+  nn.init_weight();
+  nn.set_netphase(net_phase::test);
+
+  const size_t batch = 3;
+  std::vector<tensor_t> samples;
+  for (size_t s = 0; s < batch; s++) {
+    vec_t v(5);
+    uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+    samples.push_back({v});
+  }
+  const std::vector<tensor_t> expected = nn.predict(samples);
+
+  vec_t in(batch * 5), out(batch * 4);
+  nn.at<failing_fc_layer>(2).fail = true;
+  EXPECT_THROW(nn.predict(&in[0], batch, &out[0]), nn_error);
+  nn.at<failing_fc_layer>(2).fail = false;
+
+  // the network doesn't read or write the buffers of the failed call
+  std::fill(in.begin(), in.end(), float_t(7));
+  std::fill(out.begin(), out.end(), float_t(7));
+  EXPECT_EQ(expected, nn.predict(samples));
+  EXPECT_EQ(vec_t(batch * 5, float_t(7)), in);
+  EXPECT_EQ(vec_t(batch * 4, float_t(7)), out);
+}
+
+TEST(network, sessions) {
+  network<sequential> nn;
+  nn << convolutional_layer(6, 6, 3, 1, 2) << relu()
+     << batch_normalization_layer(16, 2) << fully_connected_layer(32, 3);
+  nn.init_weight();
+  nn.set_netphase(net_phase::test);
+
+  std::vector<vec_t> in(4, vec_t(36));
+  std::vector<vec_t> expected;
+  for (auto &v : in) {
+    uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+    expected.push_back(nn.predict(v));
+  }
+
+  // one set of weights, read by every session
+  std::vector<network<sequential>> sessions;
+  for (size_t t = 0; t < 4; t++) sessions.push_back(nn.session());
+  for (auto &s : sessions) {
+    EXPECT_EQ(nn[0]->weights()[0], s[0]->weights()[0]);
+    EXPECT_EQ(nn[3]->weights()[1], s[3]->weights()[1]);
+    EXPECT_NE(nn[0]->outputs()[0], s[0]->outputs()[0]);
+  }
+
+  // each session on its own thread, with a batch size of its own
+  std::vector<std::vector<tensor_t>> out(sessions.size());
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < sessions.size(); t++) {
+    threads.emplace_back([&, t] {
+      std::vector<tensor_t> batch;
+      for (size_t s = 0; s <= t; s++) batch.push_back({in[s]});
+      for (int pass = 0; pass < 20; pass++) {
+        out[t] = sessions[t].predict(batch);
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+
+  for (size_t t = 0; t < sessions.size(); t++) {
+    ASSERT_EQ(t + 1, out[t].size());
+    for (size_t s = 0; s < out[t].size(); s++) {
+      for (size_t i = 0; i < 3; i++) {
+        EXPECT_FLOAT_EQ(expected[s][i], out[t][s][0][i]);
+      }
+    }
+  }
+}
+
+TEST(network, parallel_branches) {
+  // three towers over the input, concatenated: one runs in place, and the
+  // input is read by all of them
+  struct towers {
+    towers()
+      : in(shape3d(4, 1, 1)),
+        a(4, 3),
+        b1(4, 5),
+        b2(5, 2),
+        c(4, 2),
+        e(2),
+        cat({shape3d(1, 1, 3), shape3d(1, 1, 2), shape3d(1, 1, 2)}),
+        out(7, 3) {
+      in << a;
+      in << b1 << b2 << e;
+      in << c;
+      (a, e, c) << cat << out;
+    }
+
+    input_layer in;
+    fully_connected_layer a, b1, b2, c;
+    elu_layer e;
+    concat_layer cat;
+    fully_connected_layer out;
+  };
+
+  auto train = [](bool parallel) {
+    set_random_seed(5);
+    towers t;
+    network<graph> net;
+    construct_graph(net, {&t.in}, {&t.out});
+    net.set_parallel_branches(parallel);
+    EXPECT_EQ(parallel, net.parallel_branches());
+
+    std::vector<vec_t> in(16, vec_t(4)), target(16, vec_t(3));
+    for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+    for (auto &v : target) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+    gradient_descent opt;
+    net.train<mse>(opt, in, target, 4, 3);
+
+    std::vector<vec_t> result = {*t.a.weights()[0], *t.b1.weights()[0],
+                                 *t.out.weights()[0]};
+    for (size_t i = 0; i < 4; i++) result.push_back(net.predict(in[i]));
+    return result;
+  };
+
+  // the same weights and outputs as one layer at a time
+  const std::vector<vec_t> expected = train(false);
+  const std::vector<vec_t> actual   = train(true);
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(expected[i].size(), actual[i].size());
+    for (size_t j = 0; j < expected[i].size(); j++) {
+      EXPECT_FLOAT_EQ(expected[i][j], actual[i][j]);
+    }
+  }
+}
+
 }  // namespace tiny_dnn
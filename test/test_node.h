@@ -170,4 +170,46 @@ TEST(layer_tuple, chain_operator_layer_tuple2) {
   EXPECT_EQ(slice->next_nodes()[1], relu.get());
   EXPECT_EQ(slice->next_nodes()[2], elu.get());
 }
+TEST(edge, contiguous_batch) {
+  edge e(nullptr, shape3d(3, 2, 2), vector_type::data);
+  e.set_sample_count(5, true);
+
+  // one NCHW block, the samples being views of it
+  tensor_t &data = *e.get_data();
+  ASSERT_EQ(size_t(5), data.size());
+  const float_t *block = contiguous_data(data);
+  ASSERT_NE(nullptr, block);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(block) % 64);
+  EXPECT_NE(nullptr, contiguous_data(*e.get_gradient()));
+  for (size_t s = 0; s < data.size(); s++) {
+    std::fill(data[s].begin(), data[s].end(), float_t(s));
+  }
+
+  // a smaller batch reuses the block
+  e.set_sample_count(2, true);
+  EXPECT_EQ(block, contiguous_data(*e.get_data()));
+
+  // a larger one keeps the values of the samples
+  e.set_sample_count(9, true);
+  const tensor_t &grown = *e.get_data();
+  ASSERT_NE(nullptr, contiguous_data(grown));
+  EXPECT_FLOAT_EQ(float_t(1), grown[1][11]);
+  EXPECT_FLOAT_EQ(float_t(0), grown[8][0]);
+
+  // rows replaced from outside are moved back into the block
+  e.get_data()->push_back(vec_t(12, float_t(7)));
+  const tensor_t &pushed = *e.get_data();
+  ASSERT_NE(nullptr, contiguous_data(pushed));
+  EXPECT_FLOAT_EQ(float_t(7), pushed[9][5]);
+}
+
+TEST(edge, contiguous_copy_owns) {
+  edge e(nullptr, shape3d(4, 1, 1), vector_type::data);
+  e.set_sample_count(2, true);
+  vec_t copy = (*e.get_data())[1];
+  copy[0]    = float_t(3);
+  EXPECT_FLOAT_EQ(float_t(0), (*e.get_data())[1][0]);
+  EXPECT_NE(copy.data(), (*e.get_data())[1].data());
+}
+
 }  // namespace tiny_dnn
@@ -9,6 +9,7 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <memory>
 
 #include "test/testhelper.h"
@@ -85,4 +86,159 @@ TEST(nodes, graph_branch2) {
   EXPECT_FLOAT_EQ(static_cast<float_t>(res[2]), static_cast<float_t>(0.0));
 }
 
+TEST(nodes, memory_plan_sequential) {
+  network<sequential> net;
+  net << fully_connected_layer(8, 16) << relu() << fully_connected_layer(16, 32)
+      << tanh_layer() << fully_connected_layer(32, 16) << sigmoid()
+      << fully_connected_layer(16, 4);
+  net.init_weight();
+
+  std::vector<tensor_t> in(3, tensor_t(1, vec_t(8)));
+  for (auto &t : in) uniform_rand(t[0].begin(), t[0].end(), -1.0, 1.0);
+  net.set_netphase(net_phase::test);
+  const auto expected = net.predict(in);
+
+  // 8 + 16 + 16 + 32 + 32 + 16 + 16 + 4 floats, of which the first and the
+  // last are pinned and the others alternate between two slots
+  const memory_plan plan = net.plan_memory();
+  EXPECT_EQ(size_t(2), plan.slots);
+  EXPECT_EQ(140 * sizeof(float_t), plan.naive_bytes);
+  EXPECT_EQ((8 + 32 + 32 + 4) * sizeof(float_t), plan.planned_bytes);
+
+  const auto planned = net.predict(in);
+  for (size_t s = 0; s < in.size(); s++) {
+    for (size_t i = 0; i < planned[s][0].size(); i++) {
+      EXPECT_FLOAT_EQ(expected[s][0][i], planned[s][0][i]);
+    }
+  }
+  // relu runs in place, then neighbours never share a buffer, layers two
+  // apart do
+  const float_t *out0 = &(*net[0]->outputs()[0]->get_data())[0][0];
+  const float_t *out1 = &(*net[1]->outputs()[0]->get_data())[0][0];
+  const float_t *out2 = &(*net[2]->outputs()[0]->get_data())[0][0];
+  const float_t *out3 = &(*net[3]->outputs()[0]->get_data())[0][0];
+  EXPECT_EQ(out0, out1);
+  EXPECT_NE(out1, out2);
+  EXPECT_EQ(out1, out3);
+
+  // training gives every layer its own buffer again
+  net.set_netphase(net_phase::train);
+  EXPECT_NE(&(*net[2]->outputs()[0]->get_data())[0][0],
+            &(*net[0]->outputs()[0]->get_data())[0][0]);
+}
+
+TEST(nodes, memory_plan_graph) {
+  // r1 is read again by the addition, its buffer is live across the branch
+  input_layer in(shape3d(4, 1, 1));
+  fully_connected_layer fc1(4, 6), fc2(6, 6);
+  relu_layer r1(6), r2(6);
+  elementwise_add_layer add(2, 6);
+  fully_connected_layer out(6, 3);
+
+  in << fc1 << r1 << fc2 << r2;
+  (r1, r2) << add << out;
+
+  network<graph> net;
+  construct_graph(net, {&in}, {&out});
+  net.set_netphase(net_phase::test);
+
+  const vec_t x          = {1, -2, 3, 0.5};
+  const vec_t expected   = net.predict(x);
+  const memory_plan plan = net.plan_memory();
+  EXPECT_LT(plan.planned_bytes, plan.naive_bytes);
+
+  const vec_t planned = net.predict(x);
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_FLOAT_EQ(expected[i], planned[i]);
+  }
+}
+
+TEST(nodes, in_place_layers) {
+  network<sequential> net;
+  net << fully_connected_layer(4, 6) << power_layer(shape3d(6, 1, 1), 2.0)
+      << fully_connected_layer(6, 6) << relu() << fully_connected_layer(6, 2);
+  net.init_weight();
+  auto data = [&](size_t l) { return net[l]->outputs()[0]->get_data(); };
+
+  // in training, power needs its input again, relu doesn't
+  const vec_t in       = {0.5, -1, 2, 0};
+  const vec_t expected = net.predict(in);
+  EXPECT_NE(data(0), data(1));
+  EXPECT_EQ(data(2), data(3));
+
+  net.set_netphase(net_phase::test);
+  const vec_t out = net.predict(in);
+  EXPECT_EQ(data(0), data(1));
+  EXPECT_EQ(data(2), data(3));
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_FLOAT_EQ(expected[i], out[i]);
+  }
+
+  // elu writes over the output of fc, gradients are kept apart
+  network<sequential> smooth;
+  smooth << fully_connected_layer(4, 6) << elu() << fully_connected_layer(6, 2);
+  const auto test_data = generate_gradient_check_data(smooth.in_data_size());
+  smooth.init_weight();
+  EXPECT_TRUE(smooth.gradient_check<mse>(test_data.first, test_data.second,
+                                         epsilon<float_t>(), GRAD_CHECK_ALL));
+  EXPECT_EQ(smooth[0]->outputs()[0]->get_data(),
+            smooth[1]->outputs()[0]->get_data());
+}
+
+TEST(nodes, in_place_fan_out) {
+  // fc1 is read by r1 and by the addition, so r1 needs its own output; the
+  // addition accumulates into the output of r1
+  input_layer in(shape3d(4, 1, 1));
+  fully_connected_layer fc1(4, 6);
+  relu_layer r1(6);
+  elementwise_add_layer add(2, 6);
+
+  in << fc1 << r1;
+  (r1, fc1) << add;
+
+  network<graph> net;
+  construct_graph(net, {&in}, {&add});
+  net.set_netphase(net_phase::test);
+
+  const vec_t out = net.predict(vec_t{1, -2, 3, 0.5});
+  const vec_t &fc = (*fc1.outputs()[0]->get_data())[0];
+  const auto *sum = add.outputs()[0]->get_data();
+  EXPECT_NE(fc1.outputs()[0]->get_data(), r1.outputs()[0]->get_data());
+  EXPECT_EQ(r1.outputs()[0]->get_data(), sum);
+  for (size_t i = 0; i < fc.size(); i++) {
+    EXPECT_FLOAT_EQ(std::max(fc[i], float_t(0)) + fc[i], out[i]);
+  }
+}
+
+TEST(nodes, inference_without_gradients) {
+  network<sequential> net;
+  net << fully_connected_layer(4, 8) << relu() << fully_connected_layer(8, 2);
+  net.init_weight();
+
+  const vec_t in       = {0.5, -1, 2, 0};
+  const vec_t expected = net.predict(in);
+  net.set_netphase(net_phase::test);
+  const vec_t out = net.predict(std::vector<tensor_t>(3, tensor_t{in}))[2][0];
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_FLOAT_EQ(expected[i], out[i]);
+  }
+
+  // neither allocated nor cleared; the weights keep theirs
+  for (size_t l = 0; l < net.depth(); l++) {
+    EXPECT_EQ(size_t(3), net[l]->outputs()[0]->get_data()->size());
+    EXPECT_FALSE(net[l]->outputs()[0]->gradient_enabled());
+  }
+  EXPECT_TRUE(net[0]->inputs()[1]->gradient_enabled());
+
+  // still available on demand, e.g. for a saliency map
+  const tensor_t &g = *net[2]->outputs()[0]->get_gradient();
+  EXPECT_EQ(size_t(3), g.size());
+
+  // and kept again for training
+  net.set_netphase(net_phase::train);
+  net.predict(in);
+  EXPECT_TRUE(net[1]->outputs()[0]->gradient_enabled());
+  EXPECT_EQ(size_t(1), net[1]->outputs()[0]->get_gradient()->size());
+}
+
 }  // namespace tiny_dnn
@@ -9,7 +9,10 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdio>
 #include <limits>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "test/testhelper.h"
@@ -283,4 +286,440 @@ TEST(quantization_utils, quantize_down_and_shrink_range) {
   EXPECT_NEAR(1.0f, output_max, 1E-5);
 }
 
+TEST(quantization_calibration, min_max_range) {
+  network<sequential> net;
+  net << fully_connected_layer(4, 3) << relu_layer(3);
+  net.init_weight();
+
+  std::vector<vec_t> data = {{0.5f, 1.0f, 2.0f, 0.25f},
+                             {1.5f, 0.75f, 3.0f, 1.0f}};
+  auto ranges = calibrate_quantization_ranges(net, data);
+
+  ASSERT_EQ(net.depth() + 1, ranges.size());
+  // zero is always part of the range
+  EXPECT_FLOAT_EQ(0.0f, ranges[0].min);
+  EXPECT_FLOAT_EQ(3.0f, ranges[0].max);
+  EXPECT_FLOAT_EQ(0.0f, ranges[2].min);
+  EXPECT_GE(ranges[2].max, ranges[1].max);
+}
+
+TEST(quantization_calibration, histogram_clips_outliers) {
+  tensor_t t(1);
+  for (int i = 0; i < 10000; i++) t[0].push_back(float_t(i % 100) / 100);
+  t[0].push_back(float_t(100));
+
+  activation_histogram h;
+  h.observe(t);
+  h.start_histogram(2048);
+  h.observe(t);
+
+  calibration_params params;
+  EXPECT_FLOAT_EQ(100.0f, h.range(params).max);
+
+  params.method     = calibration_method::percentile;
+  params.percentile = 99.9f;
+  EXPECT_LT(h.range(params).max, 2.0f);
+  EXPECT_GT(h.range(params).max, 0.9f);
+
+  // the threshold can't go below 255 of the 2048 bins over [0, 100]
+  params.method = calibration_method::kl_divergence;
+  EXPECT_LT(h.range(params).max, 15.0f);
+  EXPECT_GT(h.range(params).max, 0.9f);
+  EXPECT_FLOAT_EQ(0.0f, h.range(params).min);
+}
+
+TEST(quantization_calibration, quantize_network) {
+  network<sequential> net;
+  net << convolutional_layer(6, 6, 3, 2, 3, padding::valid)
+      << relu_layer(4, 4, 3) << fully_connected_layer(48, 5);
+  net.init_weight();
+
+  std::vector<vec_t> data(16, vec_t(72));
+  for (auto &v : data) uniform_rand(v.begin(), v.end(), -1.0f, 1.0f);
+
+  for (auto method : {calibration_method::min_max,
+                      calibration_method::percentile,
+                      calibration_method::kl_divergence}) {
+    calibration_params params;
+    params.method            = method;
+    network<sequential> qnet = quantize_network(net, data, params);
+
+    ASSERT_EQ(net.depth(), qnet.depth());
+    EXPECT_EQ("q_conv", qnet[0]->layer_type());
+    EXPECT_EQ("relu-activation", qnet[1]->layer_type());
+    EXPECT_EQ("q_fully-connected", qnet[2]->layer_type());
+    EXPECT_TRUE(
+      qnet.at<quantized_convolutional_layer>(0).input_range().is_static());
+    EXPECT_TRUE(
+      qnet.at<quantized_fully_connected_layer>(2).output_range().is_static());
+
+    // a handful of samples is too few for a meaningful entropy calibration
+    if (method == calibration_method::kl_divergence) continue;
+    for (size_t i = 0; i < data.size(); i++) {
+      vec_t expected = net.predict(data[i]);
+      vec_t actual   = qnet.predict(data[i]);
+      for (size_t j = 0; j < expected.size(); j++) {
+        EXPECT_NEAR(expected[j], actual[j], 0.1f);
+      }
+    }
+  }
+}
+
+TEST(quantization_calibration, save_load) {
+  network<sequential> net;
+  net << convolutional_layer(6, 6, 3, 2, 3, padding::valid)
+      << relu_layer(4, 4, 3) << fully_connected_layer(48, 5);
+  net.init_weight();
+
+  std::vector<vec_t> data(16, vec_t(72));
+  for (auto &v : data) uniform_rand(v.begin(), v.end(), -1.0f, 1.0f);
+  network<sequential> qnet = quantize_network(net, data);
+  const auto &conv         = qnet.at<quantized_convolutional_layer>(0);
+  const auto &fc           = qnet.at<quantized_fully_connected_layer>(2);
+
+  // inputs beyond the calibration data, which a range computed from the
+  // input would follow
+  std::vector<vec_t> in(4, vec_t(72));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -3.0f, 3.0f);
+
+  for (auto format : {file_format::binary, file_format::json}) {
+    const std::string path = unique_path();
+    qnet.save(path, content_type::weights_and_model, format);
+    network<sequential> loaded;
+    loaded.load(path, content_type::weights_and_model, format);
+    std::remove(path.c_str());
+
+    const auto &lconv = loaded.at<quantized_convolutional_layer>(0);
+    const auto &lfc   = loaded.at<quantized_fully_connected_layer>(2);
+    EXPECT_FLOAT_EQ(conv.input_range().min, lconv.input_range().min);
+    EXPECT_FLOAT_EQ(conv.input_range().max, lconv.input_range().max);
+    EXPECT_FLOAT_EQ(conv.output_range().max, lconv.output_range().max);
+    EXPECT_FLOAT_EQ(fc.input_range().max, lfc.input_range().max);
+    EXPECT_FLOAT_EQ(fc.output_range().min, lfc.output_range().min);
+
+    for (const auto &v : in) {
+      vec_t expected = qnet.predict(v);
+      vec_t actual   = loaded.predict(v);
+      for (size_t j = 0; j < expected.size(); j++) {
+        EXPECT_FLOAT_EQ(expected[j], actual[j]);
+      }
+    }
+  }
+}
+
+TEST(quantization_calibration, int8_activations) {
+  network<sequential> net;
+  net << convolutional_layer(6, 6, 3, 2, 3, padding::same)
+      << relu_layer(6, 6, 3) << max_pooling_layer(6, 6, 3, 2)
+      << fully_connected_layer(27, 10) << relu_layer(10)
+      << fully_connected_layer(10, 5) << softmax_layer(5);
+  net.init_weight();
+
+  std::vector<vec_t> data(16, vec_t(72));
+  for (auto &v : data) uniform_rand(v.begin(), v.end(), -1.0f, 1.0f);
+
+  calibration_params params;
+  network<sequential> qnet = quantize_network(net, data, params);
+  params.int8_activations  = true;
+  network<sequential> inet = quantize_network(net, data, params);
+
+  // both relu are folded into the layer in front of them, the codes are
+  // dequantized in front of softmax
+  ASSERT_EQ(6u, inet.depth());
+  EXPECT_EQ("q_conv", inet[0]->layer_type());
+  EXPECT_EQ("max-pool", inet[1]->layer_type());
+  EXPECT_EQ("q_fully-connected", inet[2]->layer_type());
+  EXPECT_EQ("q_fully-connected", inet[3]->layer_type());
+  EXPECT_EQ("dequantize", inet[4]->layer_type());
+  EXPECT_EQ("softmax-activation", inet[5]->layer_type());
+
+  const auto &conv = inet.at<quantized_convolutional_layer>(0);
+  EXPECT_FALSE(conv.int8_input());
+  EXPECT_TRUE(conv.int8_output());
+  EXPECT_FLOAT_EQ(0.0f, conv.output_range().min);
+  EXPECT_TRUE(inet.at<quantized_fully_connected_layer>(2).int8_input());
+  EXPECT_TRUE(inet.at<quantized_fully_connected_layer>(3).int8_output());
+
+  for (size_t i = 0; i < data.size(); i++) {
+    vec_t expected = net.predict(data[i]);
+    vec_t actual   = inet.predict(data[i]);
+    vec_t float_io = qnet.predict(data[i]);
+    for (size_t j = 0; j < expected.size(); j++) {
+      EXPECT_NEAR(expected[j], actual[j], 0.1f);
+      EXPECT_NEAR(float_io[j], actual[j], 0.1f);
+    }
+  }
+}
+
+TEST(quantization_int8, quantize_dequantize) {
+  core::quantization_range range;
+  range.min = -1.0f;
+  range.max = 1.0f;
+
+  quantize_layer q(shape3d(4, 1, 1), range);
+  dequantize_layer dq(shape3d(4, 1, 1), range);
+
+  vec_t in = {-1.0f, -0.25f, 0.0f, 1.0f};
+  std::vector<const tensor_t *> codes, out;
+  q.forward({{in}}, codes);
+  EXPECT_FLOAT_EQ(0.0f, (*codes[0])[0][0]);
+  EXPECT_FLOAT_EQ(255.0f, (*codes[0])[0][3]);
+  EXPECT_FLOAT_EQ(float_t(core::kernels::quantized_zero(range)),
+                  (*codes[0])[0][2]);
+
+  dq.forward({*codes[0]}, out);
+  for (size_t i = 0; i < in.size(); i++) {
+    EXPECT_NEAR(in[i], (*out[0])[0][i], 1.0f / 255);
+  }
+}
+
+TEST(quantization_int8, relu) {
+  core::quantization_range range;
+  range.min = -1.0f;
+  range.max = 3.0f;
+
+  quantized_relu_layer relu(shape3d(3, 1, 1), range);
+  const float_t zero = core::kernels::quantized_zero(range);
+
+  vec_t in = {0.0f, zero + 1, zero - 1};
+  std::vector<const tensor_t *> out;
+  relu.forward({{in}}, out);
+  EXPECT_FLOAT_EQ(zero, (*out[0])[0][0]);
+  EXPECT_FLOAT_EQ(zero + 1, (*out[0])[0][1]);
+  EXPECT_FLOAT_EQ(zero, (*out[0])[0][2]);
+
+  auto grad = relu.backward({{vec_t(3, 1.0f)}});
+  EXPECT_FLOAT_EQ(0.0f, grad[0][0][0]);
+  EXPECT_FLOAT_EQ(1.0f, grad[0][0][1]);
+  EXPECT_FLOAT_EQ(0.0f, grad[0][0][2]);
+}
+
+TEST(quantization_int8, concat) {
+  core::quantization_range a, b, out_range;
+  a.max         = 1.0f;
+  b.min         = -2.0f;
+  b.max         = 2.0f;
+  out_range.min = -2.0f;
+  out_range.max = 2.0f;
+
+  quantized_concat_layer concat({shape3d(1, 1, 2), shape3d(1, 1, 1)}, {a, b},
+                                out_range);
+  EXPECT_EQ(shape3d(1, 1, 3), concat.out_shape()[0]);
+
+  tensor_t in_a = {{0.0f, 255.0f}}, in_b = {{128.0f}};
+  std::vector<const tensor_t *> out_ptr;
+  concat.forward({in_a, in_b}, out_ptr);
+  const tensor_t &out = *out_ptr[0];
+
+  auto to_float = [&](float_t code) {
+    return core::kernels::quantized_to_float<uint8_t>(
+      static_cast<uint8_t>(code), out_range.min, out_range.max);
+  };
+  // within two levels of the output range
+  EXPECT_NEAR(0.0f, to_float(out[0][0]), 8.0f / 255);
+  EXPECT_NEAR(1.0f, to_float(out[0][1]), 8.0f / 255);
+  EXPECT_NEAR(0.0f, to_float(out[0][2]), 8.0f / 255);
+}
+
+TEST(quantization_int8, save_load) {
+  // max pooling between the convolution and the relu keeps the relu apart
+  network<sequential> net;
+  net << convolutional_layer(6, 6, 3, 2, 3, padding::same)
+      << max_pooling_layer(6, 6, 3, 2) << relu_layer(3, 3, 3)
+      << fully_connected_layer(27, 10) << tanh_layer(10)
+      << fully_connected_layer(10, 5);
+  net.init_weight();
+
+  std::vector<vec_t> data(16, vec_t(72));
+  for (auto &v : data) uniform_rand(v.begin(), v.end(), -1.0f, 1.0f);
+  calibration_params params;
+  params.int8_activations  = true;
+  network<sequential> inet = quantize_network(net, data, params);
+  ASSERT_EQ(8u, inet.depth());
+  EXPECT_EQ("q_relu", inet[2]->layer_type());
+  EXPECT_EQ("dequantize", inet[4]->layer_type());
+
+  for (auto format : {file_format::binary, file_format::json}) {
+    const std::string path = unique_path();
+    inet.save(path, content_type::weights_and_model, format);
+    network<sequential> loaded;
+    loaded.load(path, content_type::weights_and_model, format);
+    std::remove(path.c_str());
+
+    ASSERT_EQ(inet.depth(), loaded.depth());
+    for (size_t i = 0; i < inet.depth(); i++) {
+      EXPECT_EQ(inet[i]->layer_type(), loaded[i]->layer_type());
+    }
+    EXPECT_TRUE(loaded.at<quantized_convolutional_layer>(0).int8_output());
+    EXPECT_TRUE(loaded.at<quantized_fully_connected_layer>(3).int8_input());
+    EXPECT_TRUE(loaded.at<quantized_fully_connected_layer>(6).int8_output());
+
+    for (const auto &v : data) {
+      vec_t expected = inet.predict(v);
+      vec_t actual   = loaded.predict(v);
+      for (size_t j = 0; j < expected.size(); j++) {
+        EXPECT_FLOAT_EQ(expected[j], actual[j]);
+      }
+    }
+  }
+
+  // the layers quantize_network doesn't make
+  core::quantization_range a, b;
+  a.max = 1.0f;
+  b.min = -2.0f;
+  b.max = 2.0f;
+  quantize_layer q(shape3d(2, 1, 1), b);
+  quantized_concat_layer concat({shape3d(1, 1, 2), shape3d(1, 1, 1)}, {a, b},
+                                b);
+  auto q2      = json_to_layer(layer_to_json(q));
+  auto concat2 = json_to_layer(layer_to_json(concat));
+  EXPECT_EQ("quantize", q2->layer_type());
+  EXPECT_EQ(concat.in_shape(), concat2->in_shape());
+
+  tensor_t in = {{-1.5f, 0.5f}}, in_a = {{0.0f, 255.0f}}, in_b = {{128.0f}};
+  std::vector<const tensor_t *> expected, actual;
+  q.forward({in}, expected);
+  q2->forward({in}, actual);
+  EXPECT_EQ((*expected[0])[0], (*actual[0])[0]);
+  concat.forward({in_a, in_b}, expected);
+  concat2->forward({in_a, in_b}, actual);
+  EXPECT_EQ((*expected[0])[0], (*actual[0])[0]);
+}
+
+TEST(quantization_int8, sessions) {
+  network<sequential> net;
+  net << convolutional_layer(6, 6, 3, 2, 3, padding::same)
+      << max_pooling_layer(6, 6, 3, 2) << relu_layer(3, 3, 3)
+      << fully_connected_layer(27, 5);
+  net.init_weight();
+
+  std::vector<vec_t> data(16, vec_t(72));
+  for (auto &v : data) uniform_rand(v.begin(), v.end(), -1.0f, 1.0f);
+  calibration_params params;
+  params.int8_activations  = true;
+  network<sequential> inet = quantize_network(net, data, params);
+
+  // inputs beyond the calibration data: the static ranges matter
+  std::vector<vec_t> in(8, vec_t(72));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -3.0f, 3.0f);
+  std::vector<vec_t> expected;
+  for (const auto &v : in) expected.push_back(inet.predict(v));
+
+  std::vector<network<sequential>> sessions;
+  for (size_t t = 0; t < 2; t++) sessions.push_back(inet.session());
+  std::vector<std::thread> threads;
+  std::vector<std::vector<vec_t>> actual(sessions.size());
+  for (size_t t = 0; t < sessions.size(); t++) {
+    threads.emplace_back([&, t] {
+      for (const auto &v : in) actual[t].push_back(sessions[t].predict(v));
+    });
+  }
+  for (auto &t : threads) t.join();
+
+  for (const auto &a : actual) {
+    ASSERT_EQ(expected.size(), a.size());
+    for (size_t i = 0; i < a.size(); i++) {
+      for (size_t j = 0; j < a[i].size(); j++) {
+        EXPECT_FLOAT_EQ(expected[i][j], a[i][j]);
+      }
+    }
+  }
+}
+
+TEST(quantization_aware_training, quantize_network) {
+  // for reproducibility only, the bounds below hold whatever the weights
+  set_random_seed(0);
+  network<sequential> net;
+  net << convolutional_layer(6, 6, 3, 2, 3, padding::same)
+      << relu_layer(6, 6, 3) << fully_connected_layer(108, 4);
+  net.init_weight();
+  net.at<convolutional_layer>(0).enable_fake_quantization();
+  net.at<fully_connected_layer>(2).enable_fake_quantization();
+
+  std::vector<vec_t> data(32, vec_t(72)), target(32, vec_t(4));
+  for (auto &v : data) uniform_rand(v.begin(), v.end(), -1.0f, 1.0f);
+  for (auto &v : target) uniform_rand(v.begin(), v.end(), -1.0f, 1.0f);
+
+  adagrad optimizer;
+  net.fit<mse>(optimizer, data, target, 8, 3);
+
+  const auto ranges = fake_quantization_ranges(net);
+  ASSERT_EQ(net.depth() + 1, ranges.size());
+  EXPECT_TRUE(ranges[0].is_static());
+  EXPECT_FLOAT_EQ(0.0f, ranges[2].min);
+  EXPECT_TRUE(ranges[3].is_static());
+
+  // the quantized layers compute what training simulated, up to the
+  // rounding of the fixed-point requantization: a level of the hidden
+  // activations, weighted by the fully-connected layer, plus a level of
+  // its own output
+  const vec_t &W             = *net[2]->weights()[0];
+  const float_t hidden_level = (ranges[2].max - ranges[2].min) / 255;
+  const float_t output_level = (ranges[3].max - ranges[3].min) / 255;
+  vec_t bound(4, output_level);
+  for (size_t j = 0; j < bound.size(); j++) {
+    for (size_t k = 0; k < 108; k++) {
+      bound[j] += hidden_level * std::abs(W[k * 4 + j]);
+    }
+  }
+
+  for (bool int8_activations : {false, true}) {
+    network<sequential> qnet =
+      quantize_network(net, core::backend_t::internal, int8_activations);
+    EXPECT_EQ("q_conv", qnet[0]->layer_type());
+
+    for (size_t i = 0; i < data.size(); i++) {
+      vec_t expected = net.predict(data[i]);
+      vec_t actual   = qnet.predict(data[i]);
+      for (size_t j = 0; j < expected.size(); j++) {
+        EXPECT_NEAR(expected[j], actual[j], bound[j]);
+      }
+    }
+  }
+}
+
+TEST(quantization_aware_training, save_load) {
+  network<sequential> net;
+  net << convolutional_layer(6, 6, 3, 2, 3, padding::same)
+      << relu_layer(6, 6, 3) << fully_connected_layer(108, 4);
+  net.init_weight();
+  net.at<convolutional_layer>(0).enable_fake_quantization(0.9f);
+  net.at<fully_connected_layer>(2).enable_fake_quantization();
+
+  std::vector<vec_t> data(16, vec_t(72)), target(16, vec_t(4));
+  for (auto &v : data) uniform_rand(v.begin(), v.end(), -1.0f, 1.0f);
+  for (auto &v : target) uniform_rand(v.begin(), v.end(), -1.0f, 1.0f);
+  adagrad optimizer;
+  net.fit<mse>(optimizer, data, target, 8, 1);
+  const auto ranges = fake_quantization_ranges(net);
+
+  for (auto format : {file_format::binary, file_format::json}) {
+    const std::string path = unique_path();
+    net.save(path, content_type::weights_and_model, format);
+    network<sequential> loaded;
+    loaded.load(path, content_type::weights_and_model, format);
+    std::remove(path.c_str());
+    // like net after fit, with the ranges frozen
+    loaded.set_netphase(net_phase::test);
+
+    // the training goes on with the ranges learned so far
+    EXPECT_TRUE(loaded.at<convolutional_layer>(0).fake_quantization());
+    EXPECT_TRUE(loaded.at<fully_connected_layer>(2).fake_quantization());
+    const auto loaded_ranges = fake_quantization_ranges(loaded);
+    ASSERT_EQ(ranges.size(), loaded_ranges.size());
+    for (size_t i = 0; i < ranges.size(); i++) {
+      EXPECT_FLOAT_EQ(ranges[i].min, loaded_ranges[i].min);
+      EXPECT_FLOAT_EQ(ranges[i].max, loaded_ranges[i].max);
+    }
+
+    for (const auto &v : data) {
+      vec_t expected = net.predict(v);
+      vec_t actual   = loaded.predict(v);
+      for (size_t j = 0; j < expected.size(); j++) {
+        EXPECT_FLOAT_EQ(expected[j], actual[j]);
+      }
+    }
+  }
+}
+
 }  // namespace tiny_dnn
@@ -93,28 +93,122 @@ TEST(quantized_convolutional, fprop) {
     {
         l.forward_propagation(in_data, out_data);
 
-        EXPECT_NEAR(-0.043426, out[0], 2e-2);
-        EXPECT_NEAR(1.6769816, out[1], 2e-2);
-        EXPECT_NEAR(1.4731820, out[2], 2e-2);
-        EXPECT_NEAR(1.0822733, out[3], 2e-2);
-        EXPECT_NEAR(0.0415336, out[4], 2e-2);
-        EXPECT_NEAR(-1.997466, out[5], 2e-2);
-        EXPECT_NEAR(0.4238461, out[6], 2e-2);
-        EXPECT_NEAR(1.1756143, out[7], 2e-2);
-        EXPECT_NEAR(0.8273983, out[8], 2e-2);
-        EXPECT_NEAR(-0.192101, out[9], 2e-2);
-        EXPECT_NEAR(1.2309504, out[10], 2e-2);
-        EXPECT_NEAR(2.2292108, out[11], 2e-2);
-        EXPECT_NEAR(0.5300441, out[12], 2e-2);
-        EXPECT_NEAR(1.7407004, out[13], 2e-2);
-        EXPECT_NEAR(1.6345025, out[14], 2e-2);
-        EXPECT_NEAR(0.6362420, out[15], 2e-2);
-        EXPECT_NEAR(3.4186277, out[16], 2e-2);
-        EXPECT_NEAR(-0.489455, out[17], 2e-2);
+        EXPECT_NEAR(-0.0257819, out[0], 2e-2);
+        EXPECT_NEAR(1.6788896, out[1], 2e-2);
+        EXPECT_NEAR(1.4710028, out[2], 2e-2);
+        EXPECT_NEAR(1.0968066, out[3], 2e-2);
+        EXPECT_NEAR(0.0365842, out[4], 2e-2);
+        EXPECT_NEAR(-1.9799175, out[5], 2e-2);
+        EXPECT_NEAR(0.4315690, out[6], 2e-2);
+        EXPECT_NEAR(1.1799614, out[7], 2e-2);
+        EXPECT_NEAR(0.8473426, out[8], 2e-2);
+        EXPECT_NEAR(-0.7741743, out[9], 2e-2);
+        EXPECT_NEAR(1.138384, out[10], 2e-2);
+        EXPECT_NEAR(2.1362405, out[11], 2e-2);
+        EXPECT_NEAR(0.6186671, out[12], 2e-2);
+        EXPECT_NEAR(1.5333689, out[13], 2e-2);
+        EXPECT_NEAR(0.7226105, out[14], 2e-2);
+        EXPECT_NEAR(0.4315690, out[15], 2e-2);
+        EXPECT_NEAR(3.3132966, out[16], 2e-2);
+        EXPECT_NEAR(-1.0028497, out[17], 2e-2);
     }
   // clang-format on
 }
 
+TEST(quantized_convolutional, fprop_resident_weights) {
+  quantized_convolutional_layer l1(5, 5, 3, 1, 2);
+  quantized_convolutional_layer l2(5, 5, 3, 1, 2);
+  l1.setup(false);
+  l2.setup(false);
+
+  vec_t in(25);
+  uniform_rand(in.begin(), in.end(), -1.0, 1.0);
+  std::vector<tensor_t> input = {tensor_t{in}};
+  std::vector<const tensor_t *> o1, o2;
+
+  // second call reuses the weights quantized by the first one
+  l1.forward(input, o1);
+  vec_t out_first = (*o1[0])[0];
+  l1.forward(input, o1);
+  for (size_t i = 0; i < out_first.size(); i++) {
+    EXPECT_EQ(out_first[i], (*o1[0])[0][i]);
+  }
+
+  // modifying the weights must invalidate the resident copy
+  vec_t &w = *l1.weights()[0];
+  for (auto &v : w) v = -v * float_t(2);
+  *l2.weights()[0] = w;
+
+  l1.forward(input, o1);
+  l2.forward(input, o2);
+  for (size_t i = 0; i < out_first.size(); i++) {
+    EXPECT_EQ((*o2[0])[0][i], (*o1[0])[0][i]);
+  }
+}
+
+TEST(quantized_convolutional, fprop_avx) {
+  quantized_convolutional_layer l1(7, 6, 3, 5, 6, padding::valid, true, 2, 1);
+  quantized_convolutional_layer l2(7, 6, 3, 5, 6, padding::valid, true, 2, 1,
+                                   core::backend_t::avx);
+  EXPECT_EQ(l2.engine(), core::backend_t::avx);
+  l1.setup(false);
+  l2.setup(false);
+  *l2.weights()[0] = *l1.weights()[0];
+  *l2.weights()[1] = *l1.weights()[1];
+
+  vec_t in(7 * 6 * 5);
+  uniform_rand(in.begin(), in.end(), -1.0, 1.0);
+  std::vector<tensor_t> input = {tensor_t{in}};
+  std::vector<const tensor_t *> o1, o2;
+
+  // the 8-bit gemm is exact, so both engines must agree bit for bit
+  l1.forward(input, o1);
+  l2.forward(input, o2);
+  for (size_t i = 0; i < (*o1[0])[0].size(); i++) {
+    EXPECT_EQ((*o1[0])[0][i], (*o2[0])[0][i]);
+  }
+}
+
+TEST(quantized_convolutional, fprop_int8_io) {
+  quantized_convolutional_layer l1(5, 5, 3, 2, 2, padding::same);
+  quantized_convolutional_layer l2(5, 5, 3, 2, 2, padding::same);
+  l1.setup(false);
+  l2.setup(false);
+  *l2.weights()[0] = *l1.weights()[0];
+  *l2.weights()[1] = *l1.weights()[1];
+
+  core::quantization_range in_range, out_range;
+  in_range.min  = -1.0f;
+  in_range.max  = 1.0f;
+  out_range.min = -4.0f;
+  out_range.max = 4.0f;
+  l1.set_quantization_ranges(in_range, out_range);
+  l2.set_quantization_ranges(in_range, out_range);
+  l2.set_int8_io(true, true);
+
+  quantized_convolutional_layer dynamic_range(5, 5, 3, 2, 2);
+  EXPECT_THROW(dynamic_range.set_int8_io(true, false), nn_error);
+
+  vec_t in(5 * 5 * 2), codes(in.size());
+  uniform_rand(in.begin(), in.end(), -1.0, 1.0);
+  for (size_t i = 0; i < in.size(); i++) {
+    codes[i] = core::kernels::float_to_quantized<uint8_t>(in[i], -1.0f, 1.0f);
+  }
+  std::vector<const tensor_t *> o1, o2;
+
+  // the border of the coded input is padded with the code of 0.0
+  l1.forward({tensor_t{in}}, o1);
+  l2.forward({tensor_t{codes}}, o2);
+  for (size_t i = 0; i < (*o1[0])[0].size(); i++) {
+    const float_t code = (*o2[0])[0][i];
+    EXPECT_EQ(code, std::floor(code));
+    EXPECT_NEAR((*o1[0])[0][i],
+                core::kernels::quantized_to_float<uint8_t>(
+                  static_cast<uint8_t>(code), -4.0f, 4.0f),
+                1e-5);
+  }
+}
+
 #ifdef CNN_USE_NNPACK
 TEST(quantized_convolutional, fprop_npp) {
   using network = network<sequential>;
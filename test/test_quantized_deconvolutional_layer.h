@@ -90,18 +90,18 @@ TEST(quantized_deconvolutional, fprop) {
 
         EXPECT_NEAR(0.9017647, out[0], 1e-2);
         EXPECT_NEAR(0.9017647, out[1], 1e-2);
-        EXPECT_NEAR(0.8049019, out[2], 1e-2);
+        EXPECT_NEAR(0.7945214, out[2], 1e-2);
         EXPECT_NEAR(0.4025490, out[3], 1e-2);
         EXPECT_NEAR(0.9017647, out[4], 1e-2);
         EXPECT_NEAR(0.0001960, out[5], 1e-2);
-        EXPECT_NEAR(0.1045097, out[6], 1e-2);
-        EXPECT_NEAR(-0.200980, out[7], 1e-2);
+        EXPECT_NEAR(0.0941292, out[6], 1e-2);
+        EXPECT_NEAR(-0.211361, out[7], 1e-2);
         EXPECT_NEAR(0.1566666, out[8], 1e-2);
         EXPECT_NEAR(-0.797058, out[9], 1e-2);
         EXPECT_NEAR(-0.551176, out[10], 1e-2);
-        EXPECT_NEAR(0.1045097, out[11], 1e-2);
+        EXPECT_NEAR(0.0941292, out[11], 1e-2);
         EXPECT_NEAR(0.1566666, out[12], 1e-2);
-        EXPECT_NEAR(-0.603333, out[13], 1e-2);
+        EXPECT_NEAR(-0.613714, out[13], 1e-2);
         EXPECT_NEAR(0.1566666, out[14], 1e-2);
         EXPECT_NEAR(0.0001960, out[15], 1e-2);
     }
@@ -159,25 +159,49 @@ TEST(quantized_deconvolutional, fprop2) {
     l.forward_propagation(in_data, out_data);
 
     EXPECT_NEAR(0.0001960, out[0], 1e-2);
-    EXPECT_NEAR(0.1045097, out[1], 1e-2);
+    EXPECT_NEAR(0.0941292, out[1], 1e-2);
     EXPECT_NEAR(-0.797058, out[2], 1e-2);
     EXPECT_NEAR(-0.551176, out[3], 1e-2);
     EXPECT_NEAR(-0.707647, out[4], 1e-2);
-    EXPECT_NEAR(0.8049019, out[5], 1e-2);
+    EXPECT_NEAR(0.7945214, out[5], 1e-2);
     EXPECT_NEAR(-0.797058, out[6], 1e-2);
     EXPECT_NEAR(1.1029412, out[7], 1e-2);
     EXPECT_NEAR(0.1566666, out[8], 1e-2);
     EXPECT_NEAR(-0.797058, out[9], 1e-2);
     EXPECT_NEAR(-0.551176, out[10], 1e-2);
-    EXPECT_NEAR(0.1045097, out[11], 1e-2);
+    EXPECT_NEAR(0.0941292, out[11], 1e-2);
     EXPECT_NEAR(0.1566666, out[12], 1e-2);
-    EXPECT_NEAR(-0.603333, out[13], 1e-2);
+    EXPECT_NEAR(-0.613714, out[13], 1e-2);
     EXPECT_NEAR(0.1566666, out[14], 1e-2);
     EXPECT_NEAR(0.0001960, out[15], 1e-2);
   }
   // clang-format on
 }
 
+TEST(quantized_deconvolutional, fprop_avx) {
+  quantized_deconvolutional_layer l1(4, 3, 3, 5, 2, padding::valid, true, 2,
+                                     2);
+  quantized_deconvolutional_layer l2(4, 3, 3, 5, 2, padding::valid, true, 2,
+                                     2, core::backend_t::avx);
+  EXPECT_EQ(l2.engine(), core::backend_t::avx);
+  l1.setup(false);
+  l2.setup(false);
+  *l2.weights()[0] = *l1.weights()[0];
+  *l2.weights()[1] = *l1.weights()[1];
+
+  vec_t in(4 * 3 * 5);
+  uniform_rand(in.begin(), in.end(), -1.0, 1.0);
+  std::vector<tensor_t> input = {tensor_t{in}};
+  std::vector<const tensor_t *> o1, o2;
+
+  // the 8-bit gemm is exact, so both engines must agree bit for bit
+  l1.forward(input, o1);
+  l2.forward(input, o2);
+  for (size_t i = 0; i < (*o1[0])[0].size(); i++) {
+    EXPECT_EQ((*o1[0])[0][i], (*o2[0])[0][i]);
+  }
+}
+
 /*
 TEST(quantized_deconvolutional, gradient_check) { // tanh - mse
     network<sequential> nn;
@@ -0,0 +1,63 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "test/testhelper.h"
+#include "tiny_dnn/tiny_dnn.h"
+
+namespace tiny_dnn {
+
+TEST(random, philox_known_answer) {
+  // Random123 known-answer vectors of philox4x32-10
+  const philox_stream zero(0, 0);
+  const philox_stream::block z = zero(0, 0, 0, 0);
+  EXPECT_EQ(z[0], 0x6627e8d5u);
+  EXPECT_EQ(z[1], 0xe169c58du);
+  EXPECT_EQ(z[2], 0xbc57ac4cu);
+  EXPECT_EQ(z[3], 0x9b00dbd8u);
+
+  const philox_stream ones(0xffffffff, 0xffffffff);
+  const philox_stream::block f =
+    ones(0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff);
+  EXPECT_EQ(f[0], 0x408f276du);
+  EXPECT_EQ(f[1], 0x41c83b0eu);
+  EXPECT_EQ(f[2], 0xa20bc7c6u);
+  EXPECT_EQ(f[3], 0x6d5451fdu);
+}
+
+TEST(random, concurrent_streams) {
+  const size_t n_threads = 4, n_streams = 1000;
+  set_random_seed(0);
+
+  std::vector<std::vector<uint32_t>> ids(n_threads);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < n_threads; t++) {
+    threads.emplace_back([&ids, t, n_streams]() {
+      for (size_t i = 0; i < n_streams; i++) {
+        ids[t].push_back(random_generator::get_instance().next_stream());
+      }
+    });
+  }
+  for (auto &t : threads) t.join();
+
+  // every stream gets an id of its own
+  std::vector<uint32_t> all;
+  for (const auto &v : ids) all.insert(all.end(), v.begin(), v.end());
+  std::sort(all.begin(), all.end());
+  ASSERT_EQ(n_threads * n_streams, all.size());
+  for (size_t i = 0; i < all.size(); i++) EXPECT_EQ(i, all[i]);
+}
+
+}  // namespace tiny_dnn
@@ -10,6 +10,7 @@
 #include <gtest/gtest.h>
 
 #include <functional>
+#include <sstream>
 #include <vector>
 
 #include "test/testhelper.h"
@@ -192,4 +193,107 @@ TEST(recurrent_cell, forward_nobias) {
   }
 }
 
+TEST(recurrent_cell, forward_batch) {
+  recurrent_cell_layer l(5, 7);
+  l.setup(true);
+
+  tensor_t in(9, vec_t(5));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+
+  std::vector<const tensor_t *> o;
+  l.forward({in}, o);
+  const tensor_t batch = *o[0];
+
+  for (size_t s = 0; s < in.size(); s++) {
+    l.forward({{in[s]}}, o);
+    for (size_t i = 0; i < 7; i++) {
+      EXPECT_NEAR(batch[s][i], (*o[0])[0][i], 1e-5);
+    }
+  }
+}
+
+TEST(recurrent_cell, stream) {
+  const size_t in_dim = 3, out_dim = 4, steps = 5;
+  network<sequential> nn;
+  nn << recurrent_cell_layer(in_dim, out_dim) << tanh_layer();
+  nn.init_weight();
+
+  // the same frames through a whole recurrent_layer
+  recurrent_layer seq(in_dim, out_dim, steps);
+  seq.setup(true);
+  auto w  = seq.weights();
+  auto cw = nn[0]->weights();
+  for (size_t i = 0; i < w.size(); i++) *w[i] = *cw[i];
+
+  vec_t frames(in_dim * steps);
+  uniform_rand(frames.begin(), frames.end(), -1.0, 1.0);
+  std::vector<const tensor_t *> o;
+  seq.forward({{frames}}, o);
+  const vec_t ref = (*o[0])[0];
+
+  stream_state state = nn.create_stream_state();
+  ASSERT_EQ(state.size(), size_t(1));
+  for (size_t t = 0; t < steps; t++) {
+    const vec_t x(&frames[t * in_dim], &frames[t * in_dim] + in_dim);
+    const vec_t y = nn.step(state, x);
+    for (size_t i = 0; i < out_dim; i++) {
+      EXPECT_NEAR(std::tanh(ref[t * out_dim + i]), y[i], 1e-5);
+    }
+  }
+
+  state.reset();
+  const vec_t first = nn.step(state, vec_t(&frames[0], &frames[in_dim]));
+  for (size_t i = 0; i < out_dim; i++) {
+    EXPECT_NEAR(std::tanh(ref[i]), first[i], 1e-5);
+  }
+}
+
+TEST(recurrent_cell, stream_batch) {
+  const size_t in_dim = 2, out_dim = 3, streams = 4;
+  network<sequential> nn;
+  nn << recurrent_cell_layer(in_dim, out_dim) << tanh_layer();
+  nn.init_weight();
+
+  std::vector<stream_state> batched(streams, nn.create_stream_state());
+  std::vector<stream_state> single(streams, nn.create_stream_state());
+  std::vector<stream_state *> ptrs;
+  for (auto &s : batched) ptrs.push_back(&s);
+
+  for (size_t t = 0; t < 3; t++) {
+    std::vector<vec_t> frames(streams, vec_t(in_dim));
+    for (auto &f : frames) uniform_rand(f.begin(), f.end(), -1.0, 1.0);
+
+    const std::vector<vec_t> y = nn.step(ptrs, frames);
+    for (size_t s = 0; s < streams; s++) {
+      const vec_t ys = nn.step(single[s], frames[s]);
+      for (size_t i = 0; i < out_dim; i++) EXPECT_NEAR(ys[i], y[s][i], 1e-5);
+    }
+  }
+
+  // a state saved and loaded resumes its stream
+  std::stringstream ss;
+  ss << batched[1];
+  stream_state restored = nn.create_stream_state();
+  ss >> restored;
+  const vec_t frame(in_dim, float_t(0.5));
+  const vec_t expected = nn.step(batched[1], frame);
+  const vec_t y        = nn.step(restored, frame);
+  for (size_t i = 0; i < out_dim; i++) EXPECT_NEAR(expected[i], y[i], 1e-5);
+}
+
+TEST(recurrent_cell, stream_state_mismatch) {
+  network<sequential> nn, other;
+  nn << recurrent_cell_layer(2, 3) << tanh_layer();
+  other << recurrent_cell_layer(2, 4) << tanh_layer();
+  nn.init_weight();
+
+  const vec_t frame(2, float_t(0.5));
+  stream_state empty;
+  EXPECT_THROW(nn.step(empty, frame), nn_error);
+  stream_state wrong_size = other.create_stream_state();
+  EXPECT_THROW(nn.step(wrong_size, frame), nn_error);
+  stream_state state = nn.create_stream_state();
+  EXPECT_NO_THROW(nn.step(state, frame));
+}
+
 }  // namespace tiny_dnn
@@ -0,0 +1,227 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "test/testhelper.h"
+#include "tiny_dnn/tiny_dnn.h"
+
+namespace tiny_dnn {
+
+TEST(recurrent, forward) {
+  const size_t in_dim = 3, out_dim = 4, seq_len = 5;
+  recurrent_layer l(in_dim, out_dim, seq_len);
+  recurrent_cell_layer cell(in_dim, out_dim);
+  l.setup(true);
+  cell.setup(true);
+
+  // same U, W, V, b and c
+  auto w  = l.weights();
+  auto cw = cell.weights();
+  ASSERT_EQ(w.size(), cw.size());
+  for (size_t i = 0; i < w.size(); i++) *cw[i] = *w[i];
+
+  tensor_t in(2, vec_t(in_dim * seq_len));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+
+  std::vector<const tensor_t *> o;
+  l.forward({in}, o);
+  const tensor_t seq = *o[0];
+
+  for (size_t s = 0; s < in.size(); s++) {
+    vec_t h(out_dim, float_t{0});
+    for (size_t t = 0; t < seq_len; t++) {
+      vec_t x(in[s].begin() + t * in_dim, in[s].begin() + (t + 1) * in_dim);
+      // h(t-1) is an aux input, not set by forward()
+      *cell.inputs()[1]->get_data() = tensor_t{h};
+      cell.forward({{x}}, o);
+      for (size_t i = 0; i < out_dim; i++) {
+        EXPECT_NEAR((*o[0])[0][i], seq[s][t * out_dim + i], 1e-5);
+      }
+      h = (*cell.outputs()[1]->get_data())[0];
+    }
+  }
+}
+
+TEST(recurrent, gradient_check) {
+  network<sequential> nn;
+  nn << recurrent_layer(4, 3, 6) << tanh_layer();
+
+  const auto test_data = generate_gradient_check_data(nn.in_data_size());
+  nn.init_weight();
+  EXPECT_TRUE(nn.gradient_check<mse>(test_data.first, test_data.second,
+                                     epsilon<float_t>(), GRAD_CHECK_ALL));
+}
+
+TEST(recurrent, truncated_bptt) {
+  const size_t in_dim = 2, out_dim = 3, seq_len = 6;
+  recurrent_layer l(in_dim, out_dim, seq_len);
+  l.setup(true);
+
+  vec_t in(in_dim * seq_len);
+  uniform_rand(in.begin(), in.end(), -1.0, 1.0);
+  // only the last output has an error
+  vec_t grad(out_dim * seq_len, float_t{0});
+  grad[out_dim * (seq_len - 1)] = float_t{1};
+
+  std::vector<const tensor_t *> o;
+  for (size_t bptt : {size_t(0), size_t(2)}) {
+    l.set_bptt(bptt);
+    l.forward({{in}}, o);
+    const vec_t dx = l.backward({{grad}})[0][0];
+
+    for (size_t t = 0; t < seq_len; t++) {
+      const bool reached = bptt == 0 || t >= seq_len - bptt;
+      float_t sum        = 0;
+      for (size_t i = 0; i < in_dim; i++) sum += std::abs(dx[t * in_dim + i]);
+      if (reached) {
+        EXPECT_GT(sum, float_t{0}) << "bptt " << bptt << " step " << t;
+      } else {
+        EXPECT_EQ(sum, float_t{0}) << "bptt " << bptt << " step " << t;
+      }
+    }
+  }
+}
+
+TEST(recurrent, sequence_batch) {
+  const sequence_batch seq({2, 0, 3, 2}, 4);
+
+  EXPECT_EQ(seq.packed_size(), size_t(7));
+  // ranked by decreasing length, ties in order
+  EXPECT_EQ(seq.sample(0), size_t(2));
+  EXPECT_EQ(seq.sample(1), size_t(0));
+  EXPECT_EQ(seq.sample(2), size_t(3));
+  EXPECT_EQ(seq.sample(3), size_t(1));
+  EXPECT_EQ(seq.active(0), size_t(3));
+  EXPECT_EQ(seq.active(2), size_t(1));
+  EXPECT_EQ(seq.active(3), size_t(0));
+  EXPECT_EQ(seq.offset(2), size_t(6));
+  EXPECT_EQ(seq.packed_step(6), size_t(2));
+  EXPECT_EQ(seq.packed_rank(4), size_t(1));
+
+  EXPECT_THROW(sequence_batch({5}, 4), nn_error);
+}
+
+TEST(recurrent, variable_length) {
+  const size_t in_dim = 3, out_dim = 2, steps = 5;
+  const std::vector<size_t> lengths = {2, 5, 3};
+  recurrent_layer l(in_dim, out_dim, steps);
+  l.setup(true);
+
+  tensor_t in(lengths.size(), vec_t(in_dim * steps));
+  tensor_t grad(lengths.size(), vec_t(out_dim * steps));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+  for (auto &v : grad) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+
+  std::vector<const tensor_t *> o;
+  l.set_sequence_batch(sequence_batch(lengths, steps));
+  l.forward({in}, o);
+  const tensor_t out = *o[0];
+  const tensor_t dx  = l.backward({grad})[0];
+
+  // each sequence alone, with its padding and no error on it
+  l.set_sequence_batch(sequence_batch());
+  for (size_t s = 0; s < lengths.size(); s++) {
+    const size_t valid = lengths[s];
+    vec_t g(grad[s]);
+    std::fill(g.begin() + valid * out_dim, g.end(), float_t{0});
+
+    l.forward({{in[s]}}, o);
+    const vec_t ref    = (*o[0])[0];
+    const vec_t dx_ref = l.backward({{g}})[0][0];
+
+    for (size_t i = 0; i < out_dim * steps; i++) {
+      const float_t expected = i < valid * out_dim ? ref[i] : float_t{0};
+      EXPECT_NEAR(expected, out[s][i], 1e-5);
+    }
+    for (size_t i = 0; i < in_dim * steps; i++) {
+      const float_t expected = i < valid * in_dim ? dx_ref[i] : float_t{0};
+      EXPECT_NEAR(expected, dx[s][i], 1e-5);
+    }
+  }
+}
+
+TEST(recurrent, masked_gradient) {
+  const sequence_batch seq({1, 3}, 3);
+  std::vector<tensor_t> y = {{vec_t{1, 2, 3}}, {vec_t{1, 2, 3}}};
+  std::vector<tensor_t> t = {{vec_t{0, 0, 0}}, {vec_t{0, 0, 0}}};
+
+  const auto g = gradient<mse>(y, t, seq);
+
+  EXPECT_FLOAT_EQ(g[0][0][0], float_t(2));
+  EXPECT_FLOAT_EQ(g[0][0][1], float_t(0));
+  EXPECT_FLOAT_EQ(g[0][0][2], float_t(0));
+  EXPECT_FLOAT_EQ(g[1][0][2], float_t(2));
+}
+
+TEST(recurrent, fit_sequences) {
+  const size_t steps = 4;
+  network<sequential> nn;
+  nn << recurrent_layer(1, 1, steps);
+
+  // the running sum of the input, over sequences of 1 to 4 steps
+  std::vector<vec_t> in, t;
+  std::vector<size_t> lengths;
+  for (size_t s = 0; s < 16; s++) {
+    vec_t x(steps, float_t{0}), y(steps, float_t{0});
+    lengths.push_back(s % steps + 1);
+    float_t sum = 0;
+    for (size_t i = 0; i < lengths.back(); i++) {
+      x[i] = float_t(0.2) * ((s + i) % 3) - float_t(0.2);
+      sum += x[i];
+      y[i] = sum;
+    }
+    in.push_back(x);
+    t.push_back(y);
+  }
+
+  auto loss = [&]() {
+    float_t e = 0;
+    for (size_t s = 0; s < in.size(); s++) {
+      const vec_t y = nn.predict(in[s]);
+      for (size_t i = 0; i < lengths[s]; i++) {
+        e += (y[i] - t[s][i]) * (y[i] - t[s][i]);
+      }
+    }
+    return e;
+  };
+
+  nn.init_weight();
+  const float_t before = loss();
+  adam opt;
+  nn.fit_sequences<mse>(opt, in, t, lengths, steps, 4, 50);
+
+  EXPECT_LT(loss(), before);
+}
+
+TEST(recurrent, read_write) {
+  recurrent_layer l1(10, 8, 4);
+  recurrent_layer l2(10, 8, 4);
+
+  l1.setup(true);
+  l2.setup(true);
+
+  serialization_test(l1, l2);
+}
+
+TEST(recurrent, serialize_network) {
+  network<sequential> n1, n2;
+  n1 << recurrent_layer(3, 5, 7, true, new relu_layer) << tanh_layer();
+  n1.at<recurrent_layer>(0).set_bptt(3);
+  n1.init_weight();
+
+  network_serialization_test(n1, n2);
+  EXPECT_EQ(n2.at<recurrent_layer>(0).bptt(), size_t(3));
+  EXPECT_EQ(n2.at<recurrent_layer>(0).seq_len(), size_t(7));
+}
+
+}  // namespace tiny_dnn
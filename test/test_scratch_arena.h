@@ -0,0 +1,82 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "test/testhelper.h"
+#include "tiny_dnn/tiny_dnn.h"
+#include "tiny_dnn/util/scratch_arena.h"
+
+namespace tiny_dnn {
+
+TEST(scratch_arena, scopes) {
+  scratch_arena &arena = scratch_arena::local();
+  arena.reset();
+
+  float_t *outer;
+  {
+    scratch_scope scope;
+    outer = scope.allocate<float_t>(10);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(outer) %
+                    scratch_arena::alignment);
+    {
+      // more than a block, the arena grows
+      scratch_scope inner;
+      float_t *large = inner.allocate<float_t>(10000);
+      EXPECT_NE(outer, large);
+      large[9999] = float_t(1);
+    }
+    // the inner allocations are given back, the outer ones are kept
+    scratch_scope inner;
+    EXPECT_NE(outer, inner.allocate<float_t>(1));
+  }
+
+  // empty again, the blocks are merged and nothing else is allocated
+  const size_t capacity    = arena.capacity();
+  const size_t allocations = heap_allocations();
+  for (int pass = 0; pass < 3; pass++) {
+    scratch_scope scope;
+    scope.allocate<float_t>(10);
+    scratch_vector<uint8_t> bytes(10000, uint8_t(7));
+    EXPECT_EQ(uint8_t(7), bytes.back());
+  }
+  EXPECT_EQ(capacity, arena.capacity());
+  EXPECT_EQ(allocations, heap_allocations());
+}
+
+TEST(scratch_arena, steady_state_forward) {
+  network<sequential> net;
+  net << convolutional_layer(8, 8, 3, 1, 4, padding::same) << relu()
+      << max_pooling_layer(8, 8, 4, 2) << fully_connected_layer(64, 10)
+      << softmax();
+  net.init_weight();
+  net.set_netphase(net_phase::test);
+
+  const std::vector<tensor_t> in(4, tensor_t{vec_t(64, float_t(0.5))});
+  net.predict(in);
+  EXPECT_LT(size_t(0), net.forward_allocations());
+
+  // the buffers of the first batch are reused
+  net.predict(in);
+  EXPECT_EQ(size_t(0), net.forward_allocations());
+
+  // the temporaries of the 8-bit kernels come from the arena
+  network<sequential> q;
+  q << quantized_fully_connected_layer(64, 10);
+  q.init_weight();
+  q.set_netphase(net_phase::test);
+  q.predict(in);
+  q.predict(in);
+  EXPECT_EQ(size_t(0), q.forward_allocations());
+}
+
+}  // namespace tiny_dnn
@@ -121,4 +121,29 @@ TEST(slice, forward_channels) {
   }
 }
 
+TEST(slice, zero_copy) {
+  slice_layer sl(shape3d(1, 2, 3), slice_type::slice_samples, 2);
+  tensor_t in(5, vec_t(6));
+  for (auto &v : in) uniform_rand(v.begin(), v.end(), -1.0, 1.0);
+
+  std::vector<const tensor_t *> out;
+  sl.forward({in}, out);
+
+  // the outputs are views of the samples of the input: 2 + 3
+  const tensor_t &src = *sl.inputs()[0]->get_data();
+  ASSERT_EQ(size_t(2), out[0]->size());
+  ASSERT_EQ(size_t(3), out[1]->size());
+  for (size_t s = 0; s < in.size(); s++) {
+    const vec_t &o = s < 2 ? (*out[0])[s] : (*out[1])[s - 2];
+    EXPECT_EQ(src[s].data(), o.data());
+    EXPECT_EQ(in[s], o);
+  }
+
+  // a larger batch moves the slices
+  in.resize(8, in[0]);
+  sl.forward({in}, out);
+  ASSERT_EQ(size_t(4), out[1]->size());
+  EXPECT_EQ((*sl.inputs()[0]->get_data())[4].data(), (*out[1])[0].data());
+}
+
 }  // namespace tiny_dnn
@@ -21,6 +21,12 @@ class elu_layer : public activation_layer {
 
   std::string layer_type() const override { return "elu-activation"; }
 
+  // the backward pass only needs y
+  bool supports_in_place(bool training) const override {
+    CNN_UNREFERENCED_PARAMETER(training);
+    return true;
+  }
+
   void forward_activation(const vec_t &x, vec_t &y) override {
     for (size_t j = 0; j < x.size(); j++) {
       y[j] = x[j] < float_t(0) ? (std::exp(x[j]) - float_t(1)) : x[j];
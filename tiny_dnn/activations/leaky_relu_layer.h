@@ -70,6 +70,12 @@ class leaky_relu_layer : public activation_layer {
 
   std::string layer_type() const override { return "leaky-relu-activation"; }
 
+  // the backward pass only needs y
+  bool supports_in_place(bool training) const override {
+    CNN_UNREFERENCED_PARAMETER(training);
+    return true;
+  }
+
   float_t epsilon_value() const { return epsilon_; }
 
   void forward_activation(const vec_t &x, vec_t &y) override {
@@ -22,6 +22,12 @@ class relu_layer : public activation_layer {
 
   std::string layer_type() const override { return "relu-activation"; }
 
+  // the backward pass only needs y
+  bool supports_in_place(bool training) const override {
+    CNN_UNREFERENCED_PARAMETER(training);
+    return true;
+  }
+
   void forward_activation(const vec_t &x, vec_t &y) override {
     for (size_t j = 0; j < x.size(); j++) {
       y[j] = std::max(float_t(0), x[j]);
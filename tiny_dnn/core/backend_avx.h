@@ -139,12 +139,15 @@ class avx_backend : public backend {
   void deconv2d(const std::vector<tensor_t *> &in_data,
                 std::vector<tensor_t *> &out_data) override {
     (*deconv_layer_worker_storage_).prev_out_ = in_data[0];
-    const vec_t &W                            = (*in_data[1])[0];
-    const vec_t &bias                         = (*in_data[2])[0];
+    const row_t &W                            = (*in_data[1])[0];
+    const row_t &bias                         = (*in_data[2])[0];
     tensor_t &out                             = *out_data[0];
     const tensor_t &in                        = *in_data[0];  // input
 
-    fill_tensor(out, float_t{0});
+    fill_tensor(
+      out, float_t{0},
+      params_d_->out.size());  // deconv2d-kernel requires padded size buffer
+    fill_tensor(out, float_t{0});  // the kernel accumulates into it
 
     kernels::avx_deconv2d_kernel(*params_d_, in, W, bias, out,
                                  layer_->parallelize());
@@ -177,7 +180,7 @@ class avx_backend : public backend {
       copy_and_pad_delta(cws.curr_delta_padded, *in_grad[0]);
 
     const tensor_t &prev_out = *(cws.prev_out_);
-    const vec_t &W           = (*in_data[1])[0];
+    const row_t &W           = (*in_data[1])[0];
     tensor_t &dW             = *in_grad[1];
     tensor_t &db             = *in_grad[2];
     tensor_t &curr_delta     = (params_d_->pad_type == padding::same)
@@ -16,10 +16,7 @@
 #include "tiny_dnn/core/kernels/tiny_deconv2d_kernel.h"
 #include "tiny_dnn/core/kernels/tiny_quantized_conv2d_kernel.h"
 #include "tiny_dnn/core/kernels/tiny_quantized_deconv2d_kernel.h"
-
-#ifdef CNN_USE_GEMMLOWP
 #include "tiny_dnn/core/kernels/tiny_quantized_fully_connected_kernel.h"
-#endif  // CNN_USE_GEMMLOWP
 
 namespace tiny_dnn {
 namespace core {
@@ -75,21 +72,13 @@ class tiny_backend : public backend {
       backward_activation(f3) {}
 
   // fully_connected
-  explicit tiny_backend(fully_params *params)
-#if 0
-    : params_f_(params)
-#endif
-  {
-    CNN_UNREFERENCED_PARAMETER(params);
-  }
+  explicit tiny_backend(fully_params *params) : params_f_(params) {}
 
   // quantized fully_connected
   tiny_backend(
     fully_params *params,
     std::function<void(const tensor_t &, const tensor_t &, tensor_t &)> f)
-    : /*params_f_(params),*/ backward_activation(f) {
-    CNN_UNREFERENCED_PARAMETER(params);
-  }
+    : params_f_(params), backward_activation(f) {}
 
   // core math functions
 
@@ -97,16 +86,22 @@ class tiny_backend : public backend {
   void conv2d_q(const std::vector<tensor_t *> &in_data,
                 std::vector<tensor_t *> &out_data) override {
     copy_and_pad_input(*in_data[0]);
-    const vec_t &W    = (*in_data[1])[0];
-    const vec_t &bias = (*in_data[2])[0];
+    const row_t &W    = (*in_data[1])[0];
+    const row_t &bias = (*in_data[2])[0];
     tensor_t &out     = *out_data[0];
     const std::vector<const vec_t *> &in =
       (*conv_layer_worker_storage_).prev_out_padded_;  // input // NOLINT
 
     fill_tensor(out, float_t{0});
 
+    const kernels::quantized_weights &qw =
+      resident_quantized_weights(in_data, [&](kernels::quantized_weights *dst) {
+        kernels::tiny_quantize_conv2d_weights(*params_c_, W, bias, dst,
+                                              use_gemm());
+      });
+
     for (size_t i = 0; i < in.size(); i++) {
-      kernels::tiny_quantized_conv2d_kernel(*params_c_, *in[i], W, bias, out[i],
+      kernels::tiny_quantized_conv2d_kernel(*params_c_, *in[i], qw, out[i],
                                             layer_->parallelize());
     }
   }
@@ -115,11 +110,11 @@ class tiny_backend : public backend {
   void conv2d_eq(const std::vector<tensor_t *> &in_data,
                  std::vector<tensor_t *> &out_data) override {
     copy_and_pad_input(*in_data[0]);
-    const vec_t &W       = (*in_data[1])[0];
-    const vec_t &bias    = (*in_data[2])[0];
+    const row_t &W       = (*in_data[1])[0];
+    const row_t &bias    = (*in_data[2])[0];
     const tensor_t &in_r = *in_data[3];
-    const vec_t &W_r     = (*in_data[4])[0];
-    const vec_t &b_r     = (*in_data[5])[0];
+    const row_t &W_r     = (*in_data[4])[0];
+    const row_t &b_r     = (*in_data[5])[0];
     tensor_t &out        = *out_data[0];
     tensor_t &out_r      = *out_data[1];
 
@@ -141,7 +136,7 @@ class tiny_backend : public backend {
     conv_layer_worker_specific_storage &cws = (*conv_layer_worker_storage_);
 
     std::vector<const vec_t *> &prev_out = cws.prev_out_padded_;
-    const vec_t &W                       = (*in_data[1])[0];
+    const row_t &W                       = (*in_data[1])[0];
     tensor_t &dW                         = *in_grad[1];
     tensor_t &db                         = *in_grad[2];
     tensor_t &curr_delta                 = *out_grad[0];
@@ -171,14 +166,15 @@ class tiny_backend : public backend {
   void deconv2d(const std::vector<tensor_t *> &in_data,
                 std::vector<tensor_t *> &out_data) override {
     (*deconv_layer_worker_storage_).prev_out_ = in_data[0];
-    const vec_t &W                            = (*in_data[1])[0];
-    const vec_t &bias                         = (*in_data[2])[0];
+    const row_t &W                            = (*in_data[1])[0];
+    const row_t &bias                         = (*in_data[2])[0];
     tensor_t &out                             = *out_data[0];
     const tensor_t &in                        = *in_data[0];  // input
 
     fill_tensor(
       out, float_t{0},
       params_d_->out.size());  // deconv2d-kernel requires padded size buffer
+    fill_tensor(out, float_t{0});  // the kernel accumulates into it
 
     kernels::tiny_deconv2d_kernel(*params_d_, in, W, bias, out,
                                   layer_->parallelize());
@@ -192,17 +188,23 @@ class tiny_backend : public backend {
                   std::vector<tensor_t *> &out_data) override {
     (*deconv_layer_worker_storage_).prev_out_ = in_data[0];
     const tensor_t &in                        = *in_data[0];  // input
-    const vec_t &W                            = (*in_data[1])[0];
-    const vec_t &bias                         = (*in_data[2])[0];
+    const row_t &W                            = (*in_data[1])[0];
+    const row_t &bias                         = (*in_data[2])[0];
     tensor_t &out                             = *out_data[0];
 
     fill_tensor(
       out, float_t{0},
       params_d_->out.size());  // deconv2d-kernel requires padded size buffer
 
+    const kernels::quantized_weights &qw =
+      resident_quantized_weights(in_data, [&](kernels::quantized_weights *dst) {
+        kernels::tiny_quantize_deconv2d_weights(*params_d_, W, bias, dst,
+                                                use_gemm());
+      });
+
     for (size_t i = 0; i < in.size(); i++) {
-      kernels::tiny_quantized_deconv2d_kernel(*params_d_, in[i], W, bias,
-                                              out[i], layer_->parallelize());
+      kernels::tiny_quantized_deconv2d_kernel(*params_d_, in[i], qw, out[i],
+                                              layer_->parallelize());
     }
 
     copy_and_unpad_output(out);
@@ -214,11 +216,11 @@ class tiny_backend : public backend {
                    std::vector<tensor_t *> &out_data) override {
     (*deconv_layer_worker_storage_).prev_out_ = in_data[0];
     const tensor_t &in                        = *in_data[0];  // input
-    const vec_t &W                            = (*in_data[1])[0];
-    const vec_t &bias                         = (*in_data[2])[0];
+    const row_t &W                            = (*in_data[1])[0];
+    const row_t &bias                         = (*in_data[2])[0];
     const tensor_t &in_r                      = *in_data[3];
-    const vec_t &W_r                          = (*in_data[4])[0];
-    const vec_t &b_r                          = (*in_data[5])[0];
+    const row_t &W_r                          = (*in_data[4])[0];
+    const row_t &b_r                          = (*in_data[5])[0];
     tensor_t &out                             = *out_data[0];
     tensor_t &out_r                           = *out_data[1];
 
@@ -245,7 +247,7 @@ class tiny_backend : public backend {
       copy_and_pad_delta(cws.curr_delta_padded, *in_grad[0]);
 
     const tensor_t &prev_out = *(cws.prev_out_);
-    const vec_t &W           = (*in_data[1])[0];
+    const row_t &W           = (*in_data[1])[0];
     tensor_t &dW             = *in_grad[1];
     tensor_t &db             = *in_grad[2];
     tensor_t &curr_delta     = (params_d_->pad_type == padding::same)
@@ -274,7 +276,7 @@ class tiny_backend : public backend {
       copy_and_pad_delta(cws.curr_delta_padded, *in_grad[0]);
 
     const tensor_t &prev_out = *(cws.prev_out_);
-    const vec_t &W           = (*in_data[1])[0];
+    const row_t &W           = (*in_data[1])[0];
     tensor_t &dW             = *in_grad[1];
     tensor_t &db             = *in_grad[2];
     tensor_t &curr_delta     = (params_d_->pad_type == padding::same)
@@ -299,34 +301,34 @@ class tiny_backend : public backend {
 
   void fully_q(const std::vector<tensor_t *> &in_data,
                std::vector<tensor_t *> &out_data) override {
-#ifdef CNN_USE_GEMMLOWP
     const tensor_t &in = *in_data[0];
-    const vec_t &W     = (*in_data[1])[0];
+    const row_t &W     = (*in_data[1])[0];
     tensor_t &out      = *out_data[0];
 
+    const vec_t no_bias;
+    const vec_t &b = params_f_->has_bias_ ? (*in_data[2])[0] : no_bias;
+
+    const kernels::quantized_weights &qw =
+      resident_quantized_weights(in_data, [&](kernels::quantized_weights *dst) {
+        kernels::tiny_quantize_fully_connected_weights(*params_f_, W, b, dst,
+                                                       use_gemm());
+      });
+
     for (size_t i = 0; i < in.size(); i++) {
-      kernels::tiny_quantized_fully_connected_kernel(
-        *params_f_, in[i], W, params_f_->has_bias_ ? (*in_data[2])[0] : vec_t(),
-        out[i], layer_->parallelize());
+      kernels::tiny_quantized_fully_connected_kernel(*params_f_, in[i], qw,
+                                                     out[i],
+                                                     layer_->parallelize());
     }
-#else
-    CNN_UNREFERENCED_PARAMETER(in_data);
-    CNN_UNREFERENCED_PARAMETER(out_data);
-    throw nn_not_implemented_error(
-      "quantized fully op requires gemmlowp "
-      "library. please define CNN_USE_GEMMLOWP");
-#endif
   }
 
   void fully_eq(const std::vector<tensor_t *> &in_data,
                 std::vector<tensor_t *> &out_data) override {
-#ifdef CNN_USE_GEMMLOWP
     const tensor_t &in   = *in_data[0];
-    const vec_t &W       = (*in_data[1])[0];
-    vec_t &b             = (*in_data[2])[0];
+    const row_t &W       = (*in_data[1])[0];
+    row_t &b             = (*in_data[2])[0];
     const tensor_t &in_r = *in_data[3];
-    const vec_t &W_r     = (*in_data[4])[0];
-    const vec_t &b_r     = (*in_data[5])[0];
+    const row_t &W_r     = (*in_data[4])[0];
+    const row_t &b_r     = (*in_data[5])[0];
     tensor_t &out        = *out_data[0];
     tensor_t &out_r      = *out_data[1];
 
@@ -335,43 +337,28 @@ class tiny_backend : public backend {
         *params_f_, in[i], W, b, in_r[i], W_r, b_r, out[i], out_r[i],
         layer_->parallelize());
     }
-#else
-    CNN_UNREFERENCED_PARAMETER(in_data);
-    CNN_UNREFERENCED_PARAMETER(out_data);
-    throw nn_not_implemented_error(
-      "quantized fully op requires gemmlowp "
-      "library. please define CNN_USE_GEMMLOWP");
-#endif
   }
 
   void fully_q(const std::vector<tensor_t *> &in_data,
                const std::vector<tensor_t *> &out_data,
                std::vector<tensor_t *> &out_grad,
                std::vector<tensor_t *> &in_grad) override {
-#ifdef CNN_USE_GEMMLOWP
     const tensor_t &prev_out = *in_data[0];
-    const vec_t &W           = (*in_data[1])[0];
+    const row_t &W           = (*in_data[1])[0];
     tensor_t &dW             = *in_grad[1];
     tensor_t &db             = *in_grad[2];
     tensor_t &prev_delta     = *in_grad[0];
     tensor_t &curr_delta     = *out_grad[0];
 
-    backward_activation(*out_grad[0], *out_data[0], curr_delta);
+    if (backward_activation) {
+      backward_activation(*out_grad[0], *out_data[0], curr_delta);
+    }
 
     for (size_t i = 0; i < prev_out.size(); i++) {
       kernels::tiny_quantized_fully_connected_back_kernel(
         *params_f_, prev_out[i], W, dW[i], prev_delta[i], curr_delta[i], db[i],
         layer_->parallelize());
     }
-#else
-    CNN_UNREFERENCED_PARAMETER(in_data);
-    CNN_UNREFERENCED_PARAMETER(out_data);
-    CNN_UNREFERENCED_PARAMETER(out_grad);
-    CNN_UNREFERENCED_PARAMETER(in_grad);
-    throw nn_not_implemented_error(
-      "quantized fully op requires gemmlowp "
-      "library. please define CNN_USE_GEMMLOWP");
-#endif
   }
 
   backend_t type() const override { return default_engine(); }
@@ -380,7 +367,7 @@ class tiny_backend : public backend {
   /* Pointer to the convolution parameters */
   conv_params *params_c_;
   deconv_params *params_d_;
-  // fully_params *params_f_;
+  fully_params *params_f_;
 
   /* Pointer to the workers */
   conv_layer_worker_specific_storage *conv_layer_worker_storage_;
@@ -393,6 +380,35 @@ class tiny_backend : public backend {
   std::function<void(const tensor_t &, tensor_t &)> copy_and_pad_delta;
   std::function<void(const tensor_t &, const tensor_t &, tensor_t &)>
     backward_activation;
+
+  /* The avx engine runs the quantized kernels on the native 8-bit gemm */
+  bool use_gemm() const { return layer_->engine() == backend_t::avx; }
+
+  /* Quantized weights kept resident across forward calls */
+  kernels::quantized_weights quantized_weights_;
+  bool quantized_weights_valid_     = false;
+  size_t quantized_weights_version_ = 0;
+
+  /* Returns the 8-bit weights for the quantized kernels. They are requantized
+   * only when the layer reports modified weights (weights_version()); weight
+   * tensors which are not the layer's own edges can't be tracked and are
+   * quantized on every call.
+   */
+  template <typename Quantize>
+  const kernels::quantized_weights &resident_quantized_weights(
+    const std::vector<tensor_t *> &in_data, Quantize quantize) {
+    const bool own_weights =
+      layer_->prev()[1] && layer_->prev()[1]->get_data() == in_data[1];
+    const size_t version = layer_->weights_version();
+
+    if (!own_weights || !quantized_weights_valid_ ||
+        quantized_weights_version_ != version) {
+      quantize(&quantized_weights_);
+      quantized_weights_valid_   = own_weights;
+      quantized_weights_version_ = version;
+    }
+    return quantized_weights_;
+  }
 };
 
 }  // namespace core
@@ -7,12 +7,46 @@
 */
 #pragma once
 
+#include "tiny_dnn/core/kernels/avx_deconv2d_kernel.h"
 #include "tiny_dnn/core/params/deconv_params.h"
 
 namespace tiny_dnn {
 namespace core {
 namespace kernels {
 
+// col(o, wy, wx)(y, x) = delta(o, y * h_stride + wy, x * w_stride + wx)
+inline void deconv2d_im2col(const deconv_params &params,
+                            const float_t *delta,
+                            float_t *col) {
+  const size_t in_w  = params.in.width_;
+  const size_t in_h  = params.in.height_;
+  const size_t out_w = params.out.width_;
+  const size_t area  = in_w * in_h;
+  const size_t plane = params.out.width_ * params.out.height_;
+
+  for (size_t o = 0; o < params.out.depth_; o++) {
+    for (size_t wy = 0; wy < params.weight.height_; wy++) {
+      for (size_t wx = 0; wx < params.weight.width_; wx++) {
+        for (size_t y = 0; y < in_h; y++) {
+          const float_t *src =
+            delta + o * plane + (y * params.h_stride + wy) * out_w + wx;
+          float_t *dst = col + y * in_w;
+          for (size_t x = 0; x < in_w; x++) {
+            dst[x] = src[x * params.w_stride];
+          }
+        }
+        col += area;
+      }
+    }
+  }
+}
+
+/**
+ * Backward pass of the gemm engine (see avx_deconv2d_kernel):
+ *   d in = Wp * col,  dWp += in * col^T
+ * col being the output gradient in the column layout; the samples are
+ * processed in parallel, each adding to its own row of dW and db.
+ **/
 inline void avx_deconv2d_back_kernel(const deconv_params &params,
                                      const tensor_t &prev_out,
                                      const vec_t &W,
@@ -20,9 +54,48 @@ inline void avx_deconv2d_back_kernel(const deconv_params &params,
                                      tensor_t &db,
                                      tensor_t &curr_delta,
                                      tensor_t *prev_delta) {
-  // fallback to non-avx version
-  tiny_deconv2d_back_kernel(params, prev_out, W, dW, db, curr_delta,
-                            prev_delta);
+  const size_t taps  = params.weight.area();
+  const size_t K     = params.out.depth_ * taps;
+  const size_t area  = params.in.width_ * params.in.height_;
+  const size_t plane = params.out.width_ * params.out.height_;
+
+  vec_t Wp;
+  deconv2d_pack_weights(params, W, &Wp);
+
+  for_i(prev_out.size(), [&](size_t sample) {
+    vec_t col(K * area);
+    vec_t dWp(params.in.depth_ * K, float_t{0});
+    deconv2d_im2col(params, &curr_delta[sample][0], &col[0]);
+
+    // propagate delta to previous layer
+    tiny_gemm_nn(params.in.depth_, [&](size_t inc) { return &Wp[inc * K]; },
+                 &col[0], K, area,
+                 [&](size_t inc) { return &(*prev_delta)[sample][inc * area]; },
+                 false);
+
+    // accumulate dw
+    tiny_gemm_nt(params.in.depth_,
+                 [&](size_t inc) { return &prev_out[sample][inc * area]; },
+                 &col[0], K, area, [&](size_t inc) { return &dWp[inc * K]; },
+                 false);
+    for (size_t inc = 0; inc < params.in.depth_; inc++) {
+      for (size_t o = 0; o < params.out.depth_; o++) {
+        if (!params.tbl.is_connected(o, inc)) continue;
+        const size_t idx =
+          params.weight.get_index(0, 0, params.in.depth_ * o + inc);
+        vectorize::reduce<float_t>(&dWp[inc * K + o * taps], taps,
+                                   &dW[sample][idx]);
+      }
+    }
+
+    // accumulate db
+    if (params.has_bias) {
+      for (size_t o = 0; o < params.out.depth_; o++) {
+        const float_t *delta = &curr_delta[sample][o * plane];
+        db[sample][o] += std::accumulate(delta, delta + plane, float_t{0});
+      }
+    }
+  });
 }
 
 }  // namespace kernels
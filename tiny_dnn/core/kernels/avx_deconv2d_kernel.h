@@ -7,21 +7,108 @@
 */
 #pragma once
 
-#include "tiny_dnn/core/kernels/tiny_deconv2d_kernel.h"
+#include "tiny_dnn/core/kernels/tiny_gemm_kernel.h"
 #include "tiny_dnn/core/params/deconv_params.h"
 
 namespace tiny_dnn {
 namespace core {
 namespace kernels {
 
+/**
+ * Deconvolution as a matrix product.
+ *
+ * With K = out.depth x weight.height x weight.width, the weights are packed
+ * into an in.depth x K matrix Wp (zero where the connection table has no
+ * connection). The K x (in.height x in.width) column matrix
+ *   col = Wp^T * in
+ * holds the contribution of every kernel tap to every input pixel, and
+ * col2im adds each of them to its place in the output. The backward pass
+ * gathers the output gradient into the same column layout (im2col) and
+ * runs the transposed products.
+ **/
+inline void deconv2d_pack_weights(const deconv_params &params,
+                                  const vec_t &W,
+                                  vec_t *Wp) {
+  const size_t taps = params.weight.area();
+  const size_t K    = params.out.depth_ * taps;
+
+  Wp->assign(params.in.depth_ * K, float_t{0});
+  for (size_t inc = 0; inc < params.in.depth_; inc++) {
+    for (size_t o = 0; o < params.out.depth_; o++) {
+      if (!params.tbl.is_connected(o, inc)) continue;
+      const float_t *pw =
+        &W[params.weight.get_index(0, 0, params.in.depth_ * o + inc)];
+      std::copy(pw, pw + taps, &(*Wp)[inc * K + o * taps]);
+    }
+  }
+}
+
+// out(o, y * h_stride + wy, x * w_stride + wx) += col(o, wy, wx)(y, x)
+inline void deconv2d_col2im(const deconv_params &params,
+                            const float_t *col,
+                            float_t *out) {
+  const size_t in_w     = params.in.width_;
+  const size_t in_h     = params.in.height_;
+  const size_t out_w    = params.out.width_;
+  const size_t area     = in_w * in_h;
+  const size_t plane    = params.out.width_ * params.out.height_;
+  const bool contiguous = params.w_stride == 1;
+
+  for (size_t o = 0; o < params.out.depth_; o++) {
+    for (size_t wy = 0; wy < params.weight.height_; wy++) {
+      for (size_t wx = 0; wx < params.weight.width_; wx++) {
+        for (size_t y = 0; y < in_h; y++) {
+          const float_t *src = col + y * in_w;
+          float_t *dst =
+            out + o * plane + (y * params.h_stride + wy) * out_w + wx;
+          if (contiguous) {
+            vectorize::reduce<float_t>(src, in_w, dst);
+          } else {
+            for (size_t x = 0; x < in_w; x++) {
+              dst[x * params.w_stride] += src[x];
+            }
+          }
+        }
+        col += area;
+      }
+    }
+  }
+}
+
+/**
+ * Forward pass of the gemm engine; the samples are processed in parallel,
+ * or the rows of the product when the batch is a single sample.
+ **/
 inline void avx_deconv2d_kernel(const deconv_params &params,
                                 const tensor_t &in,
                                 const vec_t &W,
                                 const vec_t &bias,
                                 tensor_t &out,
                                 const bool layer_parallelize) {
-  // fallback to non-avx version
-  tiny_deconv2d_kernel(params, in, W, bias, out, layer_parallelize);
+  const size_t K     = params.out.depth_ * params.weight.area();
+  const size_t area  = params.in.width_ * params.in.height_;
+  const size_t plane = params.out.width_ * params.out.height_;
+  const bool inner   = layer_parallelize && in.size() == 1;
+
+  vec_t Wp;
+  deconv2d_pack_weights(params, W, &Wp);
+
+  for_i(layer_parallelize && !inner, in.size(), [&](size_t sample) {
+    vec_t col(K * area, float_t{0});
+
+    tiny_gemm_tn(params.in.depth_,
+                 [&](size_t inc) { return &Wp[inc * K]; },
+                 [&](size_t inc) { return &in[sample][inc * area]; }, K, area,
+                 &col[0], inner);
+    deconv2d_col2im(params, &col[0], &out[sample][0]);
+
+    if (params.has_bias) {
+      for (size_t o = 0; o < params.out.depth_; o++) {
+        float_t *pout = &out[sample][o * plane];
+        std::for_each(pout, pout + plane, [&](float_t &f) { f += bias[o]; });
+      }
+    }
+  });
 }
 
 }  // namespace kernels
@@ -20,7 +20,7 @@ class Conv2dGradOp : public core::OpKernel {
     : core::OpKernel(context) {}
 
   void compute(core::OpKernelContext &context) override {
-    auto params = OpKernel::params_->conv();
+    const auto &params = OpKernel::params_->conv();
 
     // incoming/outcoming data
     const tensor_t &prev_out = context.input(0);
@@ -21,7 +21,7 @@ class Conv2dOp : public core::OpKernel {
     : core::OpKernel(context) {}
 
   void compute(core::OpKernelContext &context) override {
-    auto params = OpKernel::params_->conv();
+    const auto &params = OpKernel::params_->conv();
 
     // incomimg/outcoming data
     const tensor_t &in_data = context.input(0);
@@ -29,8 +29,8 @@ inline void conv2d_op_internal(const tensor_t &in_data,
          size_t elem_stride = params.w_stride;
          size_t line_stride = iw * params.h_stride;
          for (size_t sample = r.begin(); sample < r.end(); sample++) {
-           const vec_t &in = in_data[sample];
-           vec_t &a        = out_data[sample];
+           const row_t &in = in_data[sample];
+           row_t &a        = out_data[sample];
            for (size_t o = 0; o < od; o++) {
              float_t *pa = &a[params.out.get_index(0, 0, o)];
              for (size_t inc = 0; inc < id; inc++) {
@@ -20,7 +20,7 @@ class FullyConnectedGradOp : public core::OpKernel {
     : core::OpKernel(context) {}
 
   void compute(core::OpKernelContext &context) override {
-    auto params = OpKernel::params_->fully();
+    const auto &params = OpKernel::params_->fully();
 
     // incoming/outcoming data
     const tensor_t &prev_out = context.input(0);
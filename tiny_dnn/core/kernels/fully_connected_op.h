@@ -21,7 +21,7 @@ class FullyConnectedOp : public core::OpKernel {
     : core::OpKernel(context) {}
 
   void compute(core::OpKernelContext &context) override {
-    auto params = OpKernel::params_->fully();
+    const auto &params = OpKernel::params_->fully();
 
     // incomimg/outcoming data
     const tensor_t &in_data = context.input(0);
@@ -29,6 +29,10 @@ class FullyConnectedOp : public core::OpKernel {
     const tensor_t *bias    = params.has_bias_ ? &context.input(2) : nullptr;
     tensor_t &out_data      = context.output(0);
 
+    // referred to, not copied
+    const vec_t no_bias;
+    const vec_t &b = params.has_bias_ ? (*bias)[0] : no_bias;
+
     // initialize outputs
     fill_tensor(out_data, float_t{0});
 
@@ -37,17 +41,14 @@ class FullyConnectedOp : public core::OpKernel {
     const core::backend_t engine = context.engine();
 
     if (engine == core::backend_t::internal) {
-      kernels::fully_connected_op_internal(
-        in_data, W[0], params.has_bias_ ? (*bias)[0] : vec_t(), out_data,
-        params, context.parallelize());
+      kernels::fully_connected_op_internal(in_data, W[0], b, out_data, params,
+                                           context.parallelize());
     } else if (engine == core::backend_t::nnpack) {
-      kernels::fully_connected_op_nnpack(
-        in_data, W[0], params.has_bias_ ? (*bias)[0] : vec_t(), out_data,
-        params, context.parallelize());
+      kernels::fully_connected_op_nnpack(in_data, W[0], b, out_data, params,
+                                         context.parallelize());
     } else if (engine == core::backend_t::avx) {
-      kernels::fully_connected_op_avx(in_data, W[0],
-                                      params.has_bias_ ? (*bias)[0] : vec_t(),
-                                      out_data, params, context.parallelize());
+      kernels::fully_connected_op_avx(in_data, W[0], b, out_data, params,
+                                      context.parallelize());
     } else {
       throw nn_error("Not supported engine: " + to_string(engine));
     }
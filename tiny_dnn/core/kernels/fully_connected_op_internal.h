@@ -19,8 +19,8 @@ inline void fully_connected_op_internal(const tensor_t &in_data,
                                         const core::fully_params &params,
                                         const bool layer_parallelize) {
   for_i(layer_parallelize, in_data.size(), [&](size_t sample) {
-    const vec_t &in = in_data[sample];
-    vec_t &out      = out_data[sample];
+    const row_t &in = in_data[sample];
+    row_t &out      = out_data[sample];
 
     for (size_t i = 0; i < params.out_size_; i++) {
       out[i] = float_t{0};
@@ -100,8 +100,8 @@ inline void global_avepool_op_avx(const tensor_t &in_data,
   __m128 pool_area_inv_m = _mm_div_ss(one_m, pool_area_m);
 
   for_i(layer_parallelize, in_data.size(), [&](size_t sample) {
-    const vec_t &in = in_data[sample];
-    vec_t &out      = out_data[sample];
+    const row_t &in = in_data[sample];
+    row_t &out      = out_data[sample];
     for (size_t i = 0; i < params.in.depth_; i++) {
       const float *pin = &in[i * pool_area];
       __m256 sum0 =
@@ -132,8 +132,8 @@ inline void global_avepool_grad_op_avx(
     _mm256_loadu_si256((__m256i const *)(mask_src + 8 - nremains_per_channel));
 
   for_i(layer_parallelize, prev_delta.size(), [&](size_t sample) {
-    vec_t &prev       = prev_delta[sample];
-    const vec_t &curr = curr_delta[sample];
+    row_t &prev       = prev_delta[sample];
+    const row_t &curr = curr_delta[sample];
 
     for (size_t i = 0; i < params.in.depth_; i++) {
       size_t j            = 0;
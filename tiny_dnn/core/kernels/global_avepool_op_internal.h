@@ -16,8 +16,8 @@ inline void global_avepool_op_internal(
   const core::global_avepool_params &params,
   const bool layer_parallelize) {
   for_i(layer_parallelize, in_data.size(), [&](size_t sample) {
-    const vec_t &in = in_data[sample];
-    vec_t &out      = out_data[sample];
+    const row_t &in = in_data[sample];
+    row_t &out      = out_data[sample];
 
     const size_t pool_area = params.in.width_ * params.in.height_;
     for (size_t i = 0; i < params.in.depth_; i++) {
@@ -35,8 +35,8 @@ inline void global_avepool_grad_op_internal(
   const core::global_avepool_params &params,
   const bool layer_parallelize) {
   for_i(layer_parallelize, prev_delta.size(), [&](size_t sample) {
-    vec_t &prev       = prev_delta[sample];
-    const vec_t &curr = curr_delta[sample];
+    row_t &prev       = prev_delta[sample];
+    const row_t &curr = curr_delta[sample];
 
     const size_t pool_area = params.in.width_ * params.in.height_;
     for (size_t i = 0; i < params.in.depth_; i++) {
@@ -0,0 +1,159 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+
+#include "tiny_dnn/core/kernels/tiny_gemm_kernel.h"
+#include "tiny_dnn/core/params/lstm_cell_params.h"
+
+namespace tiny_dnn {
+namespace kernels {
+
+/**
+ * Forward pass of the LSTM cell over a batch.
+ *
+ * The four gates of every sample are one row of
+ *   [x(t), h(t-1)] * W + b
+ * computed by a single gemm over the batch, W being (in + out) x 4 out with
+ * the columns of the input, forget, cell and output gates side by side.
+ * The state update is then fused into one pass over each row:
+ *   c(t) = f * c(t-1) + i * g,  h(t) = o * tanh(c(t))
+ *
+ * xh and gates are per-sample buffers of xh_size() and gates_size() values,
+ * left holding [x(t), h(t-1)] and the activated gates for the backward pass.
+ **/
+inline void lstm_cell_op_internal(const tensor_t &in_data,
+                                  const tensor_t &prev_h,
+                                  const tensor_t &prev_c,
+                                  const vec_t &W,
+                                  const vec_t &bias,
+                                  tensor_t &out_h,
+                                  tensor_t &out_c,
+                                  tensor_t &xh,
+                                  tensor_t &gates,
+                                  const core::lstm_cell_params &params,
+                                  const bool layer_parallelize) {
+  const size_t in_size  = params.in_size_;
+  const size_t out_size = params.out_size_;
+
+  for_i(layer_parallelize, in_data.size(), [&](size_t sample) {
+    std::copy(in_data[sample].begin(), in_data[sample].end(),
+              xh[sample].begin());
+    std::copy(prev_h[sample].begin(), prev_h[sample].end(),
+              xh[sample].begin() + in_size);
+    if (params.has_bias_) {
+      std::copy(bias.begin(), bias.end(), gates[sample].begin());
+    } else {
+      vectorize::fill(&gates[sample][0], params.gates_size(), float_t{0});
+    }
+  });
+
+  core::kernels::tiny_gemm_nn(xh, &W[0], params.xh_size(),
+                              params.gates_size(), gates, layer_parallelize);
+
+  for_i(layer_parallelize, in_data.size(), [&](size_t sample) {
+    float_t *i        = &gates[sample][0];
+    float_t *f        = i + out_size;
+    float_t *g        = f + out_size;
+    float_t *o        = g + out_size;
+    const float_t *c0 = &prev_c[sample][0];
+    float_t *c        = &out_c[sample][0];
+    float_t *h        = &out_h[sample][0];
+
+    // i and f are side by side, so that one call activates both
+    vectorize::sigmoid(i, 2 * out_size, i);
+    vectorize::tanh(g, out_size, g);
+    vectorize::sigmoid(o, out_size, o);
+    for (size_t j = 0; j < out_size; j++) {
+      c[j] = f[j] * c0[j] + i[j] * g[j];
+    }
+    vectorize::tanh(c, out_size, h);
+    for (size_t j = 0; j < out_size; j++) {
+      h[j] *= o[j];
+    }
+  });
+}
+
+/**
+ * Backward pass of lstm_cell_op_internal. The gate gradients of every sample
+ * are formed in one fused pass (written over dgates), then
+ *   d[x(t), h(t-1)] = dgates * W^T,  dW += [x(t), h(t-1)]^T * dgates
+ * are one gemm each over the batch; like the recurrent cell, dW and db are
+ * summed into their first sample.
+ **/
+inline void lstm_cell_op_internal(const tensor_t &prev_c,
+                                  const vec_t &W,
+                                  tensor_t &dW,
+                                  tensor_t &db,
+                                  const tensor_t &out_c,
+                                  const tensor_t &curr_h_delta,
+                                  const tensor_t &curr_c_delta,
+                                  tensor_t &prev_out_delta,
+                                  tensor_t &prev_h_delta,
+                                  tensor_t &prev_c_delta,
+                                  const tensor_t &xh,
+                                  const tensor_t &gates,
+                                  tensor_t &dgates,
+                                  tensor_t &dxh,
+                                  const core::lstm_cell_params &params,
+                                  const bool layer_parallelize) {
+  const size_t in_size  = params.in_size_;
+  const size_t out_size = params.out_size_;
+
+  for_i(layer_parallelize, xh.size(), [&](size_t sample) {
+    const float_t *i  = &gates[sample][0];
+    const float_t *f  = i + out_size;
+    const float_t *g  = f + out_size;
+    const float_t *o  = g + out_size;
+    const float_t *c0 = &prev_c[sample][0];
+    const float_t *c  = &out_c[sample][0];
+    const float_t *dh = &curr_h_delta[sample][0];
+    const float_t *dc = &curr_c_delta[sample][0];
+    float_t *di       = &dgates[sample][0];
+    float_t *df       = di + out_size;
+    float_t *dg       = df + out_size;
+    float_t *d_o      = dg + out_size;
+    float_t *dc0      = &prev_c_delta[sample][0];
+
+    // tanh(c) goes first where d_o is formed
+    vectorize::tanh(c, out_size, d_o);
+    for (size_t j = 0; j < out_size; j++) {
+      const float_t tc  = d_o[j];
+      const float_t dcj = dc[j] + dh[j] * o[j] * (float_t(1) - tc * tc);
+      // gradients of the gate pre-activations
+      di[j]  = dcj * g[j] * i[j] * (float_t(1) - i[j]);
+      df[j]  = dcj * c0[j] * f[j] * (float_t(1) - f[j]);
+      dg[j]  = dcj * i[j] * (float_t(1) - g[j] * g[j]);
+      d_o[j] = dh[j] * tc * o[j] * (float_t(1) - o[j]);
+      dc0[j] = dcj * f[j];
+    }
+    vectorize::fill(&dxh[sample][0], params.xh_size(), float_t{0});
+  });
+
+  // \delta gates -W-> \delta [x(t), h(t-1)]
+  core::kernels::tiny_gemm_nt(dgates, &W[0], params.xh_size(),
+                              params.gates_size(), dxh, layer_parallelize);
+
+  for_i(layer_parallelize, xh.size(), [&](size_t sample) {
+    const float_t *d = &dxh[sample][0];
+    std::copy(d, d + in_size, prev_out_delta[sample].begin());
+    std::copy(d + in_size, d + in_size + out_size,
+              prev_h_delta[sample].begin());
+  });
+
+  core::kernels::tiny_gemm_tn(xh, dgates, params.xh_size(),
+                              params.gates_size(), &dW[0][0],
+                              layer_parallelize);
+  if (params.has_bias_) {
+    core::kernels::tiny_sum_rows(dgates, params.gates_size(), &db[0][0]);
+  }
+}
+
+}  // namespace kernels
+}  // namespace tiny_dnn
@@ -19,8 +19,8 @@ inline void maxpool_op_internal(const tensor_t &in_data,
                                 const std::vector<std::vector<size_t>> &out2in,
                                 const bool layer_parallelize) {
   for_i(layer_parallelize, in_data.size(), [&](size_t sample) {
-    const vec_t &in          = in_data[sample];
-    vec_t &out               = out_data[sample];
+    const row_t &in          = in_data[sample];
+    row_t &out               = out_data[sample];
     std::vector<size_t> &max = max_idx[sample];
 
     for (size_t i = 0; i < out2in.size(); i++) {
@@ -45,8 +45,8 @@ inline void maxpool_grad_op_internal(tensor_t &prev_delta,
                                      const std::vector<size_t> &in2out,
                                      const bool layer_parallelize) {
   for_i(layer_parallelize, prev_delta.size(), [&](size_t sample) {
-    vec_t &prev                    = prev_delta[sample];
-    const vec_t &curr              = curr_delta[sample];
+    row_t &prev                    = prev_delta[sample];
+    const row_t &curr              = curr_delta[sample];
     const std::vector<size_t> &max = max_idx[sample];
 
     for (size_t i = 0; i < in2out.size(); i++) {
@@ -19,7 +19,7 @@ class RecurrentCellGradOp : public core::OpKernel {
     : core::OpKernel(context) {}
 
   void compute(core::OpKernelContext &context) override {
-    auto params = OpKernel::params_->recurrent_cell();
+    const auto &params = OpKernel::params_->recurrent_cell();
     // incoming/outcoming data
     const tensor_t &prev_out = context.input(0);
     const tensor_t &h        = context.input(1);
@@ -18,7 +18,7 @@ class RecurrentCellOp : public core::OpKernel {
     : core::OpKernel(context) {}
 
   void compute(core::OpKernelContext &context) override {
-    auto params = OpKernel::params_->recurrent_cell();
+    const auto &params = OpKernel::params_->recurrent_cell();
 
     // incomimg/outcoming data
     const tensor_t &in_data = context.input(0);
@@ -31,6 +31,11 @@ class RecurrentCellOp : public core::OpKernel {
     tensor_t &out_data      = context.output(0);
     tensor_t &next_h        = context.output(1);
 
+    // referred to, not copied
+    const vec_t no_bias;
+    const vec_t &b  = params.has_bias_ ? (*bias)[0] : no_bias;
+    const vec_t &c0 = params.has_bias_ ? (*c)[0] : no_bias;
+
     // initialize outputs
     fill_tensor(out_data, float_t{0});
     fill_tensor(next_h, float_t{0});
@@ -41,9 +46,7 @@ class RecurrentCellOp : public core::OpKernel {
 
     if (engine == core::backend_t::internal || engine == core::backend_t::avx) {
       kernels::recurrent_cell_op_internal(
-        in_data, prev_h, U[0], W[0], V[0],
-        params.has_bias_ ? (*bias)[0] : vec_t(),
-        params.has_bias_ ? (*c)[0] : vec_t(), out_data, next_h, params,
+        in_data, prev_h, U[0], W[0], V[0], b, c0, out_data, next_h, params,
         context.parallelize());
     } else {
       throw nn_error("Not supported engine: " + to_string(engine));
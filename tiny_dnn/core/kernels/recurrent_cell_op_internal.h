@@ -7,11 +7,32 @@
 */
 #pragma once
 
+#include "tiny_dnn/core/kernels/tiny_gemm_kernel.h"
 #include "tiny_dnn/core/params/recurrent_cell_params.h"
 
 namespace tiny_dnn {
 namespace kernels {
 
+/**
+ * out_h += U*x(t) + b for every sample of the batch: the part of the state
+ * that does not depend on h(t-1), computed as a single gemm.
+ **/
+inline void recurrent_cell_input_projection(
+  const tensor_t &in_data,
+  const vec_t &U,
+  const vec_t &bias,
+  tensor_t &out_h,
+  const core::recurrent_cell_params &params,
+  const bool layer_parallelize) {
+  core::kernels::tiny_gemm_nn(in_data, &U[0], params.in_size_,
+                              params.out_size_, out_h, layer_parallelize);
+  if (params.has_bias_) {
+    for (auto &h : out_h) {
+      vectorize::reduce<float_t>(&bias[0], params.out_size_, &h[0]);
+    }
+  }
+}
+
 inline void recurrent_cell_op_internal(
   const tensor_t &in_data,
   const tensor_t &prev_h,
@@ -24,48 +45,33 @@ inline void recurrent_cell_op_internal(
   tensor_t &out_h,
   const core::recurrent_cell_params &params,
   const bool layer_parallelize) {
-  for_i(layer_parallelize, in_data.size(), [&](size_t sample) {
-    const vec_t &in         = in_data[sample];
-    const vec_t &prev_state = prev_h[sample];
-    vec_t &out              = out_data[sample];
-    vec_t &next_state       = out_h[sample];
-
-    for (size_t o = 0; o < params.out_size_; o++) {
-      float_t next_state_ = 0;
-
-      // W * h(t-1)
-      for (size_t o_2 = 0; o_2 < params.out_size_; o_2++) {
-        next_state_ += W[o_2 * params.out_size_ + o] * prev_state[o_2];
-      }
-
-      // U*x(t)
-      for (size_t i = 0; i < params.in_size_; i++) {
-        next_state_ += U[i * params.out_size_ + o] * in[i];
-      }
-
-      if (params.has_bias_) {
-        next_state_ += bias[o];
-      }
-      next_state[o] = next_state_;
-    }
+  // U*x(t) + b
+  recurrent_cell_input_projection(in_data, U, bias, out_h, params,
+                                  layer_parallelize);
 
-    params.activation_->forward_activation(next_state, next_state);
+  // W * h(t-1)
+  core::kernels::tiny_gemm_nn(prev_h, &W[0], params.out_size_,
+                              params.out_size_, out_h, layer_parallelize);
 
-    // V matrix is out_size_ x out_size_
-    for (size_t o = 0; o < params.out_size_; o++) {
-      float_t out_ = 0;
-      for (size_t o_2 = 0; o_2 < params.out_size_; o_2++) {
-        out_ += V[o_2 * params.out_size_ + o] * next_state[o_2];
-      }
+  for_i(layer_parallelize, out_h.size(), [&](size_t sample) {
+    params.activation_->forward_activation(out_h[sample], out_h[sample]);
+  });
 
-      if (params.has_bias_) {
-        out_ += c[o];
-      }
-      out[o] = out_;
+  // V matrix is out_size_ x out_size_
+  core::kernels::tiny_gemm_nn(out_h, &V[0], params.out_size_,
+                              params.out_size_, out_data, layer_parallelize);
+  if (params.has_bias_) {
+    for (auto &out : out_data) {
+      vectorize::reduce<float_t>(&c[0], params.out_size_, &out[0]);
     }
-  });
+  }
 }
 
+/**
+ * The weight gradients of the whole batch are summed into the first sample
+ * of dU, dW, dV, db and dc (as one gemm each instead of one outer product
+ * per sample); update_weight merges the samples anyway.
+ **/
 inline void recurrent_cell_op_internal(
   const tensor_t &prev_out,
   const tensor_t &prev_h,
@@ -84,79 +90,39 @@ inline void recurrent_cell_op_internal(
   const tensor_t &out_h,
   const core::recurrent_cell_params &params,
   const bool layer_parallelize) {
-  for (size_t sample = 0; sample < prev_out.size(); sample++) {
-    const vec_t &prev_out_          = prev_out[sample];
-    const vec_t &prev_h_            = prev_h[sample];
-    vec_t &dU_                      = dU[sample];
-    vec_t &dW_                      = dW[sample];
-    vec_t &dV_                      = dV[sample];
-    vec_t &db_                      = db[sample];
-    vec_t &dc_                      = dc[sample];
-    const vec_t &curr_output_delta_ = curr_output_delta[sample];
-    vec_t &curr_state_delta_        = curr_state_delta[sample];
-    vec_t &prev_output_delta_       = prev_output_delta[sample];
-    vec_t &prev_state_delta_        = prev_state_delta[sample];
-    const vec_t &out_h_             = out_h[sample];
-
-    // from output to h
-    for (size_t o = 0; o < params.out_size_; o++) {
-      // propagate delta from output to h.
-      curr_state_delta_[o] += vectorize::dot(
-        &curr_output_delta_[0], &V[o * params.out_size_], params.out_size_);
-    }
+  const size_t out_size = params.out_size_;
 
-    // h'(t)
-    params.activation_->backward_activation(prev_h_, out_h_, curr_state_delta_,
-                                            curr_state_delta_);
+  // propagate delta from output to h.
+  core::kernels::tiny_gemm_nt(curr_output_delta, &V[0], out_size, out_size,
+                              curr_state_delta, layer_parallelize);
 
-    // \delta h(t) -W-> h(t-1)
-    for (size_t o = 0; o < params.out_size_; o++) {
-      prev_state_delta_[o] += vectorize::dot(
-        &curr_state_delta_[0], &W[o * params.out_size_], params.out_size_);
-    }
-
-    // \delta h(t) -U-> \delta x(t)
-    for (size_t i = 0; i < params.in_size_; i++) {
-      prev_output_delta_[i] += vectorize::dot(
-        &curr_state_delta_[0], &U[i * params.out_size_], params.out_size_);
-    }
+  // h'(t)
+  for_i(layer_parallelize, prev_out.size(), [&](size_t sample) {
+    params.activation_->backward_activation(
+      prev_h[sample], out_h[sample], curr_state_delta[sample],
+      curr_state_delta[sample]);
+  });
 
-    for_(layer_parallelize, 0, size_t(params.out_size_),
-         [&](const blocked_range &r) {
-           // accumulate weight-step using delta
-           // dW[c * out_size + i] += current_delta[i] * prev_out[o]
-           const size_t begin  = r.begin();
-           const size_t end    = r.end();
-           const size_t stride = end - begin;
-           for (size_t o = 0; o < params.out_size_; o++) {
-             vectorize::muladd(&curr_output_delta_[begin], out_h_[o], stride,
-                               &dV_[o * params.out_size_ + begin]);
-           }
-
-           if (params.has_bias_) {
-             // vec_t& dc;
-             for (size_t o = begin; o < end; o++) {
-               dc_[o] += curr_output_delta_[o];
-             }
-           }
-
-           for (size_t o = 0; o < params.out_size_; o++) {
-             vectorize::muladd(&curr_state_delta_[begin], prev_h_[o], stride,
-                               &dW_[o * params.out_size_ + begin]);
-           }
-
-           for (size_t i = 0; i < params.in_size_; i++) {
-             vectorize::muladd(&curr_state_delta[sample][begin], prev_out_[i],
-                               stride, &dU_[i * params.out_size_ + begin]);
-           }
-
-           if (params.has_bias_) {
-             // vec_t& db;
-             for (size_t o = begin; o < end; o++) {
-               db_[o] += curr_state_delta_[o];
-             }
-           }
-         });
+  // \delta h(t) -W-> h(t-1)
+  core::kernels::tiny_gemm_nt(curr_state_delta, &W[0], out_size, out_size,
+                              prev_state_delta, layer_parallelize);
+
+  // \delta h(t) -U-> \delta x(t)
+  core::kernels::tiny_gemm_nt(curr_state_delta, &U[0], params.in_size_,
+                              out_size, prev_output_delta, layer_parallelize);
+
+  // accumulate weight-step using delta
+  // dV[o * out_size + i] += sum_sample curr_output_delta[i] * out_h[o]
+  core::kernels::tiny_gemm_tn(out_h, curr_output_delta, out_size, out_size,
+                              &dV[0][0], layer_parallelize);
+  core::kernels::tiny_gemm_tn(prev_h, curr_state_delta, out_size, out_size,
+                              &dW[0][0], layer_parallelize);
+  core::kernels::tiny_gemm_tn(prev_out, curr_state_delta, params.in_size_,
+                              out_size, &dU[0][0], layer_parallelize);
+
+  if (params.has_bias_) {
+    core::kernels::tiny_sum_rows(curr_output_delta, out_size, &dc[0][0]);
+    core::kernels::tiny_sum_rows(curr_state_delta, out_size, &db[0][0]);
   }
 }
 
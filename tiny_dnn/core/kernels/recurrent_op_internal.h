@@ -0,0 +1,187 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include "tiny_dnn/core/kernels/tiny_gemm_kernel.h"
+#include "tiny_dnn/core/params/recurrent_params.h"
+#include "tiny_dnn/util/sequence_batch.h"
+
+namespace tiny_dnn {
+namespace kernels {
+
+/**
+ * Forward pass of a recurrent layer over whole sequences.
+ *
+ * Every sample of in_data holds seq_len_ steps of in_size_ values, and every
+ * sample of out_data seq_len_ steps of out_size_ values, of which only the
+ * first seq.lengths()[sample] are computed. The steps are addressed as the
+ * packed rows of seq (time-major, longest sequences first): pre holds the
+ * packed_size() pre-activations and h the batch_size() + packed_size()
+ * states, the first batch_size() rows of h being the initial state h(-1) of
+ * each rank.
+ *
+ * U*x(t) + b and V*h(t) + c don't depend on the recurrence and are computed
+ * for all the steps with one gemm each, only W*h(t-1) runs step by step, on
+ * the sequences still active at that step. pre and out_data are expected to
+ * be zero.
+ **/
+inline void recurrent_op_internal(const tensor_t &in_data,
+                                  const vec_t &U,
+                                  const vec_t &W,
+                                  const vec_t &V,
+                                  const vec_t &bias,
+                                  const vec_t &c,
+                                  tensor_t &out_data,
+                                  tensor_t &pre,
+                                  tensor_t &h,
+                                  const sequence_batch &seq,
+                                  const core::recurrent_params &params,
+                                  const bool layer_parallelize) {
+  const size_t batch    = seq.batch_size();
+  const size_t rows     = seq.packed_size();
+  const size_t in_size  = params.in_size_;
+  const size_t out_size = params.out_size_;
+
+  auto x = [&](size_t r) {
+    return &in_data[seq.sample(seq.packed_rank(r))]
+                   [seq.packed_step(r) * in_size];
+  };
+  auto y = [&](size_t r) {
+    return &out_data[seq.sample(seq.packed_rank(r))]
+                    [seq.packed_step(r) * out_size];
+  };
+  auto p = [&](size_t r) { return &pre[r][0]; };
+  auto s = [&](size_t r) { return &h[batch + r][0]; };
+
+  // U*x(t) + b
+  core::kernels::tiny_gemm_nn(rows, x, &U[0], in_size, out_size, p,
+                              layer_parallelize);
+  if (params.has_bias_) {
+    for (size_t r = 0; r < rows; r++) {
+      vectorize::reduce<float_t>(&bias[0], out_size, p(r));
+    }
+  }
+
+  for (size_t t = 0; t < seq.steps() && seq.active(t) > 0; t++) {
+    const size_t r0      = seq.offset(t);
+    const size_t r0_prev = t > 0 ? batch + seq.offset(t - 1) : 0;
+
+    // W * h(t-1)
+    core::kernels::tiny_gemm_nn(
+      seq.active(t), [&](size_t k) { return &h[r0_prev + k][0]; }, &W[0],
+      out_size, out_size, [&](size_t k) { return p(r0 + k); },
+      layer_parallelize);
+
+    for_i(layer_parallelize, seq.active(t), [&](size_t k) {
+      params.activation_->forward_activation(pre[r0 + k], h[batch + r0 + k]);
+    });
+  }
+
+  // V*h(t) + c
+  core::kernels::tiny_gemm_nn(rows, s, &V[0], out_size, out_size, y,
+                              layer_parallelize);
+  if (params.has_bias_) {
+    for (size_t r = 0; r < rows; r++) {
+      vectorize::reduce<float_t>(&c[0], out_size, y(r));
+    }
+  }
+}
+
+/**
+ * Backward pass of recurrent_op_internal, dh being packed_size() rows of
+ * zeros used for the state gradients. The state gradient only flows from
+ * step t to t-1 within the same window of bptt_ steps; the gradients of the
+ * padding are ignored, and prev_delta is left untouched there.
+ *
+ * Like the recurrent cell, the weight gradients of the whole batch are
+ * summed into the first sample of dU, dW, dV, db and dc.
+ **/
+inline void recurrent_op_internal(const tensor_t &in_data,
+                                  const vec_t &U,
+                                  const vec_t &W,
+                                  const vec_t &V,
+                                  tensor_t &dU,
+                                  tensor_t &dW,
+                                  tensor_t &dV,
+                                  tensor_t &db,
+                                  tensor_t &dc,
+                                  const tensor_t &curr_delta,
+                                  tensor_t &prev_delta,
+                                  const tensor_t &pre,
+                                  const tensor_t &h,
+                                  tensor_t &dh,
+                                  const sequence_batch &seq,
+                                  const core::recurrent_params &params,
+                                  const bool layer_parallelize) {
+  const size_t batch    = seq.batch_size();
+  const size_t rows     = seq.packed_size();
+  const size_t in_size  = params.in_size_;
+  const size_t out_size = params.out_size_;
+
+  auto x = [&](size_t r) {
+    return &in_data[seq.sample(seq.packed_rank(r))]
+                   [seq.packed_step(r) * in_size];
+  };
+  auto dx = [&](size_t r) {
+    return &prev_delta[seq.sample(seq.packed_rank(r))]
+                      [seq.packed_step(r) * in_size];
+  };
+  auto dy = [&](size_t r) {
+    return &curr_delta[seq.sample(seq.packed_rank(r))]
+                      [seq.packed_step(r) * out_size];
+  };
+  auto s      = [&](size_t r) { return &h[batch + r][0]; };
+  auto s_prev = [&](size_t r) {
+    const size_t t = seq.packed_step(r);
+    const size_t k = seq.packed_rank(r);
+    return t > 0 ? &h[batch + seq.offset(t - 1) + k][0] : &h[k][0];
+  };
+  auto ds = [&](size_t r) { return &dh[r][0]; };
+
+  // from output to h, and the output weights
+  core::kernels::tiny_gemm_nt(rows, dy, &V[0], out_size, out_size, ds,
+                              layer_parallelize);
+  core::kernels::tiny_gemm_tn(rows, s, dy, out_size, out_size, &dV[0][0],
+                              layer_parallelize);
+  if (params.has_bias_) {
+    core::kernels::tiny_sum_rows(rows, dy, out_size, &dc[0][0]);
+  }
+
+  for (size_t t = seq.steps(); t-- > 0;) {
+    const size_t r0 = seq.offset(t);
+
+    // h'(t)
+    for_i(layer_parallelize, seq.active(t), [&](size_t k) {
+      params.activation_->backward_activation(pre[r0 + k], h[batch + r0 + k],
+                                              dh[r0 + k], dh[r0 + k]);
+    });
+
+    // \delta h(t) -W-> h(t-1), cut at the window boundaries
+    if (t > 0 && (params.bptt_ == 0 || t % params.bptt_ != 0)) {
+      const size_t r0_prev = seq.offset(t - 1);
+      core::kernels::tiny_gemm_nt(
+        seq.active(t), [&](size_t k) { return ds(r0 + k); }, &W[0], out_size,
+        out_size, [&](size_t k) { return ds(r0_prev + k); },
+        layer_parallelize);
+    }
+  }
+
+  // \delta h(t) -U-> \delta x(t), and the input and transition weights
+  core::kernels::tiny_gemm_nt(rows, ds, &U[0], in_size, out_size, dx,
+                              layer_parallelize);
+  core::kernels::tiny_gemm_tn(rows, s_prev, ds, out_size, out_size, &dW[0][0],
+                              layer_parallelize);
+  core::kernels::tiny_gemm_tn(rows, x, ds, in_size, out_size, &dU[0][0],
+                              layer_parallelize);
+  if (params.has_bias_) {
+    core::kernels::tiny_sum_rows(rows, ds, out_size, &db[0][0]);
+  }
+}
+
+}  // namespace kernels
+}  // namespace tiny_dnn
@@ -0,0 +1,113 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "tiny_dnn/core/kernels/tiny_quantization_kernel.h"
+#include "tiny_dnn/core/params/params.h"
+#include "tiny_dnn/util/util.h"
+
+namespace tiny_dnn {
+namespace core {
+namespace kernels {
+
+// rounds every value to the nearest of the 256 levels of [min, max]
+inline void fake_quantize(const vec_t &in,
+                          float_t min,
+                          float_t max,
+                          vec_t *out) {
+  out->resize(in.size());
+  for (size_t i = 0; i < in.size(); i++) {
+    (*out)[i] = quantized_to_float<uint8_t>(
+      float_to_quantized<uint8_t>(in[i], min, max), min, max);
+  }
+}
+
+// range of the values in t, zero included
+inline quantization_range tensor_range(const tensor_t &t) {
+  quantization_range r;
+  for (const auto &v : t) {
+    for (const auto x : v) {
+      r.min = std::min(r.min, x);
+      r.max = std::max(r.max, x);
+    }
+  }
+  return r;
+}
+
+inline void update_moving_range(const tensor_t &t,
+                                float_t momentum,
+                                quantization_range *range) {
+  const quantization_range observed = tensor_range(t);
+  if (!range->is_static()) {
+    *range = observed;
+    return;
+  }
+  range->min = momentum * range->min + (1 - momentum) * observed.min;
+  range->max = momentum * range->max + (1 - momentum) * observed.max;
+}
+
+/**
+ * replaces the input and the weights in in_data by fake-quantized copies
+ * kept in buf. The input is rounded in the moving input range (updated
+ * first in train phase), the weights and the bias in their own min/max
+ * range like tiny_quantize_conv2d_weights does.
+ **/
+inline void fake_quantize_inputs(fake_quantization_params *params,
+                                 bool train,
+                                 std::vector<tensor_t *> *in_data,
+                                 std::vector<tensor_t> *buf) {
+  std::vector<tensor_t *> &in = *in_data;
+  buf->resize(in.size());
+
+  if (train || !params->in_range.is_static()) {
+    update_moving_range(*in[0], params->momentum, &params->in_range);
+  }
+  (*buf)[0].resize(in[0]->size());
+  for (size_t s = 0; s < in[0]->size(); s++) {
+    fake_quantize((*in[0])[s], params->in_range.min, params->in_range.max,
+                  &(*buf)[0][s]);
+  }
+
+  for (size_t i = 1; i < in.size(); i++) {
+    const row_t &w = (*in[i])[0];
+    float_t min    = *std::min_element(w.begin(), w.end());
+    float_t max    = *std::max_element(w.begin(), w.end());
+    // the quantized kernels keep zero inside the bias range
+    if (i == 2) {
+      min = std::min(min, float_t{0});
+      max = std::max(max, float_t{0});
+    }
+    if (min == max) {
+      min = w[0] - float_t(1e-3);
+      max = w[0] + float_t(1e-3);
+    }
+    (*buf)[i].resize(1);
+    fake_quantize(w, min, max, &(*buf)[i][0]);
+  }
+
+  for (size_t i = 0; i < in.size(); i++) in[i] = &(*buf)[i];
+}
+
+// rounds the output in place to the moving output range
+inline void fake_quantize_output(fake_quantization_params *params,
+                                 bool train,
+                                 tensor_t *out) {
+  if (train || !params->out_range.is_static()) {
+    update_moving_range(*out, params->momentum, &params->out_range);
+  }
+  for (auto &v : *out) {
+    fake_quantize(v, params->out_range.min, params->out_range.max, &v);
+  }
+}
+
+}  // namespace kernels
+}  // namespace core
+}  // namespace tiny_dnn
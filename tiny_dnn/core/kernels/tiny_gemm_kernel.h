@@ -0,0 +1,183 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+
+#include "tiny_dnn/util/util.h"
+
+namespace tiny_dnn {
+namespace core {
+namespace kernels {
+
+/**
+ * Float matrix products over a batch, where the batch side is a set of rows
+ * (one per sample, or one per sample and timestep) and the weight side is a
+ * row-major matrix.
+ *
+ * The batch side is addressed through row accessors, callables returning a
+ * pointer to the r-th row, so that a tensor_t and a strided buffer can be
+ * used alike; the overloads taking tensor_t cover the common case.
+ *
+ * The inner loops are vectorize::muladd / vectorize::dot over contiguous
+ * rows; the rows are processed in blocks of tiny_gemm_rows() so that a
+ * block of columns of the weight matrix is reused from cache by every row
+ * of the block.
+ **/
+inline size_t tiny_gemm_rows() { return 4; }
+
+inline size_t tiny_gemm_cols() { return 256; }
+
+/**
+ * C(r)[j] += sum_k A(r)[k] * B[k * n + j] for r in [0, m)
+ *
+ * @param A  accessor of m rows of k values
+ * @param B  k x n row-major matrix
+ * @param C  accessor of m rows of n values
+ **/
+template <typename RowA, typename RowC>
+void tiny_gemm_nn(size_t m,
+                  RowA A,
+                  const float_t *B,
+                  size_t k,
+                  size_t n,
+                  RowC C,
+                  bool parallelize) {
+  const size_t rows   = tiny_gemm_rows();
+  const size_t blocks = (m + rows - 1) / rows;
+
+  for_i(parallelize, blocks, [&](size_t block) {
+    const size_t r_begin = block * rows;
+    const size_t r_end   = std::min(m, r_begin + rows);
+
+    for (size_t j = 0; j < n; j += tiny_gemm_cols()) {
+      const size_t len = std::min(tiny_gemm_cols(), n - j);
+      for (size_t kk = 0; kk < k; kk++) {
+        const float_t *b = &B[kk * n + j];
+        for (size_t r = r_begin; r < r_end; r++) {
+          vectorize::muladd(b, A(r)[kk], len, C(r) + j);
+        }
+      }
+    }
+  });
+}
+
+/**
+ * C(r)[i] += sum_j A(r)[j] * B[i * n + j] for r in [0, m)
+ *
+ * @param A  accessor of rows of n values
+ * @param B  k x n row-major matrix
+ * @param C  accessor of rows of k values
+ **/
+template <typename RowA, typename RowC>
+void tiny_gemm_nt(size_t m,
+                  RowA A,
+                  const float_t *B,
+                  size_t k,
+                  size_t n,
+                  RowC C,
+                  bool parallelize) {
+  for_i(parallelize, m, [&](size_t r) {
+    const float_t *a = A(r);
+    float_t *c       = C(r);
+    for (size_t i = 0; i < k; i++) {
+      c[i] += vectorize::dot(a, &B[i * n], n);
+    }
+  });
+}
+
+/**
+ * C[i * n + j] += sum_r A(r)[i] * B(r)[j], the sum over the rows of the
+ * outer products of A and B (the weight gradient of a tiny_gemm_nn).
+ *
+ * @param A  accessor of m rows of k values
+ * @param B  accessor of m rows of n values
+ * @param C  k x n row-major matrix
+ **/
+template <typename RowA, typename RowB>
+void tiny_gemm_tn(size_t m,
+                  RowA A,
+                  RowB B,
+                  size_t k,
+                  size_t n,
+                  float_t *C,
+                  bool parallelize) {
+  for_(parallelize, 0, k, [&](const blocked_range &range) {
+    for (size_t r = 0; r < m; r++) {
+      const float_t *a = A(r);
+      const float_t *b = B(r);
+      for (size_t i = range.begin(); i < range.end(); i++) {
+        vectorize::muladd(b, a[i], n, &C[i * n]);
+      }
+    }
+  });
+}
+
+/**
+ * dst[j] += sum_r src(r)[j] for r in [0, m)
+ **/
+template <typename Row>
+void tiny_sum_rows(size_t m, Row src, size_t n, float_t *dst) {
+  for (size_t r = 0; r < m; r++) {
+    vectorize::reduce<float_t>(src(r), n, dst);
+  }
+}
+
+namespace detail {
+
+struct tensor_rows {
+  explicit tensor_rows(const tensor_t &t) : t_(&t) {}
+  const float_t *operator()(size_t r) const { return &(*t_)[r][0]; }
+  const tensor_t *t_;
+};
+
+struct mutable_tensor_rows {
+  explicit mutable_tensor_rows(tensor_t &t) : t_(&t) {}
+  float_t *operator()(size_t r) const { return &(*t_)[r][0]; }
+  tensor_t *t_;
+};
+
+}  // namespace detail
+
+inline void tiny_gemm_nn(const tensor_t &A,
+                         const float_t *B,
+                         size_t k,
+                         size_t n,
+                         tensor_t &C,
+                         bool parallelize) {
+  tiny_gemm_nn(A.size(), detail::tensor_rows(A), B, k, n,
+               detail::mutable_tensor_rows(C), parallelize);
+}
+
+inline void tiny_gemm_nt(const tensor_t &A,
+                         const float_t *B,
+                         size_t k,
+                         size_t n,
+                         tensor_t &C,
+                         bool parallelize) {
+  tiny_gemm_nt(A.size(), detail::tensor_rows(A), B, k, n,
+               detail::mutable_tensor_rows(C), parallelize);
+}
+
+inline void tiny_gemm_tn(const tensor_t &A,
+                         const tensor_t &B,
+                         size_t k,
+                         size_t n,
+                         float_t *C,
+                         bool parallelize) {
+  tiny_gemm_tn(A.size(), detail::tensor_rows(A), detail::tensor_rows(B), k, n,
+               C, parallelize);
+}
+
+inline void tiny_sum_rows(const tensor_t &src, size_t n, float_t *dst) {
+  tiny_sum_rows(src.size(), detail::tensor_rows(src), n, dst);
+}
+
+}  // namespace kernels
+}  // namespace core
+}  // namespace tiny_dnn
@@ -11,10 +11,31 @@
 #include <limits>
 #include <vector>
 
+#include "tiny_dnn/core/params/params.h"
+
 namespace tiny_dnn {
 namespace core {
 namespace kernels {
 
+/**
+ * 8-bit copy of the weights and bias of a quantized layer together with the
+ * float ranges they were quantized with. Weights do not change between
+ * inference calls, so this is computed once and only the activations are
+ * quantized per sample.
+ **/
+struct quantized_weights {
+  std::vector<uint8_t> W;
+  std::vector<uint8_t> bias;
+  float_t min_filter = float_t{0};
+  float_t max_filter = float_t{0};
+  float_t min_bias   = float_t{0};
+  float_t max_bias   = float_t{0};
+  // zero-point-subtracted weights in the layout of tiny_quantized_gemm,
+  // filled only when the layer runs on the avx engine
+  std::vector<int16_t> W_packed;
+  size_t packed_k = 0;
+};
+
 template <class T>
 T highest() {
   return (std::numeric_limits<T>::max)();
@@ -186,11 +207,11 @@ inline void requantize_many_in_new_range<int32_t, uint8_t>(int32_t *input,
 }
 
 // REQUIRES: 'result->NumElements() == input.NumElements()'
-template <class T>
+template <class T, class Alloc>
 void float_tensor_to_quantized_in_place(const vec_t &input,
                                         float_t min,
                                         float_t max,
-                                        std::vector<T> *result) {
+                                        std::vector<T, Alloc> *result) {
   const size_t data_size = input.size();
   for (size_t i = 0; i < data_size; ++i) {
     (*result)[i] = float_to_quantized<T>(input[i], min, max);
@@ -207,8 +228,8 @@ std::vector<T> float_tensor_to_quantized(const vec_t &input,
 }
 
 // REQUIRES: 'result->NumElements() == input.NumElements()'
-template <class T>
-void quantized_tensor_to_float_in_place(const std::vector<T> &input,
+template <class T, class Alloc>
+void quantized_tensor_to_float_in_place(const std::vector<T, Alloc> &input,
                                         float_t min,
                                         float_t max,
                                         vec_t *result) {
@@ -227,13 +248,13 @@ vec_t quantized_tensor_to_float(const std::vector<T> &input,
   return result;
 }
 
-template <class T1, class T2>
-void quantize_down_and_shrink_range(std::vector<T1> &input,
+template <class T1, class T2, class Alloc1, class Alloc2>
+void quantize_down_and_shrink_range(std::vector<T1, Alloc1> &input,
                                     float_t min_input,
                                     float_t max_input,
                                     float_t *min_new,
                                     float_t *max_new,
-                                    std::vector<T2> *output) {
+                                    std::vector<T2, Alloc2> *output) {
   const int32_t input_lowest_quantized  = static_cast<int32_t>(lowest<T1>());
   const int32_t input_highest_quantized = static_cast<int32_t>(highest<T1>());
   T1 actual_min_quantized               = input_highest_quantized;
@@ -253,6 +274,76 @@ void quantize_down_and_shrink_range(std::vector<T1> &input,
                                                  *max_new, &(*output)[0]);
 }
 
+// the 8-bit bias code as a value in the int32 space of the accumulated
+// products, whose range is [min_output, max_output]
+inline int32_t bias_to_accumulator(uint8_t bias,
+                                   float_t min_bias,
+                                   float_t max_bias,
+                                   float_t min_output,
+                                   float_t max_output) {
+  const float_t value = quantized_to_float<uint8_t>(bias, min_bias, max_bias);
+  return int64_to_int32(
+    float_to_quantized_unclamped<int32_t>(value, min_output, max_output) -
+    float_to_quantized_unclamped<int32_t>(float_t{0}, min_output, max_output));
+}
+
+// the code standing for 0.0 in the given range
+inline uint8_t quantized_zero(const quantization_range &range) {
+  return float_to_quantized<uint8_t>(float_t{0}, range.min, range.max);
+}
+
+// In int8 execution mode edges carry the 8-bit codes themselves (stored in
+// float_t), these convert between the codes and their storage.
+template <class Alloc>
+void float_tensor_to_codes_in_place(const vec_t &input,
+                                    std::vector<uint8_t, Alloc> *result) {
+  result->resize(input.size());
+  for (size_t i = 0; i < input.size(); ++i) {
+    (*result)[i] = static_cast<uint8_t>(input[i]);
+  }
+}
+
+inline std::vector<uint8_t> float_tensor_to_codes(const vec_t &input) {
+  std::vector<uint8_t> result;
+  float_tensor_to_codes_in_place(input, &result);
+  return result;
+}
+
+template <class Alloc>
+void codes_to_float_tensor(const std::vector<uint8_t, Alloc> &input,
+                           vec_t *result) {
+  result->resize(input.size());
+  for (size_t i = 0; i < input.size(); ++i) {
+    (*result)[i] = static_cast<float_t>(input[i]);
+  }
+}
+
+// Requantizes the 32-bit accumulators of a kernel to 8 bits. A calibrated
+// output range is used as it is, otherwise the range is shrunk to the values
+// actually produced.
+template <class Alloc1, class Alloc2>
+void requantize_output(std::vector<int32_t, Alloc1> &input,
+                       float_t min_input,
+                       float_t max_input,
+                       const quantization_range &range,
+                       float_t *min_new,
+                       float_t *max_new,
+                       std::vector<uint8_t, Alloc2> *output) {
+  if (!range.is_static()) {
+    quantize_down_and_shrink_range<int32_t, uint8_t>(
+      input, min_input, max_input, min_new, max_new, output);
+    return;
+  }
+  *min_new = range.min;
+  *max_new = range.max;
+  // rounded like float_to_quantized rather than in fixed point, so that the
+  // codes match the fake quantization of quantization-aware training
+  for (size_t i = 0; i < input.size(); i++) {
+    (*output)[i] = requantize_in_new_range<int32_t, uint8_t>(
+      input[i], min_input, max_input, range.min, range.max);
+  }
+}
+
 }  // namespace kernels
 }  // namespace core
 }  // namespace tiny_dnn
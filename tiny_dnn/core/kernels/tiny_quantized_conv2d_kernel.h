@@ -11,52 +11,56 @@
 #include <vector>
 
 #include "tiny_dnn/core/kernels/tiny_quantization_kernel.h"
+#include "tiny_dnn/core/kernels/tiny_quantized_gemm_kernel.h"
 #include "tiny_dnn/core/params/conv_params.h"
 
 namespace tiny_dnn {
 namespace core {
 namespace kernels {
 
-inline void tiny_quantized_conv2d_kernel(const conv_params &params,
-                                         const vec_t &in,
+inline void tiny_quantize_conv2d_weights(const conv_params &params,
                                          const vec_t &W,
                                          const vec_t &bias,
-                                         vec_t &a,
-                                         const bool layer_parallelize) {
-  // image quantization
-  float_t min_input(in[0]);
-  float_t max_input(in[0]);
-  for (size_t inc = 0; inc < params.in.depth_; inc++) {
-    for (size_t ins = 0;
-         ins < params.in_padded.height_ * params.in_padded.height_; ins++) {
-      size_t idx = params.in_padded.get_index(0, 0, inc);
-      min_input  = std::min(min_input, (&in[idx])[ins]);
-      max_input  = std::max(max_input, (&in[idx])[ins]);
-    }
-  }
-  std::vector<uint8_t> in_quantized =
-    float_tensor_to_quantized<uint8_t>(in, min_input, max_input);
+                                         quantized_weights *qw,
+                                         const bool use_gemm = false) {
   // filter quantization
   float_t min_filter(W[0]);
   float_t max_filter(W[0]);
-  for (size_t inc = 0; inc < params.in_padded.depth_; inc++) {
-    for (size_t ins = 0; ins < params.weight.height_ * params.weight.height_;
-         ins++) {
-      size_t idx = params.in_padded.get_index(0, 0, inc);
-      min_filter = std::min(min_filter, (&W[idx])[ins]);
-      max_filter = std::max(max_filter, (&W[idx])[ins]);
-    }
+  for (size_t c = 0; c < W.size(); c++) {
+    min_filter = std::min(min_filter, W[c]);
+    max_filter = std::max(max_filter, W[c]);
   }
   if (min_filter == max_filter) {
     max_filter = W[0] + 1e-3f;
     min_filter = W[0] - 1e-3f;
   }
-  std::vector<uint8_t> W_quantized =
-    float_tensor_to_quantized<uint8_t>(W, min_filter, max_filter);
+  qw->W = float_tensor_to_quantized<uint8_t>(W, min_filter, max_filter);
+  qw->min_filter = min_filter;
+  qw->max_filter = max_filter;
+  // gemm layout: one row of in.depth * kernel area values per output channel
+  const int32_t offset_filter = int64_to_int32(
+    float_to_quantized_unclamped<uint8_t>(0.0f, min_filter, max_filter));
+  qw->W_packed.clear();
+  if (use_gemm && quantized_gemm_fits(offset_filter)) {
+    const size_t area = params.weight.width_ * params.weight.height_;
+    qw->packed_k      = quantized_gemm_padded(params.in.depth_ * area);
+    qw->W_packed.assign(params.out.depth_ * qw->packed_k, int16_t(0));
+    for (size_t o = 0; o < params.out.depth_; o++) {
+      for (size_t inc = 0; inc < params.in.depth_; inc++) {
+        if (!params.tbl.is_connected(o, inc)) continue;
+        const size_t idx =
+          params.weight.get_index(0, 0, params.in.depth_ * o + inc);
+        int16_t *dst = &qw->W_packed[o * qw->packed_k + inc * area];
+        for (size_t i = 0; i < area; i++) {
+          dst[i] = static_cast<int16_t>(qw->W[idx + i] - offset_filter);
+        }
+      }
+    }
+  }
   // bias quantization
   float_t min_bias(0);
   float_t max_bias(0);
-  std::vector<uint8_t> bias_quantized;
+  qw->bias.clear();
   if (params.has_bias) {
     for (size_t inc = 0; inc < params.out.depth_; inc++) {
       min_bias = std::min(min_bias, bias[inc]);
@@ -66,9 +70,40 @@ inline void tiny_quantized_conv2d_kernel(const conv_params &params,
       max_bias = bias[0] + 1e-3f;
       min_bias = bias[0] - 1e-3f;
     }
-    bias_quantized =
-      float_tensor_to_quantized<uint8_t>(bias, min_bias, max_bias);
+    qw->bias = float_tensor_to_quantized<uint8_t>(bias, min_bias, max_bias);
+  }
+  qw->min_bias = min_bias;
+  qw->max_bias = max_bias;
+}
+
+inline void tiny_quantized_conv2d_kernel(const conv_params &params,
+                                         const vec_t &in,
+                                         const quantized_weights &qw,
+                                         vec_t &a,
+                                         const bool layer_parallelize) {
+  // image quantization, the input is scanned only without calibrated range
+  float_t min_input(params.in_range.min);
+  float_t max_input(params.in_range.max);
+  if (!params.in_range.is_static()) {
+    min_input = in[0];
+    max_input = in[0];
+    for (size_t inc = 0; inc < params.in.depth_; inc++) {
+      for (size_t ins = 0;
+           ins < params.in_padded.height_ * params.in_padded.height_; ins++) {
+        size_t idx = params.in_padded.get_index(0, 0, inc);
+        min_input  = std::min(min_input, (&in[idx])[ins]);
+        max_input  = std::max(max_input, (&in[idx])[ins]);
+      }
+    }
   }
+  std::vector<uint8_t> in_quantized =
+    params.int8_input
+      ? float_tensor_to_codes(in)
+      : float_tensor_to_quantized<uint8_t>(in, min_input, max_input);
+  const std::vector<uint8_t> &W_quantized    = qw.W;
+  const std::vector<uint8_t> &bias_quantized = qw.bias;
+  const float_t min_filter                   = qw.min_filter;
+  const float_t max_filter                   = qw.max_filter;
   // output range
   float_t min_output_value;
   float_t max_output_value;
@@ -83,53 +118,87 @@ inline void tiny_quantized_conv2d_kernel(const conv_params &params,
     float_to_quantized_unclamped<uint8_t>(0.0f, min_input, max_input));
   const int32_t offset_filter = int64_to_int32(
     float_to_quantized_unclamped<uint8_t>(0.0f, min_filter, max_filter));
-  const int32_t zero_in_total_space = int64_to_int32(
-    float_to_quantized<int32_t>(0.0f, min_output_value, max_output_value));
 
-  for_i(layer_parallelize, params.out.depth_, [&](size_t o) {
-    for (size_t inc = 0; inc < params.in.depth_; inc++) {
-      if (!params.tbl.is_connected(o, inc)) continue;
-
-      size_t idx        = 0;
-      idx               = params.in.depth_ * o + inc;
-      idx               = params.weight.get_index(0, 0, idx);
-      const uint8_t *pw = &W_quantized[idx];
-
-      idx               = params.in_padded.get_index(0, 0, inc);
-      const uint8_t *pi = &in_quantized[idx];
-
-      idx                   = params.out.get_index(0, 0, o);
-      int32_t *pa_quantized = &a_quantized[idx];
-
-      for (size_t y = 0; y < params.out.height_; y++) {
-        for (size_t x = 0; x < params.out.width_; x++) {
-          const uint8_t *ppw = pw;
-          const uint8_t *ppi = pi +
-                               params.in_padded.width_ * (y * params.h_stride) +
-                               x * params.w_stride;
-          int32_t sum = 0;
-
-          // should be optimized for small kernel(3x3,5x5)
-          for (size_t wy = 0; wy < params.weight.height_; wy++) {
-            for (size_t wx = 0; wx < params.weight.width_; wx++) {
-              idx = wy * params.in_padded.width_ + wx;
-              sum += (static_cast<int32_t>(*ppw++) - offset_filter) *
-                     (static_cast<int32_t>(ppi[idx]) - offset_input);
+  // weights are packed only when the layer runs on the avx engine
+  const bool use_gemm =
+    !qw.W_packed.empty() && quantized_gemm_fits(offset_input);
+  if (use_gemm) {
+    // im2col: one row of in.depth * kernel area values per output pixel
+    const size_t out_area = params.out.width_ * params.out.height_;
+    const size_t area     = params.weight.width_ * params.weight.height_;
+    const size_t k        = qw.packed_k;
+    std::vector<int16_t> cols(out_area * k, int16_t(0));
+
+    for_i(layer_parallelize, out_area, [&](size_t p) {
+      const size_t y = p / params.out.width_;
+      const size_t x = p % params.out.width_;
+      for (size_t inc = 0; inc < params.in.depth_; inc++) {
+        const uint8_t *ppi = &in_quantized[params.in_padded.get_index(
+                               0, 0, inc)] +
+                             params.in_padded.width_ * (y * params.h_stride) +
+                             x * params.w_stride;
+        int16_t *pcol = &cols[p * k + inc * area];
+        for (size_t wy = 0; wy < params.weight.height_; wy++) {
+          for (size_t wx = 0; wx < params.weight.width_; wx++) {
+            *pcol++ = static_cast<int16_t>(
+              ppi[wy * params.in_padded.width_ + wx] - offset_input);
+          }
+        }
+      }
+    });
+    tiny_quantized_gemm(&qw.W_packed[0], &cols[0], &a_quantized[0],
+                        params.out.depth_, out_area, k, out_area,
+                        layer_parallelize);
+  } else {
+    for_i(layer_parallelize, params.out.depth_, [&](size_t o) {
+      for (size_t inc = 0; inc < params.in.depth_; inc++) {
+        if (!params.tbl.is_connected(o, inc)) continue;
+
+        size_t idx        = 0;
+        idx               = params.in.depth_ * o + inc;
+        idx               = params.weight.get_index(0, 0, idx);
+        const uint8_t *pw = &W_quantized[idx];
+
+        idx               = params.in_padded.get_index(0, 0, inc);
+        const uint8_t *pi = &in_quantized[idx];
+
+        idx                   = params.out.get_index(0, 0, o);
+        int32_t *pa_quantized = &a_quantized[idx];
+
+        for (size_t y = 0; y < params.out.height_; y++) {
+          for (size_t x = 0; x < params.out.width_; x++) {
+            const uint8_t *ppw = pw;
+            const uint8_t *ppi =
+              pi + params.in_padded.width_ * (y * params.h_stride) +
+              x * params.w_stride;
+            int32_t sum = 0;
+
+            // should be optimized for small kernel(3x3,5x5)
+            for (size_t wy = 0; wy < params.weight.height_; wy++) {
+              for (size_t wx = 0; wx < params.weight.width_; wx++) {
+                idx = wy * params.in_padded.width_ + wx;
+                sum += (static_cast<int32_t>(*ppw++) - offset_filter) *
+                       (static_cast<int32_t>(ppi[idx]) - offset_input);
+              }
             }
+            pa_quantized[y * params.out.width_ + x] += sum;
           }
-          pa_quantized[y * params.out.width_ + x] += sum;
         }
       }
-    }
-    if (params.has_bias) {
+    });
+  }
+
+  if (params.has_bias) {
+    for_i(layer_parallelize, params.out.depth_, [&](size_t o) {
       int32_t *pa_quantized = &a_quantized[params.out.get_index(0, 0, o)];
       int32_t *paa_quantized =
         pa_quantized + params.out.width_ * params.out.height_;
-      std::for_each(pa_quantized, paa_quantized, [&](int32_t &f) {
-        f += (bias_quantized[o] - zero_in_total_space);
-      });
-    }
-  });
+      const int32_t b =
+        bias_to_accumulator(bias_quantized[o], qw.min_bias, qw.max_bias,
+                            min_output_value, max_output_value);
+      std::for_each(pa_quantized, paa_quantized, [&](int32_t &f) { f += b; });
+    });
+  }
 
   float_t min_output_requantized;
   float_t max_output_requantized;
@@ -137,16 +206,31 @@ inline void tiny_quantized_conv2d_kernel(const conv_params &params,
                                      static_cast<uint8_t>(0));
 
   // Requantize from 32bits to 8 bits for next layer
-  quantize_down_and_shrink_range<int32_t, uint8_t>(
-    a_quantized, min_output_value, max_output_value, &min_output_requantized,
-    &max_output_requantized, &a_requantized);
-
-  // dequantize to flaot, this could be removed within concatenated quantized
-  // network
+  requantize_output(a_quantized, min_output_value, max_output_value,
+                    params.out_range, &min_output_requantized,
+                    &max_output_requantized, &a_requantized);
+
+  // the next layer takes the codes as they are in int8 execution mode,
+  // otherwise dequantize to float
+  if (params.int8_output) {
+    codes_to_float_tensor(a_requantized, &a);
+    return;
+  }
   a = quantized_tensor_to_float<uint8_t>(a_requantized, min_output_requantized,
                                          max_output_requantized);
 }
 
+inline void tiny_quantized_conv2d_kernel(const conv_params &params,
+                                         const vec_t &in,
+                                         const vec_t &W,
+                                         const vec_t &bias,
+                                         vec_t &a,
+                                         const bool layer_parallelize) {
+  quantized_weights qw;
+  tiny_quantize_conv2d_weights(params, W, bias, &qw);
+  tiny_quantized_conv2d_kernel(params, in, qw, a, layer_parallelize);
+}
+
 inline void tiny_quantized_conv2d_back_kernel(const conv_params &params,
                                               const vec_t &prev_out,
                                               const vec_t &W,
@@ -171,13 +255,9 @@ inline void tiny_quantized_conv2d_back_kernel(const conv_params &params,
   // filter quantization
   float_t min_filter(W[0]);
   float_t max_filter(W[0]);
-  for (size_t inc = 0; inc < params.in_padded.depth_; inc++) {
-    for (size_t ins = 0; ins < params.weight.height_ * params.weight.height_;
-         ins++) {
-      size_t idx = params.in_padded.get_index(0, 0, inc);
-      min_filter = std::min(min_filter, (&W[idx])[ins]);
-      max_filter = std::max(max_filter, (&W[idx])[ins]);
-    }
+  for (size_t c = 0; c < W.size(); c++) {
+    min_filter = std::min(min_filter, W[c]);
+    max_filter = std::max(max_filter, W[c]);
   }
   if (min_filter == max_filter) {
     max_filter = W[0] + 1e-3f;
@@ -10,31 +10,20 @@
 #include <algorithm>
 #include <vector>
 
-#ifdef CNN_USE_GEMMLOWP
 #include "tiny_dnn/core/kernels/tiny_quantization_kernel.h"
-#include "tiny_dnn/core/kernels/tiny_quantized_matmul_kernel.h"
+#include "tiny_dnn/core/kernels/tiny_quantized_gemm_kernel.h"
 #include "tiny_dnn/core/params/fully_params.h"
+#include "tiny_dnn/util/scratch_arena.h"
 
 namespace tiny_dnn {
 namespace core {
 namespace kernels {
 
-inline void tiny_quantized_fully_connected_kernel(
-  const fully_params &params,
-  const vec_t &in,
-  const vec_t &W,
-  const vec_t &b,
-  vec_t &out,
-  const bool layer_parallelize) {
-  // input quantization
-  float_t min_input(in[0]);
-  float_t max_input(in[0]);
-  for (size_t c = 0; c < params.in_size_; c++) {
-    min_input = std::min(min_input, in[c]);
-    max_input = std::max(max_input, in[c]);
-  }
-  std::vector<uint8_t> in_quantized =
-    float_tensor_to_quantized<uint8_t>(in, min_input, max_input);
+inline void tiny_quantize_fully_connected_weights(const fully_params &params,
+                                                  const vec_t &W,
+                                                  const vec_t &b,
+                                                  quantized_weights *qw,
+                                                  const bool use_gemm = false) {
   // filter quantization
   float_t min_filter(W[0]);
   float_t max_filter(W[0]);
@@ -46,18 +35,27 @@ inline void tiny_quantized_fully_connected_kernel(
     max_filter = W[0] + 1e-3f;
     min_filter = W[0] - 1e-3f;
   }
-  std::vector<uint8_t> W_quantized =
-    float_tensor_to_quantized<uint8_t>(W, min_filter, max_filter);
-  // output range
-  float_t min_output_value;
-  float_t max_output_value;
-  quantization_range_for_multiplication<uint8_t, uint8_t, int32_t>(
-    min_input, max_input, min_filter, max_filter, &min_output_value,
-    &max_output_value);
+  qw->W = float_tensor_to_quantized<uint8_t>(W, min_filter, max_filter);
+  qw->min_filter = min_filter;
+  qw->max_filter = max_filter;
+  // gemm layout: W transposed to one row of in_size values per output
+  const int32_t offset_filter = int64_to_int32(
+    float_to_quantized_unclamped<uint8_t>(0.0f, min_filter, max_filter));
+  qw->W_packed.clear();
+  if (use_gemm && quantized_gemm_fits(offset_filter)) {
+    qw->packed_k = quantized_gemm_padded(params.in_size_);
+    qw->W_packed.assign(params.out_size_ * qw->packed_k, int16_t(0));
+    for (size_t c = 0; c < params.in_size_; c++) {
+      for (size_t i = 0; i < params.out_size_; i++) {
+        qw->W_packed[i * qw->packed_k + c] = static_cast<int16_t>(
+          qw->W[c * params.out_size_ + i] - offset_filter);
+      }
+    }
+  }
   // bias quantization
   float_t min_bias(0);
   float_t max_bias(0);
-  std::vector<uint8_t> bias_quantized;
+  qw->bias.clear();
   if (params.has_bias_) {
     for (size_t inc = 0; inc < b.size(); inc++) {
       min_bias = std::min(min_bias, b[inc]);
@@ -67,35 +65,73 @@ inline void tiny_quantized_fully_connected_kernel(
       max_bias = b[0] + 1e-3f;
       min_bias = b[0] - 1e-3f;
     }
-    bias_quantized = float_tensor_to_quantized<uint8_t>(b, min_bias, max_bias);
+    qw->bias = float_tensor_to_quantized<uint8_t>(b, min_bias, max_bias);
   }
-  min_output_value += min_bias;
-  max_output_value += max_bias;
+  qw->min_bias = min_bias;
+  qw->max_bias = max_bias;
+}
 
-  std::vector<int32_t> out_quantized(out.size(), static_cast<int32_t>(0));
+inline void tiny_quantized_fully_connected_kernel(
+  const fully_params &params,
+  const vec_t &in,
+  const quantized_weights &qw,
+  vec_t &out,
+  const bool layer_parallelize) {
+  // input quantization, the input is scanned only without calibrated range
+  float_t min_input(params.in_range_.min);
+  float_t max_input(params.in_range_.max);
+  if (!params.in_range_.is_static()) {
+    min_input = in[0];
+    max_input = in[0];
+    for (size_t c = 0; c < params.in_size_; c++) {
+      min_input = std::min(min_input, in[c]);
+      max_input = std::max(max_input, in[c]);
+    }
+  }
+  // the temporaries of the call come from the arena of the thread
+  scratch_scope scratch;
+  scratch_vector<uint8_t> in_quantized(in.size());
+  if (params.int8_input_) {
+    float_tensor_to_codes_in_place(in, &in_quantized);
+  } else {
+    float_tensor_to_quantized_in_place<uint8_t>(in, min_input, max_input,
+                                                &in_quantized);
+  }
+  const std::vector<uint8_t> &W_quantized    = qw.W;
+  const std::vector<uint8_t> &bias_quantized = qw.bias;
+  const float_t min_filter                   = qw.min_filter;
+  const float_t max_filter                   = qw.max_filter;
+  // output range
+  float_t min_output_value;
+  float_t max_output_value;
+  quantization_range_for_multiplication<uint8_t, uint8_t, int32_t>(
+    min_input, max_input, min_filter, max_filter, &min_output_value,
+    &max_output_value);
+
+  scratch_vector<int32_t> out_quantized(out.size(), static_cast<int32_t>(0));
 
   // calculating offset
   const int32_t offset_input =
     float_to_quantized_unclamped<uint8_t>(0.0f, min_input, max_input);
   const int32_t offset_filter =
     float_to_quantized_unclamped<uint8_t>(0.0f, min_filter, max_filter);
-  const int32_t zero_in_total_space =
-    float_to_quantized<int32_t>(0.0f, min_output_value, max_output_value);
-
-  const int32_t offset_output = 0;
-  const int32_t mult_output   = 1;
-  const int32_t shift_output  = 0;
 
-  bool use_gemm = false;
+  // weights are packed only when the layer runs on the avx engine
+  const bool use_gemm =
+    !qw.W_packed.empty() && quantized_gemm_fits(offset_input);
   if (use_gemm) {
-    std::vector<size_t> shape{params.in_size_, 1, params.out_size_,
-                              params.in_size_};
-    tiny_quantized_matmul(in_quantized, W_quantized, out_quantized, shape,
-                          offset_input, offset_filter, offset_output,
-                          mult_output, shift_output);
+    scratch_vector<int16_t> in_packed(qw.packed_k);
+    quantized_gemm_pack(&in_quantized[0], params.in_size_, offset_input,
+                        &in_packed[0]);
+    tiny_quantized_gemm(&qw.W_packed[0], &in_packed[0], &out_quantized[0],
+                        params.out_size_, 1, qw.packed_k, 1,
+                        layer_parallelize);
     if (params.has_bias_) {
-      for_i(layer_parallelize, params.out_size_,
-            [&](size_t i) { out[i] += b[i]; });
+      for_i(layer_parallelize, params.out_size_, [&](size_t i) {
+        out_quantized[i] +=
+          bias_to_accumulator(bias_quantized[i], qw.min_bias, qw.max_bias,
+                              min_output_value, max_output_value);
+      });
     }
   } else {
     for_i(layer_parallelize, params.out_size_, [&](size_t i) {
@@ -106,25 +142,45 @@ inline void tiny_quantized_fully_connected_kernel(
           static_cast<int32_t>(in_quantized[c] - offset_input);
       }
       if (params.has_bias_) {
-        out_quantized[i] += (bias_quantized[i] - zero_in_total_space);
+        out_quantized[i] +=
+          bias_to_accumulator(bias_quantized[i], qw.min_bias, qw.max_bias,
+                              min_output_value, max_output_value);
       }
     });
   }
 
   float_t min_output_requantized;
   float_t max_output_requantized;
-  std::vector<uint8_t> out_requantized(out_quantized.size(),
-                                       static_cast<uint8_t>(0));
+  scratch_vector<uint8_t> out_requantized(out_quantized.size(),
+                                          static_cast<uint8_t>(0));
 
   // Requantize from 32bits to 8 bits for next layer
-  quantize_down_and_shrink_range<int32_t, uint8_t>(
-    out_quantized, min_output_value, max_output_value, &min_output_requantized,
-    &max_output_requantized, &out_requantized);
+  requantize_output(out_quantized, min_output_value, max_output_value,
+                    params.out_range_, &min_output_requantized,
+                    &max_output_requantized, &out_requantized);
+
+  // the next layer takes the codes as they are in int8 execution mode,
+  // otherwise dequantize to float
+  if (params.int8_output_) {
+    codes_to_float_tensor(out_requantized, &out);
+    return;
+  }
+  out.resize(out_requantized.size());
+  quantized_tensor_to_float_in_place<uint8_t>(
+    out_requantized, min_output_requantized, max_output_requantized, &out);
+}
 
-  // dequantize to flaot, this could be removed within concatenated quantized
-  // network
-  out = quantized_tensor_to_float<uint8_t>(
-    out_requantized, min_output_requantized, max_output_requantized);
+inline void tiny_quantized_fully_connected_kernel(
+  const fully_params &params,
+  const vec_t &in,
+  const vec_t &W,
+  const vec_t &b,
+  vec_t &out,
+  const bool layer_parallelize) {
+  quantized_weights qw;
+  tiny_quantize_fully_connected_weights(params, W, b, &qw);
+  tiny_quantized_fully_connected_kernel(params, in, qw, out,
+                                        layer_parallelize);
 }
 
 inline void tiny_quantized_fully_connected_back_kernel(
@@ -323,34 +379,17 @@ inline void tiny_quantized_fully_connected_kernel(
   const int32_t zero_in_total_space =
     float_to_quantized<int32_t>(0.0f, min_output_value, max_output_value);
 
-  const int32_t offset_output = 0;
-  const int32_t mult_output   = 1;
-  const int32_t shift_output  = 0;
-
-  bool use_gemm = false;
-  if (use_gemm) {
-    std::vector<size_t> shape{params.in_size_, 1, params.out_size_,
-                              params.in_size_};
-    tiny_quantized_matmul(in_quantized, W_quantized, out_quantized, shape,
-                          offset_input, offset_filter, offset_output,
-                          mult_output, shift_output);
+  for_i(layer_parallelize, params.out_size_, [&](size_t i) {
+    for (size_t c = 0; c < params.in_size_; c++) {
+      out_quantized[i] +=
+        static_cast<int32_t>(W_quantized[c * params.out_size_ + i] -
+                             offset_filter) *
+        static_cast<int32_t>(in_quantized[c] - offset_input);
+    }
     if (params.has_bias_) {
-      for_i(layer_parallelize, params.out_size_,
-            [&](size_t i) { out[i] += b[i]; });
+      out_quantized[i] += (bias_quantized[i] - zero_in_total_space);
     }
-  } else {
-    for_i(layer_parallelize, params.out_size_, [&](size_t i) {
-      for (size_t c = 0; c < params.in_size_; c++) {
-        out_quantized[i] +=
-          static_cast<int32_t>(W_quantized[c * params.out_size_ + i] -
-                               offset_filter) *
-          static_cast<int32_t>(in_quantized[c] - offset_input);
-      }
-      if (params.has_bias_) {
-        out_quantized[i] += (bias_quantized[i] - zero_in_total_space);
-      }
-    });
-  }
+  });
 
   float_t min_output_requantized;
   float_t max_output_requantized;
@@ -373,4 +412,3 @@ inline void tiny_quantized_fully_connected_kernel(
 }  // namespace core
 }  // namespace tiny_dnn
 
-#endif  // CNN_USE_GEMMLOWP
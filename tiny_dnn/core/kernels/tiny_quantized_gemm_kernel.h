@@ -0,0 +1,208 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(CNN_USE_SSE) || defined(CNN_USE_AVX)
+#include <immintrin.h>
+#endif
+
+#include "tiny_dnn/util/parallel_for.h"
+
+namespace tiny_dnn {
+namespace core {
+namespace kernels {
+
+/**
+ * Self-contained 8-bit GEMM used by the quantized layers when they run on the
+ * avx engine (no gemmlowp required).
+ *
+ * Both operands are 8-bit values with their zero point already subtracted,
+ * stored as int16 rows whose length is padded with zeros to a multiple of
+ * quantized_gemm_block(). (u - zero_point) of two full-range uint8 tensors
+ * does not fit into the u8 x s8 operands of vpmaddubsw without saturating
+ * the 16-bit pair sums, so the products are formed with vpmaddwd
+ * (_mm256_madd_epi16 / _mm_madd_epi16), which is exact and accumulates into
+ * int32.
+ **/
+inline size_t quantized_gemm_block() { return 16; }
+
+inline size_t quantized_gemm_padded(size_t k) {
+  const size_t block = quantized_gemm_block();
+  return (k + block - 1) / block * block;
+}
+
+/**
+ * whether (q - zero_point) stays in [-32767, 32767] for every uint8 q, so
+ * that a pair of products summed by madd can't overflow int32.
+ **/
+inline bool quantized_gemm_fits(int32_t zero_point) {
+  return zero_point >= 255 - 32767 && zero_point <= 32767;
+}
+
+/**
+ * copies n uint8 values into dst (zero-padded to the gemm block size),
+ * subtracting the zero point.
+ **/
+inline void quantized_gemm_pack(const uint8_t *src,
+                                size_t n,
+                                int32_t zero_point,
+                                int16_t *dst) {
+  for (size_t i = 0; i < n; i++) {
+    dst[i] = static_cast<int16_t>(static_cast<int32_t>(src[i]) - zero_point);
+  }
+  std::fill(dst + n, dst + quantized_gemm_padded(n), int16_t(0));
+}
+
+namespace detail {
+
+#if defined(CNN_USE_AVX2)
+inline int32_t hsum_epi32(__m256i v) {
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v),
+                            _mm256_extracti128_si256(v, 1));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(s);
+}
+#elif defined(CNN_USE_SSE) || defined(CNN_USE_AVX)
+inline int32_t hsum_epi32(__m128i s) {
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(s);
+}
+#endif
+
+// c[j] = dot(a, b_j) for 4 rows b_j, k is a multiple of the gemm block
+inline void quantized_dot_1x4(const int16_t *a,
+                              const int16_t *b0,
+                              const int16_t *b1,
+                              const int16_t *b2,
+                              const int16_t *b3,
+                              size_t k,
+                              int32_t *c) {
+#if defined(CNN_USE_AVX2)
+  __m256i acc0 = _mm256_setzero_si256();
+  __m256i acc1 = _mm256_setzero_si256();
+  __m256i acc2 = _mm256_setzero_si256();
+  __m256i acc3 = _mm256_setzero_si256();
+  for (size_t i = 0; i < k; i += 16) {
+    const __m256i va  = _mm256_loadu_si256((const __m256i *)(a + i));
+    const __m256i vb0 = _mm256_loadu_si256((const __m256i *)(b0 + i));
+    const __m256i vb1 = _mm256_loadu_si256((const __m256i *)(b1 + i));
+    const __m256i vb2 = _mm256_loadu_si256((const __m256i *)(b2 + i));
+    const __m256i vb3 = _mm256_loadu_si256((const __m256i *)(b3 + i));
+    acc0              = _mm256_add_epi32(acc0, _mm256_madd_epi16(va, vb0));
+    acc1              = _mm256_add_epi32(acc1, _mm256_madd_epi16(va, vb1));
+    acc2              = _mm256_add_epi32(acc2, _mm256_madd_epi16(va, vb2));
+    acc3              = _mm256_add_epi32(acc3, _mm256_madd_epi16(va, vb3));
+  }
+  c[0] = hsum_epi32(acc0);
+  c[1] = hsum_epi32(acc1);
+  c[2] = hsum_epi32(acc2);
+  c[3] = hsum_epi32(acc3);
+#elif defined(CNN_USE_SSE) || defined(CNN_USE_AVX)
+  __m128i acc0 = _mm_setzero_si128();
+  __m128i acc1 = _mm_setzero_si128();
+  __m128i acc2 = _mm_setzero_si128();
+  __m128i acc3 = _mm_setzero_si128();
+  for (size_t i = 0; i < k; i += 8) {
+    const __m128i va  = _mm_loadu_si128((const __m128i *)(a + i));
+    const __m128i vb0 = _mm_loadu_si128((const __m128i *)(b0 + i));
+    const __m128i vb1 = _mm_loadu_si128((const __m128i *)(b1 + i));
+    const __m128i vb2 = _mm_loadu_si128((const __m128i *)(b2 + i));
+    const __m128i vb3 = _mm_loadu_si128((const __m128i *)(b3 + i));
+    acc0              = _mm_add_epi32(acc0, _mm_madd_epi16(va, vb0));
+    acc1              = _mm_add_epi32(acc1, _mm_madd_epi16(va, vb1));
+    acc2              = _mm_add_epi32(acc2, _mm_madd_epi16(va, vb2));
+    acc3              = _mm_add_epi32(acc3, _mm_madd_epi16(va, vb3));
+  }
+  c[0] = hsum_epi32(acc0);
+  c[1] = hsum_epi32(acc1);
+  c[2] = hsum_epi32(acc2);
+  c[3] = hsum_epi32(acc3);
+#else
+  int32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  for (size_t i = 0; i < k; i++) {
+    const int32_t va = a[i];
+    s0 += va * b0[i];
+    s1 += va * b1[i];
+    s2 += va * b2[i];
+    s3 += va * b3[i];
+  }
+  c[0] = s0;
+  c[1] = s1;
+  c[2] = s2;
+  c[3] = s3;
+#endif
+}
+
+inline int32_t quantized_dot(const int16_t *a, const int16_t *b, size_t k) {
+#if defined(CNN_USE_AVX2)
+  __m256i acc = _mm256_setzero_si256();
+  for (size_t i = 0; i < k; i += 16) {
+    acc = _mm256_add_epi32(
+      acc, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)(a + i)),
+                             _mm256_loadu_si256((const __m256i *)(b + i))));
+  }
+  return hsum_epi32(acc);
+#elif defined(CNN_USE_SSE) || defined(CNN_USE_AVX)
+  __m128i acc = _mm_setzero_si128();
+  for (size_t i = 0; i < k; i += 8) {
+    acc = _mm_add_epi32(
+      acc, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(a + i)),
+                          _mm_loadu_si128((const __m128i *)(b + i))));
+  }
+  return hsum_epi32(acc);
+#else
+  int32_t s = 0;
+  for (size_t i = 0; i < k; i++) s += static_cast<int32_t>(a[i]) * b[i];
+  return s;
+#endif
+}
+
+}  // namespace detail
+
+/**
+ * C[i * ldc + j] += sum_k A[i * k + k'] * B[j * k + k']
+ *
+ * @param A  m rows of packed int16 (see quantized_gemm_pack)
+ * @param B  n rows of packed int16
+ * @param k  padded row length, multiple of quantized_gemm_block()
+ **/
+inline void tiny_quantized_gemm(const int16_t *A,
+                                const int16_t *B,
+                                int32_t *C,
+                                size_t m,
+                                size_t n,
+                                size_t k,
+                                size_t ldc,
+                                const bool layer_parallelize) {
+  for_i(layer_parallelize, m, [&](size_t i) {
+    const int16_t *a = A + i * k;
+    int32_t *c       = C + i * ldc;
+    int32_t c4[4];
+    size_t j = 0;
+    for (; j + 4 <= n; j += 4) {
+      detail::quantized_dot_1x4(a, B + j * k, B + (j + 1) * k,
+                                B + (j + 2) * k, B + (j + 3) * k, k, c4);
+      c[j] += c4[0];
+      c[j + 1] += c4[1];
+      c[j + 2] += c4[2];
+      c[j + 3] += c4[3];
+    }
+    for (; j < n; j++) {
+      c[j] += detail::quantized_dot(a, B + j * k, k);
+    }
+  });
+}
+
+}  // namespace kernels
+}  // namespace core
+}  // namespace tiny_dnn
@@ -71,6 +71,12 @@ class conv_params : public Params {
   padding pad_type;
   size_t w_stride;
   size_t h_stride;
+  // calibrated activation ranges of the quantized kernels
+  quantization_range in_range;
+  quantization_range out_range;
+  // input/output edges carry the 8-bit codes of the ranges above
+  bool int8_input  = false;
+  bool int8_output = false;
 
   friend std::ostream &operator<<(std::ostream &o,
                                   const core::conv_params &param) {
@@ -104,15 +110,18 @@ class Conv2dPadding {
       return;
     }
 
-    tensor_t buf(in.size());
+    // written in place, the borders being left at zero from one call to
+    // the next
+    out.resize(in.size());
 
-    for_i(true, buf.size(), [&](size_t sample) {
-      // alloc temporary buffer.
-      buf[sample].resize(params_.in_padded.size());
+    for_i(true, out.size(), [&](size_t sample) {
+      if (out[sample].size() != params_.in_padded.size()) {
+        out[sample].assign(params_.in_padded.size(), float_t{0});
+      }
 
       // make padded version in order to avoid corner-case in fprop/bprop
       for (size_t c = 0; c < params_.in.depth_; c++) {
-        float_t *pimg = &buf[sample][params_.in_padded.get_index(
+        float_t *pimg = &out[sample][params_.in_padded.get_index(
           params_.weight.width_ / 2, params_.weight.height_ / 2, c)];
         const float_t *pin = &in[sample][params_.in.get_index(0, 0, c)];
 
@@ -123,9 +132,6 @@ class Conv2dPadding {
         }
       }
     });
-
-    // shrink buffer to output
-    out = buf;
   }
 
   /* Applies unpadding to an input tensor given the convolution parameters
@@ -138,16 +144,18 @@ class Conv2dPadding {
       return;
     }
 
-    tensor_t buf(delta.size());
+    // every element of the output is written
+    delta_unpadded.resize(delta.size());
 
-    for_i(true, buf.size(), [&](size_t sample) {
-      // alloc temporary buffer.
-      buf[sample].resize(params_.in.size());
+    for_i(true, delta_unpadded.size(), [&](size_t sample) {
+      if (delta_unpadded[sample].size() != params_.in.size()) {
+        delta_unpadded[sample].resize(params_.in.size());
+      }
 
       for (size_t c = 0; c < params_.in.depth_; c++) {
         const float_t *pin = &delta[sample][params_.in_padded.get_index(
           params_.weight.width_ / 2, params_.weight.height_ / 2, c)];
-        float_t *pdst = &buf[sample][params_.in.get_index(0, 0, c)];
+        float_t *pdst = &delta_unpadded[sample][params_.in.get_index(0, 0, c)];
 
         for (size_t y = 0; y < params_.in.height_; y++) {
           std::copy(pin, pin + params_.in.width_, pdst);
@@ -156,9 +164,6 @@ class Conv2dPadding {
         }
       }
     });
-
-    // shrink buffer to output
-    delta_unpadded = buf;
   }
 
  private:
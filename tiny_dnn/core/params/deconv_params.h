@@ -7,6 +7,8 @@
 */
 #pragma once
 
+#include "tiny_dnn/core/params/conv_params.h"
+
 namespace tiny_dnn {
 namespace core {
 
@@ -27,6 +29,12 @@ struct deconv_params {
   padding pad_type;
   size_t w_stride;
   size_t h_stride;
+  // calibrated activation ranges of the quantized kernels
+  quantization_range in_range;
+  quantization_range out_range;
+  // input/output edges carry the 8-bit codes of the ranges above
+  bool int8_input  = false;
+  bool int8_output = false;
 };
 
 }  // namespace core
@@ -17,6 +17,12 @@ class fully_params : public Params {
   size_t in_size_;
   size_t out_size_;
   bool has_bias_;
+  // calibrated activation ranges of the quantized kernels
+  quantization_range in_range_;
+  quantization_range out_range_;
+  // input/output edges carry the 8-bit codes of the ranges above
+  bool int8_input_  = false;
+  bool int8_output_ = false;
 };
 
 // TODO(nyanp): can we do better here?
@@ -0,0 +1,29 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include "tiny_dnn/core/params/params.h"
+
+namespace tiny_dnn {
+namespace core {
+
+class lstm_cell_params : public Params {
+ public:
+  size_t in_size_;
+  size_t out_size_;
+  bool has_bias_;
+
+  // rows of the gate weights, the concatenation [x(t), h(t-1)]
+  size_t xh_size() const { return in_size_ + out_size_; }
+
+  // columns of the gate weights, the input, forget, cell and output gates
+  size_t gates_size() const { return 4 * out_size_; }
+};
+
+}  // namespace core
+}  // namespace tiny_dnn
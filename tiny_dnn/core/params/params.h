@@ -7,6 +7,8 @@
 */
 #pragma once
 
+#include "tiny_dnn/config.h"
+
 namespace tiny_dnn {
 namespace core {
 
@@ -16,6 +18,31 @@ class maxpool_params;
 class global_avepool_params;
 class recurrent_cell_params;
 
+/* Float range a tensor is quantized to, the uint8 code q stands for
+ * min + q * (max - min) / 255 (i.e. an affine quantization with scale
+ * (max - min) / 255 and the code of 0.0 as zero point). An empty range
+ * (min == max) means the range is not known in advance and the kernels
+ * compute it from the data.
+ */
+struct quantization_range {
+  float_t min = float_t{0};
+  float_t max = float_t{0};
+
+  bool is_static() const { return min < max; }
+};
+
+/* Quantization-aware training state of a float layer: its weights and
+ * input/output activations are rounded to the 8-bit levels the quantized
+ * kernels would use. The activation ranges follow an exponential moving
+ * average of the ranges seen in train phase (momentum 1 freezes them).
+ */
+struct fake_quantization_params {
+  bool enabled     = false;
+  float_t momentum = float_t(0.99);
+  quantization_range in_range;
+  quantization_range out_range;
+};
+
 /* Base class to model operation parameters */
 class Params {
  public:
@@ -0,0 +1,28 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include "tiny_dnn/core/params/recurrent_cell_params.h"
+
+namespace tiny_dnn {
+namespace core {
+
+/**
+ * parameters of a recurrent layer unrolled over a whole sequence: the cell
+ * parameters plus the number of steps and the truncated-BPTT window.
+ **/
+class recurrent_params : public recurrent_cell_params {
+ public:
+  size_t seq_len_ = 1;
+  // the state gradient is cut every bptt_ steps, 0 to propagate through
+  // the whole sequence
+  size_t bptt_ = 0;
+};
+
+}  // namespace core
+}  // namespace tiny_dnn
@@ -33,6 +33,14 @@ class elementwise_add_layer : public layer {
 
   std::string layer_type() const override { return "elementwise-add"; }
 
+  // the sum is accumulated into the first input
+  bool supports_in_place(bool training) const override {
+    CNN_UNREFERENCED_PARAMETER(training);
+    return true;
+  }
+
+  bool backward_reads_output() const override { return false; }
+
   std::vector<shape3d> in_shape() const override {
     return std::vector<shape3d>(num_args_, shape3d(dim_, 1, 1));
   }
@@ -46,7 +54,7 @@ class elementwise_add_layer : public layer {
     const tensor_t &in1 = *in_data[0];
     tensor_t &out       = *out_data[0];
 
-    out = in1;
+    if (&out != &in1) out = in1;
 
     // @todo parallelize
     for (size_t sample = 0; sample < in1.size(); ++sample) {
@@ -30,10 +30,10 @@ inline void tiny_average_pooling_kernel(
   float_t scale_factor,
   std::vector<typename partial_connected_layer::wi_connections> &out2wi) {
   for_i(parallelize, in_data[0]->size(), [&](size_t sample) {
-    const vec_t &in = (*in_data[0])[sample];
-    const vec_t &W  = (*in_data[1])[0];
-    const vec_t &b  = (*in_data[2])[0];
-    vec_t &out      = (*out_data[0])[sample];
+    const row_t &in = (*in_data[0])[sample];
+    const row_t &W  = (*in_data[1])[0];
+    const row_t &b  = (*in_data[2])[0];
+    row_t &out      = (*out_data[0])[sample];
 
     auto oarea = out_dim.area();
     size_t idx = 0;
@@ -68,12 +68,12 @@ inline void tiny_average_pooling_back_kernel(
   std::vector<std::vector<size_t>> &bias2out) {
   CNN_UNREFERENCED_PARAMETER(out_data);
   for_i(parallelize, in_data[0]->size(), [&](size_t sample) {
-    const vec_t &prev_out = (*in_data[0])[sample];
-    const vec_t &W        = (*in_data[1])[0];
-    vec_t &dW             = (*in_grad[1])[sample];
-    vec_t &db             = (*in_grad[2])[sample];
-    vec_t &prev_delta     = (*in_grad[0])[sample];
-    vec_t &curr_delta     = (*out_grad[0])[sample];
+    const row_t &prev_out = (*in_data[0])[sample];
+    const row_t &W        = (*in_data[1])[0];
+    row_t &dW             = (*in_grad[1])[sample];
+    row_t &db             = (*in_grad[2])[sample];
+    row_t &prev_delta     = (*in_grad[0])[sample];
+    row_t &curr_delta     = (*out_grad[0])[sample];
 
     auto inarea = in_dim.area();
     size_t idx  = 0;
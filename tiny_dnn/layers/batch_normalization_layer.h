@@ -22,6 +22,10 @@ namespace tiny_dnn {
  * Batch Normalization
  *
  * Normalize the activations of the previous layer at each batch
+ *
+ * The statistics of the batch (and the two means needed by the gradient) are
+ * reduced in a single parallel pass, and the data are multiplied by the
+ * reciprocal of the standard deviation rather than divided by it.
  **/
 class batch_normalization_layer : public layer {
  public:
@@ -98,17 +102,9 @@ class batch_normalization_layer : public layer {
 
     CNN_UNREFERENCED_PARAMETER(in_data);
 
-    tensor_t delta_dot_y = curr_out;
-    vec_t mean_delta_dot_y, mean_delta, mean_Y;
+    vec_t mean_delta_dot_y, mean_delta;
+    delta_moments(curr_delta, curr_out, mean_delta, mean_delta_dot_y);
 
-    for (size_t i = 0; i < num_samples; i++) {
-      for (size_t j = 0; j < curr_out[0].size(); j++) {
-        delta_dot_y[i][j] *= curr_delta[i][j];
-      }
-    }
-
-    moments(delta_dot_y, in_spatial_size_, in_channels_, mean_delta_dot_y);
-    moments(curr_delta, in_spatial_size_, in_channels_, mean_delta);
     // if Y = (X-mean(X))/(sqrt(var(X)+eps)), then
     //
     // dE(Y)/dX =
@@ -116,16 +112,19 @@ class batch_normalization_layer : public layer {
     //     ./ sqrt(var(X) + eps)
     //
     for_i(num_samples, [&](size_t i) {
+      const float_t *dy = &curr_delta[i][0];
+      const float_t *y  = &curr_out[i][0];
+      float_t *dx       = &prev_delta[i][0];
       for (size_t j = 0; j < in_channels_; j++) {
+        // rstddev_ is calculated in the forward pass
+        const float_t md = mean_delta[j], mdy = mean_delta_dot_y[j];
+        const float_t r  = rstddev_[j];
         for (size_t k = 0; k < in_spatial_size_; k++) {
-          size_t index = j * in_spatial_size_ + k;
-
-          prev_delta[i][index] = curr_delta[i][index] - mean_delta[j] -
-                                 mean_delta_dot_y[j] * curr_out[i][index];
-
-          // stddev_ is calculated in the forward pass
-          prev_delta[i][index] /= stddev_[j];
+          dx[k] = (dy[k] - md - mdy * y[k]) * r;
         }
+        dx += in_spatial_size_;
+        dy += in_spatial_size_;
+        y += in_spatial_size_;
       }
     });
   }
@@ -143,7 +142,7 @@ class batch_normalization_layer : public layer {
       moments(*in_data[0], in_spatial_size_, in_channels_, mean, variance);
     }
 
-    // y = (x - mean) ./ sqrt(variance + eps)
+    // y = (x - mean) .* rstddev, rstddev = 1 ./ sqrt(variance + eps)
     calc_stddev(variance);
 
     for_i(in_data[0]->size(), [&](size_t i) {
@@ -151,11 +150,13 @@ class batch_normalization_layer : public layer {
       float_t *outptr      = &out[i][0];
 
       for (size_t j = 0; j < in_channels_; j++) {
-        float_t m = mean[j];
+        const float_t m = mean[j], r = rstddev_[j];
 
         for (size_t k = 0; k < in_spatial_size_; k++) {
-          *outptr++ = (*inptr++ - m) / stddev_[j];
+          outptr[k] = (inptr[k] - m) * r;
         }
+        inptr += in_spatial_size_;
+        outptr += in_spatial_size_;
       }
     });
 
@@ -202,7 +203,12 @@ class batch_normalization_layer : public layer {
 
   void update_immidiately(bool update) { update_immidiately_ = update; }
 
-  void set_stddev(const vec_t &stddev) { stddev_ = stddev; }
+  void set_stddev(const vec_t &stddev) {
+    stddev_ = stddev;
+    for (size_t i = 0; i < in_channels_; i++) {
+      rstddev_[i] = float_t(1) / stddev_[i];
+    }
+  }
 
   void set_mean(const vec_t &mean) { mean_ = mean; }
 
@@ -220,8 +226,56 @@ class batch_normalization_layer : public layer {
  private:
   void calc_stddev(const vec_t &variance) {
     for (size_t i = 0; i < in_channels_; i++) {
-      stddev_[i] = sqrt(variance[i] + eps_);
+      stddev_[i]  = sqrt(variance[i] + eps_);
+      rstddev_[i] = float_t(1) / stddev_[i];
+    }
+  }
+
+  /**
+   * means of dE/dY and of dE/dY .* Y of every channel, both from a single
+   * pass over the batch split in blocks as in moments()
+   **/
+  void delta_moments(const tensor_t &delta,
+                     const tensor_t &out,
+                     vec_t &mean_delta,
+                     vec_t &mean_delta_dot_y) {
+    const size_t num_samples = delta.size();
+    const size_t blocks      = detail::moments_blocks(num_samples);
+
+    // per block, the sums of dE/dY then those of dE/dY .* Y
+    vec_t sums(blocks * 2 * in_channels_, float_t{0});
+    for_i(blocks, [&](size_t b) {
+      float_t *sum_delta = &sums[b * 2 * in_channels_];
+      float_t *sum_dot_y = sum_delta + in_channels_;
+      for (size_t i = detail::moments_block_begin(b, blocks, num_samples);
+           i < detail::moments_block_begin(b + 1, blocks, num_samples); i++) {
+        const float_t *dy = &delta[i][0];
+        const float_t *y  = &out[i][0];
+        for (size_t j = 0; j < in_channels_; j++) {
+          float_t sd = 0, sdy = 0;
+          for (size_t k = 0; k < in_spatial_size_; k++) {
+            sd += dy[k];
+            sdy += dy[k] * y[k];
+          }
+          sum_delta[j] += sd;
+          sum_dot_y[j] += sdy;
+          dy += in_spatial_size_;
+          y += in_spatial_size_;
+        }
+      }
+    });
+
+    mean_delta.assign(in_channels_, float_t{0});
+    mean_delta_dot_y.assign(in_channels_, float_t{0});
+    for (size_t b = 0; b < blocks; b++) {
+      const float_t *sum_delta = &sums[b * 2 * in_channels_];
+      vectorize::reduce(sum_delta, in_channels_, &mean_delta[0]);
+      vectorize::reduce(sum_delta + in_channels_, in_channels_,
+                        &mean_delta_dot_y[0]);
     }
+    const float_t n = float_t(num_samples * in_spatial_size_);
+    vector_div(mean_delta, n);
+    vector_div(mean_delta_dot_y, n);
   }
 
   void init() {
@@ -231,6 +285,7 @@ class batch_normalization_layer : public layer {
     variance_.resize(in_channels_);
     tmp_mean_.resize(in_channels_);
     stddev_.resize(in_channels_);
+    rstddev_.resize(in_channels_);
   }
 
   size_t in_channels_;
@@ -250,6 +305,7 @@ class batch_normalization_layer : public layer {
   vec_t mean_;
   vec_t variance_;
   vec_t stddev_;
+  vec_t rstddev_;  // 1 / stddev_, to multiply by instead of dividing
 
   // for test
   bool update_immidiately_;
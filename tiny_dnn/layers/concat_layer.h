@@ -65,6 +65,24 @@ class concat_layer : public layer {
 
   std::vector<shape3d> out_shape() const override { return {out_shape_}; }
 
+  /**
+   * an input consumed by this layer only becomes a view of its part of the
+   * output, so that its producer writes the concatenation in place; the
+   * other inputs are still copied
+   **/
+  void share_storage() override {
+    const auto ins = inputs();
+    edge *out      = outputs()[0].get();
+    size_t offset  = 0;
+    for (size_t i = 0; i < in_shapes_.size(); i++) {
+      edge &in = *ins[i];
+      if (in.next().size() == 1 && !in.is_shared()) {
+        in.view_features(out, offset, true);
+      }
+      offset += in_shapes_[i].size();
+    }
+  }
+
   void forward_propagation(const std::vector<tensor_t *> &in_data,
                            std::vector<tensor_t *> &out_data) override {
     const size_t num_samples = (*out_data[0]).size();
@@ -75,7 +93,8 @@ class concat_layer : public layer {
       for (size_t i = 0; i < in_shapes_.size(); i++) {
         const float_t *ins = &(*in_data[i])[s][0];
         size_t dim         = in_shapes_[i].size();
-        outs               = std::copy(ins, ins + dim, outs);
+        if (ins != outs) std::copy(ins, ins + dim, outs);
+        outs += dim;
       }
     });
   }
@@ -95,7 +114,7 @@ class concat_layer : public layer {
       for (size_t i = 0; i < in_shapes_.size(); i++) {
         size_t dim   = in_shapes_[i].size();
         float_t *ins = &(*in_grad[i])[s][0];
-        std::copy(outs, outs + dim, ins);
+        if (ins != outs) std::copy(outs, outs + dim, ins);
         outs += dim;
       }
     });
@@ -17,6 +17,7 @@
 #include "tiny_dnn/core/kernels/conv2d_op.h"
 #include "tiny_dnn/core/kernels/conv2d_op_libdnn.h"
 #include "tiny_dnn/core/kernels/conv2d_op_opencl.h"
+#include "tiny_dnn/core/kernels/tiny_fake_quantization_kernel.h"
 
 #include "tiny_dnn/util/util.h"
 
@@ -234,6 +235,8 @@ class convolutional_layer : public layer {
       padding_op_(std::move(other.padding_op_)),
       kernel_fwd_(std::move(other.kernel_fwd_)),
       kernel_back_(std::move(other.kernel_back_)),
+      fake_quant_(std::move(other.fake_quant_)),
+      phase_(other.phase_),
       cws_(std::move(other.cws_)) {
     init_backend(std::move(other.engine()));
   }
@@ -255,12 +258,17 @@ class convolutional_layer : public layer {
    **/
   void forward_propagation(const std::vector<tensor_t *> &in_data,
                            std::vector<tensor_t *> &out_data) override {
-    // apply padding to the input tensor
-    padding_op_.copy_and_pad_input(*in_data[0], cws_.prev_out_padded_);
-
     fwd_in_data_.resize(in_data.size());
     std::copy(in_data.begin(), in_data.end(), fwd_in_data_.begin());
-    fwd_in_data_[0] = in_data_padded(in_data);
+    if (fake_quant_.enabled) {
+      core::kernels::fake_quantize_inputs(&fake_quant_,
+                                          phase_ == net_phase::train,
+                                          &fwd_in_data_, &fake_quant_buf_);
+    }
+
+    // apply padding to the input tensor
+    padding_op_.copy_and_pad_input(*fwd_in_data_[0], cws_.prev_out_padded_);
+    fwd_in_data_[0] = in_data_padded(fwd_in_data_);
 
     // forward convolutional op context
     fwd_ctx_.set_in_out(fwd_in_data_, out_data);
@@ -269,6 +277,11 @@ class convolutional_layer : public layer {
 
     // launch convolutional kernel
     kernel_fwd_->compute(fwd_ctx_);
+
+    if (fake_quant_.enabled) {
+      core::kernels::fake_quantize_output(
+        &fake_quant_, phase_ == net_phase::train, out_data[0]);
+    }
   }
 
   /**
@@ -289,7 +302,14 @@ class convolutional_layer : public layer {
                         std::vector<tensor_t *> &in_grad) override {
     bwd_in_data_.resize(in_data.size());
     std::copy(in_data.begin(), in_data.end(), bwd_in_data_.begin());
-    bwd_in_data_[0] = in_data_padded(in_data);
+    // straight-through estimator: the gradients are taken at the rounded
+    // values of forward and passed on unchanged
+    if (fake_quant_.enabled) {
+      for (size_t i = 0; i < bwd_in_data_.size(); i++) {
+        bwd_in_data_[i] = &fake_quant_buf_[i];
+      }
+    }
+    bwd_in_data_[0] = in_data_padded(bwd_in_data_);
 
     bwd_in_grad_.resize(in_grad.size());
     std::copy(in_grad.begin(), in_grad.end(), bwd_in_grad_.begin());
@@ -309,8 +329,44 @@ class convolutional_layer : public layer {
     padding_op_.copy_and_unpad_delta(cws_.prev_delta_padded_, *in_grad[0]);
   }
 
+  void set_context(net_phase ctx) override { phase_ = ctx; }
+
+  /**
+   * quantization-aware training: forward rounds the weights and the
+   * input/output activations to the 8-bit levels of
+   * quantized_convolutional_layer, so that the network learns to live with
+   * them. The activation ranges track the values seen in train phase with
+   * the given momentum; quantize_network(net) bakes them into the quantized
+   * layers afterwards.
+   **/
+  void enable_fake_quantization(float_t momentum = float_t(0.99)) {
+    fake_quant_.enabled  = true;
+    fake_quant_.momentum = momentum;
+  }
+
+  void disable_fake_quantization() { fake_quant_.enabled = false; }
+
+  bool fake_quantization() const { return fake_quant_.enabled; }
+
+  // starting (or, with momentum 1, fixed) activation ranges
+  void set_quantization_ranges(const core::quantization_range &in_range,
+                               const core::quantization_range &out_range) {
+    fake_quant_.in_range  = in_range;
+    fake_quant_.out_range = out_range;
+  }
+
+  const core::quantization_range &input_range() const {
+    return fake_quant_.in_range;
+  }
+
+  const core::quantization_range &output_range() const {
+    return fake_quant_.out_range;
+  }
+
   void set_sample_count(size_t sample_count) override {
     layer::set_sample_count(sample_count);
+    // no row to build when the batch size is unchanged
+    if (cws_.prev_delta_padded_.size() == sample_count) return;
     cws_.prev_delta_padded_.resize(sample_count,
                                    vec_t(params_.in_padded.size(), float_t(0)));
   }
@@ -330,6 +386,8 @@ class convolutional_layer : public layer {
 
   std::string layer_type() const override { return std::string("conv"); }
 
+  bool backward_reads_output() const override { return false; }
+
   // TODO(edgar): check this
   std::string kernel_file() const override {
     return std::string(
@@ -510,6 +568,11 @@ class convolutional_layer : public layer {
   std::vector<tensor_t *> bwd_in_data_;
   std::vector<tensor_t *> bwd_in_grad_;
 
+  /* Quantization-aware training state and rounded copies of the inputs */
+  core::fake_quantization_params fake_quant_;
+  std::vector<tensor_t> fake_quant_buf_;
+  net_phase phase_ = net_phase::train;
+
   /* Buffer to store padded data */
   struct conv_layer_worker_specific_storage {
     tensor_t prev_out_padded_;
@@ -436,8 +436,8 @@ class deconvolutional_layer : public layer {
       delta_padded = delta;
     } else {
       for (size_t sample = 0; sample < delta.size(); sample++) {
-        vec_t &dst       = delta_padded[sample];
-        const vec_t &src = delta[sample];
+        row_t &dst       = delta_padded[sample];
+        const row_t &src = delta[sample];
 
         for (size_t c = 0; c < params_.in.depth_; c++) {
           float_t *pdst      = &dst[params_.in.get_index(0, 0, c)];
@@ -466,7 +466,7 @@ class deconvolutional_layer : public layer {
       // make unpadded version in order to restore scale in fprop/bprop
       for (size_t sample = 0; sample < out.size(); sample++) {
         size_t idx           = 0;
-        vec_t &dst           = (*dst_tensor)[sample];
+        row_t &dst           = (*dst_tensor)[sample];
         size_t wieght_w_half = params_.weight.width_ / 2;
         size_t wieght_h_half = params_.weight.height_ / 2;
 
@@ -18,6 +18,16 @@ namespace tiny_dnn {
 
 /**
  * applies dropout to the input
+ *
+ * The mask of every forward pass comes from the layer's own philox_stream,
+ * element i of sample s being drawn by (s, i) and the number of the pass, so
+ * that the samples are masked in parallel without sharing a generator and
+ * the masks only depend on the seed (see set_random_seed), not on the
+ * number of threads.
+ *
+ * Masks are kept as packed bits, 32 elements to a word, and applied with
+ * vectorize::masked_scale in both directions. In the test phase the layer is
+ * a pass-through: no mask is drawn and the output shares the input's data.
  **/
 class dropout_layer : public layer {
  public:
@@ -33,8 +43,9 @@ class dropout_layer : public layer {
       phase_(phase),
       dropout_rate_(dropout_rate),
       scale_(float_t(1) / (float_t(1) - dropout_rate_)),
-      in_size_(in_dim) {
-    mask_.resize(1, std::vector<uint8_t>(in_dim));
+      in_size_(in_dim),
+      pass_(0) {
+    mask_.resize(1, std::vector<uint32_t>(mask_words()));
     clear_mask();
   }
 
@@ -77,12 +88,8 @@ class dropout_layer : public layer {
     CNN_UNREFERENCED_PARAMETER(out_data);
 
     for_i(prev_delta.size(), [&](size_t sample) {
-      // assert(prev_delta[sample].size() == curr_delta[sample].size());
-      // assert(mask_[sample].size() == prev_delta[sample].size());
-      size_t sz = prev_delta[sample].size();
-      for (size_t i = 0; i < sz; ++i) {
-        prev_delta[sample][i] = mask_[sample][i] * curr_delta[sample][i];
-      }
+      vectorize::masked_scale(&curr_delta[sample][0], &mask_[sample][0],
+                              scale_, in_size_, &prev_delta[sample][0]);
     });
   }
 
@@ -96,23 +103,13 @@ class dropout_layer : public layer {
     if (mask_.size() < sample_count) {
       mask_.resize(sample_count, mask_[0]);
     }
+    const uint32_t pass = pass_++;
 
     for_i(sample_count, [&](size_t sample) {
-      std::vector<uint8_t> &mask = mask_[sample];
-
-      const vec_t &in_vec = in[sample];
-      vec_t &out_vec      = out[sample];
-
-      if (phase_ == net_phase::train) {
-        for (size_t i = 0; i < in_vec.size(); i++)
-          mask[i]     = bernoulli(dropout_rate_);
-
-        for (size_t i = 0; i < in_vec.size(); i++)
-          out_vec[i]  = mask[i] * scale_ * in_vec[i];
-      } else {
-        for (size_t i = 0, end = in_vec.size(); i < end; i++)
-          out_vec[i] = in_vec[i];
-      }
+      uint32_t *mask = &mask_[sample][0];
+      rng_.bernoulli(uint32_t(sample), pass, in_size_, dropout_rate_, mask);
+      vectorize::masked_scale(&in[sample][0], mask, scale_, in_size_,
+                              &out[sample][0]);
     });
   }
 
@@ -121,11 +118,21 @@ class dropout_layer : public layer {
    **/
   void set_context(net_phase ctx) override { phase_ = ctx; }
 
+  bool is_pass_through() const override { return phase_ == net_phase::test; }
+
+  // every training pass draws a new mask
+  bool is_recomputable() const override { return phase_ != net_phase::train; }
+
   std::string layer_type() const override { return "dropout"; }
 
   // currently used by tests only
-  const std::vector<uint8_t> &get_mask(size_t sample_index) const {
-    return mask_[sample_index];
+  std::vector<uint8_t> get_mask(size_t sample_index) const {
+    const std::vector<uint32_t> &bits = mask_[sample_index];
+    std::vector<uint8_t> mask(in_size_);
+    for (size_t i = 0; i < in_size_; i++) {
+      mask[i] = (bits[i / 32] >> (i % 32)) & 1;
+    }
+    return mask;
   }
 
   void clear_mask() {
@@ -137,11 +144,15 @@ class dropout_layer : public layer {
   friend struct serialization_buddy;
 
  private:
+  size_t mask_words() const { return (in_size_ + 31) / 32; }
+
   net_phase phase_;
   float_t dropout_rate_;
   float_t scale_;
   size_t in_size_;
-  std::vector<std::vector<uint8_t>> mask_;
+  std::vector<std::vector<uint32_t>> mask_;  // packed, bit i of word i / 32
+  philox_stream rng_;
+  uint32_t pass_;
 };
 
 }  // namespace tiny_dnn
@@ -7,6 +7,7 @@
 */
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
@@ -16,6 +17,7 @@
 
 #include "tiny_dnn/core/kernels/fully_connected_grad_op.h"
 #include "tiny_dnn/core/kernels/fully_connected_op.h"
+#include "tiny_dnn/core/kernels/tiny_fake_quantization_kernel.h"
 
 namespace tiny_dnn {
 
@@ -44,7 +46,9 @@ class fully_connected_layer : public layer {
     : layer(std::move(other)),
       params_(std::move(other.params_)),
       kernel_fwd_(std::move(other.kernel_fwd_)),
-      kernel_back_(std::move(other.kernel_back_)) {
+      kernel_back_(std::move(other.kernel_back_)),
+      fake_quant_(std::move(other.fake_quant_)),
+      phase_(other.phase_) {
     init_backend(std::move(other.engine()));
   }
 
@@ -69,21 +73,43 @@ class fully_connected_layer : public layer {
 
   void forward_propagation(const std::vector<tensor_t *> &in_data,
                            std::vector<tensor_t *> &out_data) override {
+    fwd_in_data_.resize(in_data.size());
+    std::copy(in_data.begin(), in_data.end(), fwd_in_data_.begin());
+    if (fake_quant_.enabled) {
+      core::kernels::fake_quantize_inputs(&fake_quant_,
+                                          phase_ == net_phase::train,
+                                          &fwd_in_data_, &fake_quant_buf_);
+    }
+
     // forward fully connected op context
-    fwd_ctx_.set_in_out(in_data, out_data);
+    fwd_ctx_.set_in_out(fwd_in_data_, out_data);
     fwd_ctx_.setParallelize(layer::parallelize());
     fwd_ctx_.setEngine(layer::engine());
 
     // launch fully connected kernel
     kernel_fwd_->compute(fwd_ctx_);
+
+    if (fake_quant_.enabled) {
+      core::kernels::fake_quantize_output(
+        &fake_quant_, phase_ == net_phase::train, out_data[0]);
+    }
   }
 
   void back_propagation(const std::vector<tensor_t *> &in_data,
                         const std::vector<tensor_t *> &out_data,
                         std::vector<tensor_t *> &out_grad,
                         std::vector<tensor_t *> &in_grad) override {
+    bwd_in_data_.resize(in_data.size());
+    std::copy(in_data.begin(), in_data.end(), bwd_in_data_.begin());
+    // straight-through estimator, see convolutional_layer::back_propagation
+    if (fake_quant_.enabled) {
+      for (size_t i = 0; i < bwd_in_data_.size(); i++) {
+        bwd_in_data_[i] = &fake_quant_buf_[i];
+      }
+    }
+
     // backward fully connected op context
-    bwd_ctx_.set_in_out(in_data, out_data, out_grad, in_grad);
+    bwd_ctx_.set_in_out(bwd_in_data_, out_data, out_grad, in_grad);
     bwd_ctx_.setParallelize(layer::parallelize());
     bwd_ctx_.setEngine(layer::engine());
 
@@ -91,8 +117,37 @@ class fully_connected_layer : public layer {
     kernel_back_->compute(bwd_ctx_);
   }
 
+  void set_context(net_phase ctx) override { phase_ = ctx; }
+
+  // quantization-aware training, see
+  // convolutional_layer::enable_fake_quantization
+  void enable_fake_quantization(float_t momentum = float_t(0.99)) {
+    fake_quant_.enabled  = true;
+    fake_quant_.momentum = momentum;
+  }
+
+  void disable_fake_quantization() { fake_quant_.enabled = false; }
+
+  bool fake_quantization() const { return fake_quant_.enabled; }
+
+  void set_quantization_ranges(const core::quantization_range &in_range,
+                               const core::quantization_range &out_range) {
+    fake_quant_.in_range  = in_range;
+    fake_quant_.out_range = out_range;
+  }
+
+  const core::quantization_range &input_range() const {
+    return fake_quant_.in_range;
+  }
+
+  const core::quantization_range &output_range() const {
+    return fake_quant_.out_range;
+  }
+
   std::string layer_type() const override { return "fully-connected"; }
 
+  bool backward_reads_output() const override { return false; }
+
   friend struct serialization_buddy;
 
  protected:
@@ -129,6 +184,14 @@ class fully_connected_layer : public layer {
   /* Forward and backward ops */
   std::shared_ptr<core::OpKernel> kernel_fwd_;
   std::shared_ptr<core::OpKernel> kernel_back_;
+
+  std::vector<tensor_t *> fwd_in_data_;
+  std::vector<tensor_t *> bwd_in_data_;
+
+  /* Quantization-aware training state and rounded copies of the inputs */
+  core::fake_quantization_params fake_quant_;
+  std::vector<tensor_t> fake_quant_buf_;
+  net_phase phase_ = net_phase::train;
 };
 
 }  // namespace tiny_dnn
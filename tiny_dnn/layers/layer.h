@@ -25,6 +25,7 @@
 
 #include "tiny_dnn/util/parallel_for.h"
 #include "tiny_dnn/util/product.h"
+#include "tiny_dnn/util/sequence_batch.h"
 #include "tiny_dnn/util/util.h"
 #include "tiny_dnn/util/weight_init.h"
 
@@ -70,8 +71,9 @@ class layer : public node {
       in_type_(in_type),
       out_type_(out_type) {
     weight_init_ = std::make_shared<weight_init::xavier>();
-    bias_init_   = std::make_shared<weight_init::constant>();
-    trainable_   = true;
+    bias_init_      = std::make_shared<weight_init::constant>();
+    trainable_      = true;
+    shares_weights_ = false;
   }
 
   layer(const layer &) = default;
@@ -215,11 +217,11 @@ class layer : public node {
     size_t n = 0;
     for (size_t i = 0; i < out_channels_; i++) {
       if (out_type_[i] != vector_type::data) continue;
-      tensor_t &dst_grad = *ith_out_node(i)->get_gradient();
       assert(n < cnt);
       const auto &src_grad = grad[n++];
       size_t sz            = src_grad.size();
-      dst_grad.resize(sz);
+      ith_out_node(i)->set_sample_count(sz, false);
+      tensor_t &dst_grad = *ith_out_node(i)->get_gradient();
       for (size_t j = 0; j < sz; ++j) {
         assert(dst_grad[j].size() == src_grad[j]->size());
         dst_grad[j] = *src_grad[j];
@@ -232,13 +234,16 @@ class layer : public node {
     size_t n = 0;
     for (size_t i = 0; i < in_channels_; i++) {
       if (in_type_[i] != vector_type::data) continue;
-      tensor_t &dst_data = *ith_in_node(i)->get_data();
       assert(n < cnt);
       const auto &src_data = data[n++];
       size_t sz            = src_data.size();
-      dst_data.resize(sz);
+      edge &dst            = *ith_in_node(i);
+      // resized by the edge, which keeps the samples in one block
+      dst.set_sample_count(sz, true);
+      tensor_t &dst_data = *dst.get_data();
       for (size_t j = 0; j < sz; ++j) {
-        assert(dst_data[j].size() == src_data[j]->size());
+        assert(dst_data[j].empty() ||
+               dst_data[j].size() == src_data[j]->size());
         dst_data[j] = *src_data[j];
       }
     }
@@ -253,6 +258,22 @@ class layer : public node {
     }
   }
 
+  // edge of the first data input of the layer, nullptr if it has none
+  edge *data_input() {
+    for (size_t i = 0; i < in_channels_; i++) {
+      if (in_type_[i] == vector_type::data) return ith_in_node(i).get();
+    }
+    return nullptr;
+  }
+
+  // edge of the first data output of the layer, nullptr if it has none
+  edge *data_output() {
+    for (size_t i = 0; i < out_channels_; i++) {
+      if (out_type_[i] == vector_type::data) return ith_out_node(i).get();
+    }
+    return nullptr;
+  }
+
   std::vector<vector_type> in_types() const { return in_type_; }
 
   std::vector<vector_type> out_types() const { return out_type_; }
@@ -261,6 +282,14 @@ class layer : public node {
 
   bool trainable() const { return trainable_; }
 
+  /**
+   * counter bumped whenever mutable access to the weights is handed out
+   * (initialization, update_weight, load, weights()). layers keeping derived
+   * copies of their weights (e.g. quantized layers) compare it to detect
+   * stale copies.
+   **/
+  size_t weights_version() const { return weights_version_; }
+
   /**
    * return output value range
    * used only for calculating target value from label-id in final(output)
@@ -442,6 +471,75 @@ class layer : public node {
    **/
   virtual void set_context(net_phase ctx) { CNN_UNREFERENCED_PARAMETER(ctx); }
 
+  /**
+   * notify the lengths of the padded sequences of the next batches (an empty
+   * sequence_batch for sequences without padding)
+   **/
+  virtual void set_sequence_batch(const sequence_batch &seq) {
+    CNN_UNREFERENCED_PARAMETER(seq);
+  }
+
+  /**
+   * (input channel, output channel) pairs carrying the recurrent state of the
+   * layer from one step to the next, e.g. h(t-1) -> h(t); used to feed
+   * streams one frame at a time (see network::step)
+   **/
+  virtual std::vector<std::pair<size_t, size_t>> state_channels() const {
+    return {};
+  }
+
+  /**
+   * whether the next forward pass leaves the data input unchanged (e.g.
+   * dropout in the test phase); the output then shares the input's data
+   * instead of a copy, and forward_propagation is not called
+   **/
+  virtual bool is_pass_through() const { return false; }
+
+  /**
+   * called at the start of every forward pass; layers whose outputs are
+   * parts of their inputs, or the reverse (e.g. slice, concat), make the
+   * edges views of one another here (see edge::view_features) so that their
+   * forward and backward passes have nothing left to copy
+   **/
+  virtual void share_storage() {}
+
+  /**
+   * whether the layer can compute its data output over its data input (e.g.
+   * relu), the input being left with the output's values. In training, the
+   * backward pass must then not need the input values, only the output.
+   **/
+  virtual bool supports_in_place(bool training) const {
+    CNN_UNREFERENCED_PARAMETER(training);
+    return false;
+  }
+
+  /**
+   * whether back_propagation reads the data outputs of the layer; when it
+   * doesn't (e.g. fully connected), the next layer may overwrite them in
+   * training too
+   **/
+  virtual bool backward_reads_output() const { return true; }
+
+  /**
+   * whether forward_propagation gives the same outputs when run again on
+   * the same inputs, so that they can be dropped after the forward pass and
+   * computed again for the backward one (see nodes::set_checkpoints)
+   **/
+  virtual bool is_recomputable() const { return true; }
+
+  /**
+   * make the data output share the data input when the layer passes it
+   * through or computes in place over it (the input having no other
+   * consumer), else give it its own data back; called at every forward
+   * pass and by the memory planner
+   **/
+  void share_input() {
+    const bool training = ith_out_node(0)->gradient_enabled();
+    const bool in_place = is_pass_through() ||
+                          (supports_in_place(training) && owns_input(training));
+    ith_out_node(0)->alias_data(in_place ? ith_in_node(0).get() : nullptr);
+  }
+
   /* @brief Performs layer forward operation given an input tensor and
    * returns the computed data in tensor form.
    *
@@ -519,9 +617,21 @@ class layer : public node {
    *
    */
   void forward() {
+    prepare_forward();
+    run_forward();
+  }
+
+  /**
+   * the bookkeeping part of forward(): sizes, storage and pointers to the
+   * data of the edges; run_forward() then only computes, so that layers
+   * prepared one after another can run concurrently when they don't depend
+   * on one another (see nodes::set_parallel_branches)
+   **/
+  void prepare_forward() {
     // the computational graph
     fwd_in_data_.resize(in_channels_);
     fwd_out_data_.resize(out_channels_);
+    share_storage();
 
     // Organize input/output vectors from storage (computational graph).
     // Internally ith_in_node() will create a connection/edge in the
@@ -531,6 +641,8 @@ class layer : public node {
       fwd_in_data_[i] = ith_in_node(i)->get_data();
     }
 
+    share_input();
+
     // resize outs and stuff to have room for every input sample in
     // the batch
     set_sample_count(fwd_in_data_[0]->size());
@@ -543,12 +655,21 @@ class layer : public node {
       fwd_out_data_[i] = ith_out_node(i)->get_data();
       ith_out_node(i)->clear_grads();
     }
+  }
 
+  // the computation part of forward(), after prepare_forward()
+  void run_forward() {
     // call the forward computation kernel/routine
-    forward_propagation(fwd_in_data_, fwd_out_data_);
+    if (!is_pass_through()) forward_propagation(fwd_in_data_, fwd_out_data_);
   }
 
   void backward() {
+    prepare_backward();
+    run_backward();
+  }
+
+  // the bookkeeping part of backward(), see prepare_forward()
+  void prepare_backward() {
     bwd_in_data_.resize(in_channels_);
     bwd_in_grad_.resize(in_channels_);
     bwd_out_data_.resize(out_channels_);
@@ -565,6 +686,10 @@ class layer : public node {
       bwd_out_data_[i] = nd->get_data();
       bwd_out_grad_[i] = nd->get_gradient();
     }
+  }
+
+  // the computation part of backward(), after prepare_backward()
+  void run_backward() {
     back_propagation(bwd_in_data_, bwd_out_data_, bwd_out_grad_, bwd_in_grad_);
   }
 
@@ -674,6 +799,23 @@ class layer : public node {
     post_update();
   }
 
+  /**
+   * read the weights and biases of another layer of the same kind and shape
+   * instead of holding its own, e.g. in an inference session (see
+   * network::session). The layer then neither initializes nor resizes
+   * them, and must not be trained.
+   **/
+  void share_weights(layer &src) {
+    if (src.in_type_ != in_type_ || src.in_shape() != in_shape()) {
+      throw nn_error("weights of another shape");
+    }
+    for (size_t i = 0; i < in_channels_; i++) {
+      if (is_trainable_weight(in_type_[i])) prev_[i] = src.ith_in_node(i);
+    }
+    initialized_    = true;
+    shares_weights_ = true;
+  }
+
   bool has_same_weights(const layer &rhs, float_t eps) const {
     auto w1 = weights();
     auto w2 = rhs.weights();
@@ -690,23 +832,16 @@ class layer : public node {
   }
 
   virtual void set_sample_count(size_t sample_count) {
-    // increase the size if necessary - but do not decrease
-    auto resize = [sample_count](tensor_t *tensor) {
-      tensor->resize(sample_count, (*tensor)[0]);
-    };
-
     for (size_t i = 0; i < in_channels_; i++) {
-      if (!is_trainable_weight(in_type_[i])) {
-        resize(ith_in_node(i)->get_data());
-      }
-      resize(ith_in_node(i)->get_gradient());
+      // the gradients of shared weights are left to their owner
+      if (shares_weights_ && is_trainable_weight(in_type_[i])) continue;
+      ith_in_node(i)->set_sample_count(sample_count,
+                                       !is_trainable_weight(in_type_[i]));
     }
 
     for (size_t i = 0; i < out_channels_; i++) {
-      if (!is_trainable_weight(out_type_[i])) {
-        resize(ith_out_node(i)->get_data());
-      }
-      resize(ith_out_node(i)->get_gradient());
+      ith_out_node(i)->set_sample_count(sample_count,
+                                        !is_trainable_weight(out_type_[i]));
     }
   }
 
@@ -745,6 +880,8 @@ class layer : public node {
    * frequent
    * memory allocation */
   vec_t weights_diff_;
+  /** Incremented on every mutable access to the weights */
+  size_t weights_version_ = 0;
 
   template <typename T, typename Func>
   inline void for_i(T size, Func f, size_t grainsize = 100) {
@@ -756,6 +893,8 @@ class layer : public node {
  private:
   /** Flag indicating whether the layer/node parameters are trainable */
   bool trainable_;
+  /** Flag indicating whether the weights are those of another layer */
+  bool shares_weights_;
   /** Pointer to the function for weights initialization */
   std::shared_ptr<weight_init::function> weight_init_;
   /** Pointer to the function for biases initialization */
@@ -832,13 +971,36 @@ class layer : public node {
   }
   edgeptr_t ith_out_node(size_t i) const { return next()[i]; }
 
+  /* @brief Whether the data input may be overwritten by this layer.
+   *
+   * Following the outputs of pass-through and in-place layers back to the
+   * edge holding the data, every edge on the way must be read by one layer
+   * only and written by a layer which, in training, doesn't read it again
+   * in its backward pass. Views of a concatenation or slice are left alone,
+   * slots of the memory planner are not.
+   */
+  bool owns_input(bool training) {
+    edge *e = ith_in_node(0).get();
+    for (;;) {
+      auto producer = dynamic_cast<layer *>(e->prev());
+      if (!producer || e->next().size() != 1) return false;
+      if (training && producer->backward_reads_output()) return false;
+      if (!e->alias()) break;
+      e = e->alias();
+    }
+    edge *storage = e->storage();
+    return storage == e || storage->next().empty();
+  }
+
   /* @brief Retrieves weight vector from incoming edge
    * @param i The position of incoming edge.
    *
-   * Returns the mutable pointer to the edge raw data.
+   * Returns the mutable pointer to the edge raw data. Since the caller
+   * may write through it, the weights version is bumped.
    */
   vec_t *get_weight_data(size_t i) {
     assert(is_trainable_weight(in_type_[i]));
+    ++weights_version_;
     return &(*(ith_in_node(i)->get_data()))[0];
   }
 
@@ -19,12 +19,17 @@
 #include "tiny_dnn/layers/layer.h"
 #include "tiny_dnn/layers/linear_layer.h"
 #include "tiny_dnn/layers/lrn_layer.h"
+#include "tiny_dnn/layers/lstm_cell_layer.h"
 #include "tiny_dnn/layers/max_pooling_layer.h"
 #include "tiny_dnn/layers/max_unpooling_layer.h"
 #include "tiny_dnn/layers/partial_connected_layer.h"
 #include "tiny_dnn/layers/power_layer.h"
+#include "tiny_dnn/layers/quantize_layer.h"
+#include "tiny_dnn/layers/quantized_concat_layer.h"
 #include "tiny_dnn/layers/quantized_convolutional_layer.h"
 #include "tiny_dnn/layers/quantized_deconvolutional_layer.h"
 #include "tiny_dnn/layers/quantized_fully_connected_layer.h"
+#include "tiny_dnn/layers/quantized_relu_layer.h"
 #include "tiny_dnn/layers/recurrent_cell_layer.h"
+#include "tiny_dnn/layers/recurrent_layer.h"
 #include "tiny_dnn/layers/slice_layer.h"
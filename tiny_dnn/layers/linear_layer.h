@@ -43,6 +43,13 @@ class linear_layer : public layer {
 
   std::string layer_type() const override { return "linear"; }
 
+  bool supports_in_place(bool training) const override {
+    CNN_UNREFERENCED_PARAMETER(training);
+    return true;
+  }
+
+  bool backward_reads_output() const override { return false; }
+
   void forward_propagation(const std::vector<tensor_t *> &in_data,
                            std::vector<tensor_t *> &out_data) override {
     const tensor_t &in = *in_data[0];
@@ -85,8 +85,8 @@ class lrn_layer : public layer {
     // @todo revise the parallelism strategy
     for (size_t sample = 0, sample_count = in_data[0]->size();
          sample < sample_count; ++sample) {
-      vec_t &in  = (*in_data[0])[sample];
-      vec_t &out = (*out_data[0])[sample];
+      row_t &in  = (*in_data[0])[sample];
+      row_t &out = (*out_data[0])[sample];
 
       if (region_ == norm_region::across_channels) {
         forward_across(in, out);
@@ -0,0 +1,137 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "tiny_dnn/core/kernels/lstm_cell_op_internal.h"
+#include "tiny_dnn/layers/layer.h"
+
+namespace tiny_dnn {
+
+/**
+ * LSTM layer.
+ *
+ * > [i f g o] = [x(t), h(t-1)] * W + b
+ * > c(t) = sigmoid(f) * c(t-1) + sigmoid(i) * tanh(g)
+ * > h(t) = sigmoid(o) * tanh(c(t))
+ *
+ * The four gates come out of one gemm over the batch, and the activations
+ * and the state update are fused into a single pass, instead of a graph of
+ * recurrent cells, elementwise and activation layers. Like
+ * recurrent_cell_layer, h(t-1) and c(t-1) are aux inputs and c(t) an aux
+ * output; h(t) is the data output.
+ **/
+class lstm_cell_layer : public layer {
+ public:
+  inline std::vector<vector_type> lstm_order(bool has_bias) {
+    if (has_bias) {
+      return {vector_type::data,    // input vector
+              vector_type::aux,     // input state (h(t-1))
+              vector_type::aux,     // input cell state (c(t-1))
+              vector_type::weight,  // gate weights (W)
+              vector_type::bias};   // gate bias (b)
+    } else {
+      return {vector_type::data,     // input vector
+              vector_type::aux,      // input state (h(t-1))
+              vector_type::aux,      // input cell state (c(t-1))
+              vector_type::weight};  // gate weights (W)
+    }
+  }
+
+  /**
+   * @param in_dim [in] number of elements of the input
+   * @param out_dim [in] number of elements of the output (and the state)
+   * @param has_bias [in] whether to include additional bias to the layer
+   **/
+  lstm_cell_layer(size_t in_dim, size_t out_dim, bool has_bias = true)
+    : layer(lstm_order(has_bias),
+            {vector_type::data,    // output vector (h(t))
+             vector_type::aux}) {  // output cell state (c(t))
+    params_.in_size_  = in_dim;
+    params_.out_size_ = out_dim;
+    params_.has_bias_ = has_bias;
+  }
+
+  size_t fan_in_size(size_t i) const override { return in_shape()[i].width_; }
+
+  size_t fan_out_size(size_t i) const override { return in_shape()[i].height_; }
+
+  std::vector<index3d<size_t>> in_shape() const override {
+    std::vector<index3d<size_t>> shapes = {
+      index3d<size_t>(params_.in_size_, 1, 1),   // x
+      index3d<size_t>(params_.out_size_, 1, 1),  // h(t-1)
+      index3d<size_t>(params_.out_size_, 1, 1),  // c(t-1)
+      index3d<size_t>(params_.xh_size(), params_.gates_size(), 1)};  // W
+    if (params_.has_bias_) {
+      shapes.push_back(index3d<size_t>(params_.gates_size(), 1, 1));  // b
+    }
+    return shapes;
+  }
+
+  std::vector<index3d<size_t>> out_shape() const override {
+    return {index3d<size_t>(params_.out_size_, 1, 1),   // h(t)
+            index3d<size_t>(params_.out_size_, 1, 1)};  // c(t)
+  }
+
+  std::string layer_type() const override { return "lstm-cell"; }
+
+  std::vector<std::pair<size_t, size_t>> state_channels() const override {
+    return {{1, 0},   // h(t-1) -> h(t)
+            {2, 1}};  // c(t-1) -> c(t)
+  }
+
+  void forward_propagation(const std::vector<tensor_t *> &in_data,
+                           std::vector<tensor_t *> &out_data) override {
+    const size_t batch = in_data[0]->size();
+    const vec_t empty;
+
+    resize_buffer(&xh_, batch, params_.xh_size());
+    resize_buffer(&gates_, batch, params_.gates_size());
+
+    kernels::lstm_cell_op_internal(
+      *in_data[0], *in_data[1], *in_data[2], (*in_data[3])[0],
+      params_.has_bias_ ? (*in_data[4])[0] : empty, *out_data[0],
+      *out_data[1], xh_, gates_, params_, layer::parallelize());
+  }
+
+  void back_propagation(const std::vector<tensor_t *> &in_data,
+                        const std::vector<tensor_t *> &out_data,
+                        std::vector<tensor_t *> &out_grad,
+                        std::vector<tensor_t *> &in_grad) override {
+    const size_t batch = in_data[0]->size();
+    tensor_t dummy;  // need lvalue for non-const reference
+
+    resize_buffer(&dgates_, batch, params_.gates_size());
+    resize_buffer(&dxh_, batch, params_.xh_size());
+
+    kernels::lstm_cell_op_internal(
+      *in_data[2], (*in_data[3])[0], *in_grad[3],
+      params_.has_bias_ ? *in_grad[4] : dummy, *out_data[1], *out_grad[0],
+      *out_grad[1], *in_grad[0], *in_grad[1], *in_grad[2], xh_, gates_,
+      dgates_, dxh_, params_, layer::parallelize());
+  }
+
+  friend struct serialization_buddy;
+
+ private:
+  void resize_buffer(tensor_t *buf, size_t rows, size_t size) {
+    if (buf->size() != rows) buf->resize(rows, vec_t(size));
+  }
+
+  core::lstm_cell_params params_;
+
+  // [x(t), h(t-1)], the activated gates and their gradients, per sample
+  tensor_t xh_;
+  tensor_t gates_;
+  tensor_t dgates_;
+  tensor_t dxh_;
+};
+
+}  // namespace tiny_dnn
@@ -159,6 +159,8 @@ class max_pooling_layer : public layer {
 
   void set_sample_count(size_t sample_count) override {
     layer::set_sample_count(sample_count);
+    // no row to build when the batch size is unchanged
+    if (params_.out2inmax.size() == sample_count) return;
     params_.out2inmax.resize(sample_count,
                              std::vector<size_t>(params_.out.size()));
   }
@@ -85,8 +85,8 @@ class max_unpooling_layer : public layer {
     tensor_t &out      = *out_data[0];
 
     for (size_t sample = 0; sample < in_data[0]->size(); sample++) {
-      const vec_t &in_vec = in[sample];
-      vec_t &out_vec      = out[sample];
+      const row_t &in_vec = in[sample];
+      row_t &out_vec      = out[sample];
 
       std::vector<size_t> &max_idx = worker_storage_.in2outmax_;
 
@@ -106,8 +106,8 @@ class max_unpooling_layer : public layer {
     tensor_t &curr_delta = *out_grad[0];
 
     for (size_t sample = 0; sample < in_data[0]->size(); sample++) {
-      vec_t &prev_delta_vec = prev_delta[sample];
-      vec_t &curr_delta_vec = curr_delta[sample];
+      row_t &prev_delta_vec = prev_delta[sample];
+      row_t &curr_delta_vec = curr_delta[sample];
 
       std::vector<size_t> &max_idx = worker_storage_.in2outmax_;
 
@@ -63,14 +63,14 @@ class partial_connected_layer : public layer {
   void forward_propagation(const std::vector<tensor_t *> &in_data,
                            std::vector<tensor_t *> &out_data) override {
     const tensor_t &in = *in_data[0];
-    const vec_t &W     = (*in_data[1])[0];
-    const vec_t &b     = (*in_data[2])[0];
+    const row_t &W     = (*in_data[1])[0];
+    const row_t &b     = (*in_data[2])[0];
     tensor_t &out      = *out_data[0];
 
     // @todo revise the parallelism strategy
     for (size_t sample = 0, sample_count = in.size(); sample < sample_count;
          ++sample) {
-      vec_t &out_sample = out[sample];
+      row_t &out_sample = out[sample];
 
       for_i(out2wi_.size(), [&](size_t i) {
         const wi_connections &connections = out2wi_[i];
@@ -94,9 +94,9 @@ class partial_connected_layer : public layer {
                         std::vector<tensor_t *> &in_grad) override {
     CNN_UNREFERENCED_PARAMETER(out_data);
     const tensor_t &prev_out = *in_data[0];
-    const vec_t &W           = (*in_data[1])[0];
-    vec_t &dW                = (*in_grad[1])[0];
-    vec_t &db                = (*in_grad[2])[0];
+    const row_t &W           = (*in_data[1])[0];
+    row_t &dW                = (*in_grad[1])[0];
+    row_t &db                = (*in_grad[2])[0];
     tensor_t &prev_delta     = *in_grad[0];
     tensor_t &curr_delta     = *out_grad[0];
 
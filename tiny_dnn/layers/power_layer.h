@@ -52,6 +52,9 @@ class power_layer : public layer {
 
   std::string layer_type() const override { return "power"; }
 
+  // the backward pass needs x as well as y
+  bool supports_in_place(bool training) const override { return !training; }
+
   std::vector<shape3d> in_shape() const override { return {in_shape_}; }
 
   std::vector<shape3d> out_shape() const override { return {in_shape_}; }
@@ -0,0 +1,129 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "tiny_dnn/core/kernels/tiny_quantization_kernel.h"
+#include "tiny_dnn/layers/layer.h"
+#include "tiny_dnn/util/util.h"
+
+namespace tiny_dnn {
+
+/**
+ * entry of an int8 section of a network: converts float values to the 8-bit
+ * codes of a static range (see quantized_convolutional_layer::set_int8_io)
+ **/
+class quantize_layer : public layer {
+ public:
+  /**
+   * @param in_shape [in] shape of input tensor
+   * @param range    [in] float range the codes are taken in
+   */
+  quantize_layer(const shape3d &in_shape, const core::quantization_range &range)
+    : layer({vector_type::data}, {vector_type::data}),
+      in_shape_(in_shape),
+      range_(range) {
+    if (!range_.is_static()) throw nn_error("quantize_layer needs a range");
+  }
+
+  std::string layer_type() const override { return "quantize"; }
+
+  std::vector<shape3d> in_shape() const override { return {in_shape_}; }
+
+  std::vector<shape3d> out_shape() const override { return {in_shape_}; }
+
+  const core::quantization_range &range() const { return range_; }
+
+  void forward_propagation(const std::vector<tensor_t *> &in_data,
+                           std::vector<tensor_t *> &out_data) override {
+    const tensor_t &x = *in_data[0];
+    tensor_t &y       = *out_data[0];
+
+    for_i(x.size(), [&](size_t i) {
+      for (size_t j = 0; j < x[i].size(); j++) {
+        y[i][j] = core::kernels::float_to_quantized<uint8_t>(
+          x[i][j], range_.min, range_.max);
+      }
+    });
+  }
+
+  // straight-through: the gradient is passed on as it is
+  void back_propagation(const std::vector<tensor_t *> &in_data,
+                        const std::vector<tensor_t *> &out_data,
+                        std::vector<tensor_t *> &out_grad,
+                        std::vector<tensor_t *> &in_grad) override {
+    CNN_UNREFERENCED_PARAMETER(in_data);
+    CNN_UNREFERENCED_PARAMETER(out_data);
+    *in_grad[0] = *out_grad[0];
+  }
+
+  friend struct serialization_buddy;
+
+ private:
+  shape3d in_shape_;
+  core::quantization_range range_;
+};
+
+/**
+ * exit of an int8 section of a network: converts the 8-bit codes of a static
+ * range back to float values
+ **/
+class dequantize_layer : public layer {
+ public:
+  /**
+   * @param in_shape [in] shape of input tensor
+   * @param range    [in] float range of the incoming codes
+   */
+  dequantize_layer(const shape3d &in_shape,
+                   const core::quantization_range &range)
+    : layer({vector_type::data}, {vector_type::data}),
+      in_shape_(in_shape),
+      range_(range) {
+    if (!range_.is_static()) throw nn_error("dequantize_layer needs a range");
+  }
+
+  std::string layer_type() const override { return "dequantize"; }
+
+  std::vector<shape3d> in_shape() const override { return {in_shape_}; }
+
+  std::vector<shape3d> out_shape() const override { return {in_shape_}; }
+
+  const core::quantization_range &range() const { return range_; }
+
+  void forward_propagation(const std::vector<tensor_t *> &in_data,
+                           std::vector<tensor_t *> &out_data) override {
+    const tensor_t &x = *in_data[0];
+    tensor_t &y       = *out_data[0];
+
+    for_i(x.size(), [&](size_t i) {
+      for (size_t j = 0; j < x[i].size(); j++) {
+        y[i][j] = core::kernels::quantized_to_float<uint8_t>(
+          static_cast<uint8_t>(x[i][j]), range_.min, range_.max);
+      }
+    });
+  }
+
+  void back_propagation(const std::vector<tensor_t *> &in_data,
+                        const std::vector<tensor_t *> &out_data,
+                        std::vector<tensor_t *> &out_grad,
+                        std::vector<tensor_t *> &in_grad) override {
+    CNN_UNREFERENCED_PARAMETER(in_data);
+    CNN_UNREFERENCED_PARAMETER(out_data);
+    *in_grad[0] = *out_grad[0];
+  }
+
+  friend struct serialization_buddy;
+
+ private:
+  shape3d in_shape_;
+  core::quantization_range range_;
+};
+
+}  // namespace tiny_dnn
@@ -0,0 +1,124 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "tiny_dnn/core/kernels/tiny_quantization_kernel.h"
+#include "tiny_dnn/layers/layer.h"
+#include "tiny_dnn/util/util.h"
+
+namespace tiny_dnn {
+
+/**
+ * concat N 8-bit coded inputs along depth.
+ *
+ * Each input is carried in its own static range; the codes are rewritten into
+ * the output range through a 256-entry table per input, so nothing is
+ * dequantized on the way.
+ **/
+class quantized_concat_layer : public layer {
+ public:
+  /**
+   * @param in_shapes [in] shapes of input tensors
+   * @param in_ranges [in] float ranges of the incoming codes
+   * @param out_range [in] float range of the outgoing codes
+   */
+  quantized_concat_layer(const std::vector<shape3d> &in_shapes,
+                         const std::vector<core::quantization_range> &in_ranges,
+                         const core::quantization_range &out_range)
+    : layer(std::vector<vector_type>(in_shapes.size(), vector_type::data),
+            {vector_type::data}),
+      in_shapes_(in_shapes),
+      in_ranges_(in_ranges),
+      out_range_(out_range) {
+    if (in_ranges_.size() != in_shapes_.size())
+      throw nn_error("quantized_concat needs one range per input");
+    if (!out_range_.is_static())
+      throw nn_error("quantized_concat needs an output range");
+
+    out_shape_ = in_shapes_.front();
+    for (size_t i = 1; i < in_shapes_.size(); i++) {
+      if (in_shapes_[i].area() != out_shape_.area())
+        throw nn_error("each input shapes to concat must have same WxH size");
+      out_shape_.depth_ += in_shapes_[i].depth_;
+    }
+
+    tables_.resize(in_ranges_.size());
+    for (size_t i = 0; i < in_ranges_.size(); i++) {
+      if (!in_ranges_[i].is_static())
+        throw nn_error("quantized_concat needs an input range");
+      tables_[i].resize(256);
+      for (size_t q = 0; q < 256; q++) {
+        tables_[i][q] = core::kernels::requantize_in_new_range<uint8_t,
+                                                               uint8_t>(
+          static_cast<uint8_t>(q), in_ranges_[i].min, in_ranges_[i].max,
+          out_range_.min, out_range_.max);
+      }
+    }
+  }
+
+  std::string layer_type() const override { return "q_concat"; }
+
+  std::vector<shape3d> in_shape() const override { return in_shapes_; }
+
+  std::vector<shape3d> out_shape() const override { return {out_shape_}; }
+
+  void forward_propagation(const std::vector<tensor_t *> &in_data,
+                           std::vector<tensor_t *> &out_data) override {
+    const size_t num_samples = (*out_data[0]).size();
+
+    for_i(num_samples, [&](size_t s) {
+      float_t *outs = &(*out_data[0])[s][0];
+
+      for (size_t i = 0; i < in_shapes_.size(); i++) {
+        const float_t *ins   = &(*in_data[i])[s][0];
+        const uint8_t *table = &tables_[i][0];
+        const size_t dim     = in_shapes_[i].size();
+        for (size_t j = 0; j < dim; j++) {
+          outs[j] = table[static_cast<uint8_t>(ins[j])];
+        }
+        outs += dim;
+      }
+    });
+  }
+
+  void back_propagation(const std::vector<tensor_t *> &in_data,
+                        const std::vector<tensor_t *> &out_data,
+                        std::vector<tensor_t *> &out_grad,
+                        std::vector<tensor_t *> &in_grad) override {
+    CNN_UNREFERENCED_PARAMETER(in_data);
+    CNN_UNREFERENCED_PARAMETER(out_data);
+
+    size_t num_samples = (*out_grad[0]).size();
+
+    for_i(num_samples, [&](size_t s) {
+      const float_t *outs = &(*out_grad[0])[s][0];
+
+      for (size_t i = 0; i < in_shapes_.size(); i++) {
+        size_t dim   = in_shapes_[i].size();
+        float_t *ins = &(*in_grad[i])[s][0];
+        std::copy(outs, outs + dim, ins);
+        outs += dim;
+      }
+    });
+  }
+
+  friend struct serialization_buddy;
+
+ private:
+  std::vector<shape3d> in_shapes_;
+  std::vector<core::quantization_range> in_ranges_;
+  core::quantization_range out_range_;
+  shape3d out_shape_;
+  std::vector<std::vector<uint8_t>> tables_;
+};
+
+}  // namespace tiny_dnn
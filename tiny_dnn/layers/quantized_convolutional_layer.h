@@ -215,7 +215,46 @@ class quantized_convolutional_layer : public layer {
     : layer(std::move(other)),
       params_(std::move(other.params_)),
       cws_(std::move(other.cws_)) {
-    init_backend(core::backend_t::internal);
+    init_backend(std::move(other.engine()));
+  }
+
+  /**
+   * fixes the float ranges the input and the output are quantized to (as
+   * found by calibrate_quantization_ranges), so that forward doesn't compute
+   * them from every sample. empty ranges restore the dynamic behavior.
+   **/
+  void set_quantization_ranges(const core::quantization_range &in_range,
+                               const core::quantization_range &out_range) {
+    params_.in_range  = in_range;
+    params_.out_range = out_range;
+    init();
+  }
+
+  /**
+   * int8 execution mode: the input and/or output edge carry the 8-bit codes
+   * of the static input/output range instead of float values, so that
+   * consecutive quantized layers don't dequantize and requantize in between.
+   **/
+  void set_int8_io(bool int8_input, bool int8_output) {
+    if ((int8_input && !params_.in_range.is_static()) ||
+        (int8_output && !params_.out_range.is_static())) {
+      throw nn_error("int8 input/output requires a static range");
+    }
+    params_.int8_input  = int8_input;
+    params_.int8_output = int8_output;
+    init();
+  }
+
+  bool int8_input() const { return params_.int8_input; }
+
+  bool int8_output() const { return params_.int8_output; }
+
+  const core::quantization_range &input_range() const {
+    return params_.in_range;
+  }
+
+  const core::quantization_range &output_range() const {
+    return params_.out_range;
   }
 
   ///< number of incoming connections for each output unit
@@ -344,12 +383,17 @@ class quantized_convolutional_layer : public layer {
     params_.w_stride = w_stride;
     params_.h_stride = h_stride;
     params_.tbl      = tbl;
+    init();
   }
 
   void init() {
     if (params_.pad_type == padding::same) {
-      cws_.prev_out_buf_.resize(1, vec_t(params_.in_padded.size(), float_t{0}));
-      cws_.prev_delta_padded_.resize(
+      // the border holds the code of 0.0 when the input carries 8-bit codes
+      const float_t pad =
+        params_.int8_input ? core::kernels::quantized_zero(params_.in_range)
+                           : float_t{0};
+      cws_.prev_out_buf_.assign(1, vec_t(params_.in_padded.size(), pad));
+      cws_.prev_delta_padded_.assign(
         1, vec_t(params_.in_padded.size(), float_t{0}));
     } else {
       cws_.prev_out_buf_.clear();
@@ -442,8 +486,8 @@ class quantized_convolutional_layer : public layer {
     } else {
       for (size_t sample = 0; sample < delta.size(); sample++) {
         size_t idx       = 0;
-        const vec_t &src = delta[sample];
-        vec_t &dst       = delta_unpadded[sample];
+        const row_t &src = delta[sample];
+        row_t &dst       = delta_unpadded[sample];
 
         for (size_t c = 0; c < params_.in.depth_; c++) {
           float_t *pdst = &dst[params_.in.get_index(0, 0, c)];
@@ -464,8 +508,9 @@ class quantized_convolutional_layer : public layer {
   void init_backend(const core::backend_t backend_type) {
     std::shared_ptr<core::backend> backend = nullptr;
 
-    // allocate new backend
-    if (backend_type == core::backend_t::internal) {
+    // allocate new backend, avx runs the kernels on the 8-bit gemm
+    if (backend_type == core::backend_t::internal ||
+        backend_type == core::backend_t::avx) {
       backend = std::make_shared<core::tiny_backend>(
         &params_, [this](const tensor_t &in) { return copy_and_pad_input(in); },
         [this](const tensor_t &delta, tensor_t &dst) {
@@ -478,6 +523,7 @@ class quantized_convolutional_layer : public layer {
 
     if (backend) {
       layer::set_backend(backend);
+      layer::set_backend_type(backend_type);
       layer::backend_->set_layer(this);
     } else {
       throw nn_error("Could not allocate the backend.");
@@ -220,6 +220,35 @@ class quantized_deconvolutional_layer : public layer {
     init_backend(std::move(layer::engine()));
   }
 
+  // static input/output quantization ranges, empty ranges are dynamic
+  void set_quantization_ranges(const core::quantization_range &in_range,
+                               const core::quantization_range &out_range) {
+    params_.in_range  = in_range;
+    params_.out_range = out_range;
+  }
+
+  // int8 execution mode, see quantized_convolutional_layer::set_int8_io
+  void set_int8_io(bool int8_input, bool int8_output) {
+    if ((int8_input && !params_.in_range.is_static()) ||
+        (int8_output && !params_.out_range.is_static())) {
+      throw nn_error("int8 input/output requires a static range");
+    }
+    params_.int8_input  = int8_input;
+    params_.int8_output = int8_output;
+  }
+
+  bool int8_input() const { return params_.int8_input; }
+
+  bool int8_output() const { return params_.int8_output; }
+
+  const core::quantization_range &input_range() const {
+    return params_.in_range;
+  }
+
+  const core::quantization_range &output_range() const {
+    return params_.out_range;
+  }
+
   ///< number of incoming connections for each output unit
   size_t fan_in_size() const override {
     return params_.weight.width_ * params_.weight.height_ * params_.in.depth_;
@@ -321,8 +350,9 @@ class quantized_deconvolutional_layer : public layer {
   void init_backend(const core::backend_t backend_type) {
     std::shared_ptr<core::backend> backend = nullptr;
 
-    // allocate new backend
-    if (backend_type == core::backend_t::internal) {
+    // allocate new backend, avx runs the kernels on the 8-bit gemm
+    if (backend_type == core::backend_t::internal ||
+        backend_type == core::backend_t::avx) {
       backend = std::make_shared<core::tiny_backend>(
         &params_,
         [this](const tensor_t &in) { return copy_and_unpad_output(in); },
@@ -336,6 +366,7 @@ class quantized_deconvolutional_layer : public layer {
 
     if (backend) {
       layer::set_backend(backend);
+      layer::set_backend_type(backend_type);
       layer::backend_->set_layer(this);
     } else {
       throw nn_error("Could not allocate the backend.");
@@ -432,8 +463,8 @@ class quantized_deconvolutional_layer : public layer {
       delta_padded = delta;
     } else {
       for (size_t sample = 0; sample < delta.size(); sample++) {
-        vec_t &dst       = delta_padded[sample];
-        const vec_t &src = delta[sample];
+        row_t &dst       = delta_padded[sample];
+        const row_t &src = delta[sample];
 
         for (size_t c = 0; c < params_.in.depth_; c++) {
           float_t *pdst      = &dst[params_.in.get_index(0, 0, c)];
@@ -462,7 +493,7 @@ class quantized_deconvolutional_layer : public layer {
       // make unpadded version in order to restore scale in fprop/bprop
       for (size_t sample = 0; sample < out.size(); sample++) {
         size_t idx = 0;
-        vec_t &dst = (*dst_tensor)[sample];
+        row_t &dst = (*dst_tensor)[sample];
 
         for (size_t c = 0; c < params_.out_unpadded.depth_; c++) {
           float_t *pimg = &dst[params_.out_unpadded.get_index(0, 0, c)];
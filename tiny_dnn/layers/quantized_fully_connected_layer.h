@@ -40,7 +40,36 @@ class quantized_fully_connected_layer : public layer {
   // move constructor
   quantized_fully_connected_layer(quantized_fully_connected_layer &&other)
     : layer(std::move(other)), params_(std::move(other.params_)) {
-    init_backend(core::backend_t::internal);
+    init_backend(std::move(other.engine()));
+  }
+
+  // static input/output quantization ranges, empty ranges are dynamic
+  void set_quantization_ranges(const core::quantization_range &in_range,
+                               const core::quantization_range &out_range) {
+    params_.in_range_  = in_range;
+    params_.out_range_ = out_range;
+  }
+
+  // int8 execution mode, see quantized_convolutional_layer::set_int8_io
+  void set_int8_io(bool int8_input, bool int8_output) {
+    if ((int8_input && !params_.in_range_.is_static()) ||
+        (int8_output && !params_.out_range_.is_static())) {
+      throw nn_error("int8 input/output requires a static range");
+    }
+    params_.int8_input_  = int8_input;
+    params_.int8_output_ = int8_output;
+  }
+
+  bool int8_input() const { return params_.int8_input_; }
+
+  bool int8_output() const { return params_.int8_output_; }
+
+  const core::quantization_range &input_range() const {
+    return params_.in_range_;
+  }
+
+  const core::quantization_range &output_range() const {
+    return params_.out_range_;
   }
 
   size_t fan_in_size() const override { return params_.in_size_; }
@@ -95,8 +124,9 @@ class quantized_fully_connected_layer : public layer {
   void init_backend(core::backend_t backend_type) {
     std::shared_ptr<core::backend> backend = nullptr;
 
-    // allocate new backend
-    if (backend_type == core::backend_t::internal) {
+    // allocate new backend, avx runs the kernels on the 8-bit gemm
+    if (backend_type == core::backend_t::internal ||
+        backend_type == core::backend_t::avx) {
       backend = std::make_shared<core::tiny_backend>(&params_);
     } else {
       throw nn_error("Not supported backend type.");
@@ -0,0 +1,83 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "tiny_dnn/core/kernels/tiny_quantization_kernel.h"
+#include "tiny_dnn/layers/layer.h"
+#include "tiny_dnn/util/util.h"
+
+namespace tiny_dnn {
+
+/**
+ * relu on 8-bit codes of a static range: the codes below the code of 0.0
+ * are clamped to it, everything else is passed through untouched.
+ **/
+class quantized_relu_layer : public layer {
+ public:
+  /**
+   * @param in_shape [in] shape of input tensor
+   * @param range    [in] float range of the incoming codes
+   */
+  quantized_relu_layer(const shape3d &in_shape,
+                       const core::quantization_range &range)
+    : layer({vector_type::data}, {vector_type::data}),
+      in_shape_(in_shape),
+      range_(range),
+      zero_(core::kernels::quantized_zero(range)) {
+    if (!range_.is_static()) throw nn_error("quantized_relu needs a range");
+  }
+
+  std::string layer_type() const override { return "q_relu"; }
+
+  std::vector<shape3d> in_shape() const override { return {in_shape_}; }
+
+  std::vector<shape3d> out_shape() const override { return {in_shape_}; }
+
+  const core::quantization_range &range() const { return range_; }
+
+  void forward_propagation(const std::vector<tensor_t *> &in_data,
+                           std::vector<tensor_t *> &out_data) override {
+    const tensor_t &x = *in_data[0];
+    tensor_t &y       = *out_data[0];
+
+    for_i(x.size(), [&](size_t i) {
+      for (size_t j = 0; j < x[i].size(); j++) {
+        y[i][j] = std::max(x[i][j], zero_);
+      }
+    });
+  }
+
+  void back_propagation(const std::vector<tensor_t *> &in_data,
+                        const std::vector<tensor_t *> &out_data,
+                        std::vector<tensor_t *> &out_grad,
+                        std::vector<tensor_t *> &in_grad) override {
+    const tensor_t &x  = *in_data[0];
+    const tensor_t &dy = *out_grad[0];
+    tensor_t &dx       = *in_grad[0];
+    CNN_UNREFERENCED_PARAMETER(out_data);
+
+    for_i(x.size(), [&](size_t i) {
+      for (size_t j = 0; j < x[i].size(); j++) {
+        dx[i][j] = x[i][j] > zero_ ? dy[i][j] : float_t{0};
+      }
+    });
+  }
+
+  friend struct serialization_buddy;
+
+ private:
+  shape3d in_shape_;
+  core::quantization_range range_;
+  float_t zero_;
+};
+
+}  // namespace tiny_dnn
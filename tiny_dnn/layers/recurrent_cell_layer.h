@@ -139,6 +139,10 @@ class recurrent_cell_layer : public layer {
 
   std::string layer_type() const override { return "recurrent-cell"; }
 
+  std::vector<std::pair<size_t, size_t>> state_channels() const override {
+    return {{1, 1}};  // h(t-1) -> h(t)
+  }
+
   friend struct serialization_buddy;
 
  protected:
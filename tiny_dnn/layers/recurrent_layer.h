@@ -0,0 +1,183 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tiny_dnn/activations/activation_layer.h"
+#include "tiny_dnn/activations/tanh_layer.h"
+#include "tiny_dnn/core/kernels/recurrent_op_internal.h"
+#include "tiny_dnn/layers/layer.h"
+
+namespace tiny_dnn {
+
+/**
+ * RNN layer unrolled over whole sequences.
+ *
+ * Same cell as recurrent_cell_layer, but a sample is a whole sequence of
+ * seq_len steps (in_dim x seq_len, step after step) and the output the
+ * seq_len outputs y(0)..y(seq_len-1). The state starts at zero for every
+ * sequence and is carried from step to step inside the layer, so a batch of
+ * sequences costs one forward and one backward call; the per-step
+ * activations are kept in buffers owned by the layer and reused across
+ * calls.
+ *
+ * Truncated backpropagation through time is set with set_bptt(): the state
+ * gradient is cut every bptt steps.
+ *
+ * Sequences of different lengths are padded to seq_len steps; with their
+ * lengths given by set_sequence_batch(), only the steps actually present are
+ * computed (see sequence_batch), the output of the padding being zero.
+ **/
+class recurrent_layer : public layer {
+ public:
+  inline std::vector<vector_type> recurrent_order(bool has_bias) {
+    if (has_bias) {
+      return {vector_type::data,    // input sequence
+              vector_type::weight,  // input weights (U)
+              vector_type::weight,  // transition weights (W)
+              vector_type::weight,  // output weights (V)
+              vector_type::bias,    // transition bias
+              vector_type::bias};   // output bias
+    } else {
+      return {vector_type::data,     // input sequence
+              vector_type::weight,   // input weights (U)
+              vector_type::weight,   // transition weights (W)
+              vector_type::weight};  // output weights (V)
+    }
+  }
+
+  /**
+   * @param in_dim [in] number of elements of the input of a step
+   * @param out_dim [in] number of elements of the output of a step
+   * @param seq_len [in] number of steps of a sequence
+   * @param has_bias [in] whether to include additional bias to the layer
+   * @param activation [in] activation function to be used internally
+   **/
+  recurrent_layer(size_t in_dim,
+                  size_t out_dim,
+                  size_t seq_len,
+                  bool has_bias                = true,
+                  activation_layer *activation = new tanh_layer)
+    : layer(recurrent_order(has_bias), {vector_type::data}) {
+    if (seq_len == 0) throw nn_error("recurrent_layer needs seq_len > 0");
+    params_.in_size_    = in_dim;
+    params_.out_size_   = out_dim;
+    params_.seq_len_    = seq_len;
+    params_.has_bias_   = has_bias;
+    params_.activation_ = std::shared_ptr<activation_layer>(activation);
+  }
+
+  size_t fan_in_size(size_t i) const override { return in_shape()[i].width_; }
+
+  size_t fan_out_size(size_t i) const override { return in_shape()[i].height_; }
+
+  std::vector<index3d<size_t>> in_shape() const override {
+    std::vector<index3d<size_t>> shapes = {
+      index3d<size_t>(params_.in_size_, params_.seq_len_, 1),    // x
+      index3d<size_t>(params_.in_size_, params_.out_size_, 1),   // U
+      index3d<size_t>(params_.out_size_, params_.out_size_, 1),  // W
+      index3d<size_t>(params_.out_size_, params_.out_size_, 1)};  // V
+    if (params_.has_bias_) {
+      shapes.push_back(index3d<size_t>(params_.out_size_, 1, 1));  // b
+      shapes.push_back(index3d<size_t>(params_.out_size_, 1, 1));  // c
+    }
+    return shapes;
+  }
+
+  std::vector<index3d<size_t>> out_shape() const override {
+    return {index3d<size_t>(params_.out_size_, params_.seq_len_, 1)};
+  }
+
+  std::string layer_type() const override { return "recurrent"; }
+
+  /**
+   * truncated backpropagation through time: the state gradient is
+   * propagated at most bptt steps back, 0 (the default) for the whole
+   * sequence
+   **/
+  void set_bptt(size_t bptt) { params_.bptt_ = bptt; }
+
+  size_t bptt() const { return params_.bptt_; }
+
+  size_t seq_len() const { return params_.seq_len_; }
+
+  void set_activation(std::shared_ptr<activation_layer> activation) {
+    params_.activation_ = activation;
+  }
+
+  void set_sequence_batch(const sequence_batch &seq) override {
+    lengths_ = seq;
+  }
+
+  void forward_propagation(const std::vector<tensor_t *> &in_data,
+                           std::vector<tensor_t *> &out_data) override {
+    const size_t batch = in_data[0]->size();
+    const vec_t empty;
+
+    seq_ = lengths_.empty() ? sequence_batch::full(batch, params_.seq_len_)
+                            : lengths_;
+    if (seq_.batch_size() != batch || seq_.steps() != params_.seq_len_) {
+      throw nn_error("sequence lengths don't match the batch");
+    }
+
+    resize_buffer(&pre_, seq_.packed_size());
+    resize_buffer(&h_, batch + seq_.packed_size());
+    fill_tensor(*out_data[0], float_t{0});
+
+    kernels::recurrent_op_internal(
+      *in_data[0], (*in_data[1])[0], (*in_data[2])[0], (*in_data[3])[0],
+      params_.has_bias_ ? (*in_data[4])[0] : empty,
+      params_.has_bias_ ? (*in_data[5])[0] : empty, *out_data[0], pre_, h_,
+      seq_, params_, layer::parallelize());
+  }
+
+  void back_propagation(const std::vector<tensor_t *> &in_data,
+                        const std::vector<tensor_t *> &out_data,
+                        std::vector<tensor_t *> &out_grad,
+                        std::vector<tensor_t *> &in_grad) override {
+    CNN_UNREFERENCED_PARAMETER(out_data);
+    tensor_t dummy;  // need lvalue for non-const reference
+
+    resize_buffer(&dh_, seq_.packed_size());
+    fill_tensor(*in_grad[0], float_t{0});
+
+    kernels::recurrent_op_internal(
+      *in_data[0], (*in_data[1])[0], (*in_data[2])[0], (*in_data[3])[0],
+      *in_grad[1], *in_grad[2], *in_grad[3],
+      params_.has_bias_ ? *in_grad[4] : dummy,
+      params_.has_bias_ ? *in_grad[5] : dummy, *out_grad[0], *in_grad[0], pre_,
+      h_, dh_, seq_, params_, layer::parallelize());
+  }
+
+  friend struct serialization_buddy;
+
+ private:
+  // rows of out_size_ zeros, grown as needed and reused across calls
+  void resize_buffer(tensor_t *buf, size_t rows) {
+    if (buf->size() < rows) buf->resize(rows, vec_t(params_.out_size_));
+    for (size_t r = 0; r < rows; r++) {
+      vectorize::fill(&(*buf)[r][0], params_.out_size_, float_t{0});
+    }
+  }
+
+  core::recurrent_params params_;
+
+  // lengths set for the next batches, and those of the last forward pass
+  sequence_batch lengths_;
+  sequence_batch seq_;
+
+  // pre-activations, states (h(-1) first) and state gradients of all steps
+  tensor_t pre_;
+  tensor_t h_;
+  tensor_t dh_;
+};
+
+}  // namespace tiny_dnn
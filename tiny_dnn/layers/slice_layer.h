@@ -108,6 +108,33 @@ class slice_layer : public layer {
     }
   }
 
+  /**
+   * the outputs become views of their parts of the input (samples or
+   * channels), so that slicing copies nothing; an output whose data are
+   * already held elsewhere is still copied
+   **/
+  void share_storage() override {
+    edge *in        = inputs()[0].get();
+    const auto outs = outputs();
+    if (slice_type_ == slice_type::slice_samples) {
+      set_sample_slices(in->get_data()->size());
+    }
+
+    const size_t spatial_dim = in_shape_.area();
+    size_t first             = 0;
+    for (size_t i = 0; i < num_outputs_; i++) {
+      edge &out = *outs[i];
+      if (!out.is_shared() || out.is_view_of(in)) {
+        if (slice_type_ == slice_type::slice_samples) {
+          out.view_samples(in, first, slice_size_[i]);
+        } else {
+          out.view_features(in, first * spatial_dim, false);
+        }
+      }
+      first += slice_size_[i];
+    }
+  }
+
   slice_type get_slice_type() const { return slice_type_; }
 
   friend struct serialization_buddy;
@@ -120,7 +147,9 @@ class slice_layer : public layer {
     for (size_t i = 0; i < num_outputs_; i++) {
       tensor_t &out = *out_data[i];
 
-      std::copy(in, in + slice_size_[i], &out[0]);
+      if (!out.empty() && out[0].data() != in->data()) {
+        std::copy(in, in + slice_size_[i], &out[0]);
+      }
 
       in += slice_size_[i];
     }
@@ -133,7 +162,9 @@ class slice_layer : public layer {
     for (size_t i = 0; i < num_outputs_; i++) {
       tensor_t &out = *out_grad[i];
 
-      std::copy(&out[0], &out[0] + slice_size_[i], in);
+      if (!out.empty() && out[0].data() != in->data()) {
+        std::copy(&out[0], &out[0] + slice_size_[i], in);
+      }
 
       in += slice_size_[i];
     }
@@ -150,7 +181,7 @@ class slice_layer : public layer {
         float_t *out      = &(*out_data[i])[s][0];
         const float_t *in = &in_data[s][0] + channel_idx * spatial_dim;
 
-        std::copy(in, in + slice_size_[i] * spatial_dim, out);
+        if (in != out) std::copy(in, in + slice_size_[i] * spatial_dim, out);
       }
       channel_idx += slice_size_[i];
     }
@@ -167,23 +198,20 @@ class slice_layer : public layer {
         const float_t *out = &(*out_grad[i])[s][0];
         float_t *in        = &in_grad[s][0] + channel_idx * spatial_dim;
 
-        std::copy(out, out + slice_size_[i] * spatial_dim, in);
+        if (in != out) std::copy(out, out + slice_size_[i] * spatial_dim, in);
       }
       channel_idx += slice_size_[i];
     }
   }
 
-  void set_sample_count(size_t sample_count) override {
-    if (slice_type_ == slice_type::slice_samples) {
-      if (num_outputs_ == 0)
-        throw nn_error("num_outputs must be positive integer");
+  void set_sample_slices(size_t sample_count) {
+    if (num_outputs_ == 0)
+      throw nn_error("num_outputs must be positive integer");
 
-      size_t sample_per_out = sample_count / num_outputs_;
+    size_t sample_per_out = sample_count / num_outputs_;
 
-      slice_size_.resize(num_outputs_, sample_per_out);
-      slice_size_.back() = sample_count - (sample_per_out * (num_outputs_ - 1));
-    }
-    Base::set_sample_count(sample_count);
+    slice_size_.assign(num_outputs_, sample_per_out);
+    slice_size_.back() = sample_count - (sample_per_out * (num_outputs_ - 1));
   }
 
   void set_shape() {
@@ -9,6 +9,7 @@
 
 #include <vector>
 
+#include "tiny_dnn/util/sequence_batch.h"
 #include "tiny_dnn/util/util.h"
 
 namespace tiny_dnn {
@@ -217,4 +218,36 @@ std::vector<tensor_t> gradient(const std::vector<tensor_t> &y,
   return gradients;
 }
 
+// gradient for a minibatch of padded sequences: every output is seq.steps()
+// steps laid one after the other, and only the steps actually present in a
+// sample contribute to the loss, the gradient of the padding being zero
+template <typename E>
+std::vector<tensor_t> gradient(const std::vector<tensor_t> &y,
+                               const std::vector<tensor_t> &t,
+                               const sequence_batch &seq) {
+  const size_t sample_count = y.size();
+
+  std::vector<tensor_t> gradients(sample_count);
+
+  assert(y.size() == t.size());
+  assert(seq.batch_size() == sample_count);
+
+  for (size_t sample = 0; sample < sample_count; ++sample) {
+    gradients[sample].resize(y[sample].size());
+    for (size_t channel = 0; channel < y[sample].size(); ++channel) {
+      const row_t &ys     = y[sample][channel];
+      const row_t &ts     = t[sample][channel];
+      const size_t valid  = ys.size() / seq.steps() * seq.lengths()[sample];
+      row_t &g            = gradients[sample][channel];
+      const vec_t present = E::df(vec_t(ys.begin(), ys.begin() + valid),
+                                  vec_t(ts.begin(), ts.begin() + valid));
+
+      g.assign(ys.size(), float_t{0});
+      std::copy(present.begin(), present.end(), g.begin());
+    }
+  }
+
+  return gradients;
+}
+
 }  // namespace tiny_dnn
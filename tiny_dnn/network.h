@@ -25,6 +25,7 @@
 
 #include "tiny_dnn/lossfunctions/loss_function.h"
 #include "tiny_dnn/nodes.h"
+#include "tiny_dnn/util/stream_state.h"
 #include "tiny_dnn/util/util.h"
 
 namespace tiny_dnn {
@@ -181,6 +182,19 @@ class network {
     return fprop(in);
   }
 
+  /**
+   * executes forward-propagation of a batch of samples, reading them from
+   * and writing the outputs to buffers of the caller, without copies (see
+   * nodes::forward_batch)
+   *
+   * @param in    batch * in_data_size() values
+   * @param batch number of samples
+   * @param out   room for batch * out_data_size() values
+   **/
+  void predict(const float_t *in, size_t batch, float_t *out) {
+    net_.forward_batch(in, batch, out);
+  }
+
   /**
    * executes forward-propagation and returns maximum output
    **/
@@ -204,6 +218,27 @@ class network {
     return predict(vec_t(begin(in), end(in)));
   }
 
+  /**
+   * an inference session of the network: a network of the same architecture
+   * whose layers read the weights of this one instead of holding a copy,
+   * with activations of its own. Sessions of a network can predict at the
+   * same time, one per thread, over a single set of weights; the weights
+   * must not change meanwhile (e.g. by training this network), and the
+   * sessions themselves are not trained.
+   **/
+  network session() {
+    net_.setup(false);
+    network s(name_);
+    s.from_json(to_json(content_type::model), content_type::model);
+    s.net_.share_weights(net_);
+    // the engines aren't part of the model
+    for (size_t i = 0; i < depth(); i++) {
+      s[i]->set_backend_type((*this)[i]->engine());
+    }
+    s.set_netphase(net_phase::test);
+    return s;
+  }
+
   /**
    * trains the network for a fixed number of epochs (for classification task)
    *
@@ -384,15 +419,219 @@ class network {
   }
 
   /**
-   * set the netphase to train or test
+   * trains the network on sequences of different lengths padded to the same
+   * number of steps (e.g. on a recurrent_layer): the padding is neither
+   * computed by the layers supporting it nor counted in the loss
+   *
+   * @param optimizer          optimizing algorithm for training
+   * @param inputs             array of padded input sequences
+   * @param desired_outputs    array of padded desired output sequences
+   * @param lengths            number of steps actually present in each
+   * sequence
+   * @param steps              number of steps the sequences are padded to
+   * @param batch_size         number of samples per parameter update
+   * @param epoch              number of training epochs
+   **/
+  template <typename Error, typename Optimizer>
+  bool fit_sequences(Optimizer &optimizer,
+                     const std::vector<vec_t> &inputs,
+                     const std::vector<vec_t> &desired_outputs,
+                     const std::vector<size_t> &lengths,
+                     size_t steps,
+                     size_t batch_size = 1,
+                     int epoch         = 1) {
+    if (inputs.size() != lengths.size() ||
+        desired_outputs.size() != lengths.size()) {
+      throw nn_error("number of sequences and lengths mismatch");
+    }
+    set_netphase(net_phase::train);
+    net_.setup(false);
+
+    for (auto n : net_) n->set_parallelize(true);
+    optimizer.reset();
+    stop_training_ = false;
+    for (int iter = 0; iter < epoch && !stop_training_; iter++) {
+      for (size_t i = 0; i < inputs.size() && !stop_training_;
+           i += batch_size) {
+        const size_t n = std::min(batch_size, inputs.size() - i);
+        const sequence_batch seq(
+          std::vector<size_t>(&lengths[i], &lengths[i] + n), steps);
+        std::vector<tensor_t> in(n), t(n);
+        for (size_t j = 0; j < n; j++) {
+          in[j].push_back(inputs[i + j]);
+          t[j].push_back(desired_outputs[i + j]);
+        }
+
+        set_sequence_batch(seq);
+        net_.backward(gradient<Error>(fprop(in), t, seq));
+        net_.update_weights(&optimizer, static_cast<int>(n));
+      }
+    }
+    set_sequence_batch(sequence_batch());
+    set_netphase(net_phase::test);
+    return true;
+  }
+
+  /**
+   * create the state of a new stream, fed to the network one frame at a time
+   * with step(); the state starts at zero
+   **/
+  stream_state create_stream_state() {
+    net_.setup(false);
+    std::vector<size_t> sizes;
+    for (auto n : net_) {
+      for (auto c : n->state_channels()) {
+        sizes.push_back(n->in_shape()[c.first].size());
+      }
+    }
+    return stream_state(sizes);
+  }
+
+  /**
+   * advance a stream by one frame: the recurrent layers start from the
+   * stream's state, which is then replaced by their new state
+   *
+   * @param state  state of the stream (see create_stream_state)
+   * @param frame  input of this step
+   * @return output of this step
+   **/
+  vec_t step(stream_state &state, const vec_t &frame) {
+    return step(std::vector<stream_state *>{&state},
+                std::vector<vec_t>{frame})[0];
+  }
+
+  /**
+   * advance many streams by one frame each in a single batch, their states
+   * being stacked as the rows of the state inputs of the recurrent layers
+   *
+   * @param states states of the streams
+   * @param frames input of this step of each stream
+   * @return output of this step of each stream
+   **/
+  std::vector<vec_t> step(const std::vector<stream_state *> &states,
+                          const std::vector<vec_t> &frames) {
+    if (states.size() != frames.size()) {
+      throw nn_error("number of streams and frames mismatch");
+    }
+    const size_t batch = frames.size();
+
+    // the states must have been created by create_stream_state()
+    size_t channels = 0;
+    for (auto n : net_) channels += n->state_channels().size();
+    for (auto state : states) {
+      if (state->size() != channels) {
+        throw nn_error("number of stream states and state channels mismatch");
+      }
+    }
+
+    size_t k = 0;
+    for (auto n : net_) {
+      for (auto c : n->state_channels()) {
+        const size_t size = n->in_shape()[c.first].size();
+        tensor_t &h       = *n->inputs()[c.first]->get_data();
+        h.resize(batch);
+        for (size_t s = 0; s < batch; s++) {
+          if ((*states[s])[k].size() != size) {
+            throw nn_error("stream state size mismatch");
+          }
+          h[s] = (*states[s])[k];
+        }
+        k++;
+      }
+    }
+
+    std::vector<tensor_t> in(batch);
+    for (size_t s = 0; s < batch; s++) in[s].push_back(frames[s]);
+    const std::vector<tensor_t> out = net_.forward(in);
+
+    k = 0;
+    for (auto n : net_) {
+      for (auto c : n->state_channels()) {
+        const tensor_t &h = *n->outputs()[c.second]->get_data();
+        for (size_t s = 0; s < batch; s++) (*states[s])[k] = h[s];
+        k++;
+      }
+    }
+
+    std::vector<vec_t> y(batch);
+    for (size_t s = 0; s < batch; s++) y[s] = out[s][0];
+    return y;
+  }
+
+  /**
+   * set the lengths of the padded sequences of the next batches, an empty
+   * sequence_batch for sequences without padding
+   */
+  void set_sequence_batch(const sequence_batch &seq) {
+    for (auto n : net_) {
+      n->set_sequence_batch(seq);
+    }
+  }
+
+  /**
+   * set the netphase to train or test; in the test phase, the gradients of
+   * the activations are neither allocated nor cleared
    * @param phase phase of network, could be train or test
    */
   void set_netphase(net_phase phase) {
+    if (phase == net_phase::train) net_.release_memory_plan();
     for (auto n : net_) {
       n->set_context(phase);
     }
+    net_.set_gradient_enabled(phase == net_phase::train);
   }
 
+  /**
+   * switch to the test phase and let the activations share a few buffers,
+   * each being reused once the last layer reading it has run; the outputs
+   * of the inner layers are then overwritten by later ones. Setting the
+   * train phase gives them their own buffers again.
+   *
+   * @return bytes per sample of the activations, naive and planned
+   **/
+  memory_plan plan_memory() {
+    set_netphase(net_phase::test);
+    return net_.plan_memory();
+  }
+
+  /**
+   * bound the activations kept for training: only the outputs of the given
+   * layers (indices in the order of the forward pass) are kept after the
+   * forward pass, the others being computed again, one segment between two
+   * checkpoints at a time, by the backward pass. An empty list (the default)
+   * keeps them all.
+   **/
+  void set_checkpoints(const std::vector<size_t> &layers) {
+    net_.set_checkpoints(layers);
+  }
+
+  /**
+   * a checkpoint every sqrt(depth) layers, which keeps about 2 sqrt(depth)
+   * activations at any time for one more forward pass
+   *
+   * @return indices of the checkpointed layers
+   **/
+  std::vector<size_t> set_checkpoints_sqrt() {
+    return net_.set_checkpoints_sqrt();
+  }
+
+  /**
+   * run the independent branches of the network (e.g. the towers of an
+   * inception module) at the same time, in the forward and backward passes
+   * (see nodes::set_parallel_branches)
+   **/
+  void set_parallel_branches(bool parallel) {
+    net_.set_parallel_branches(parallel);
+  }
+
+  bool parallel_branches() const { return net_.parallel_branches(); }
+
+  /**
+   * heap allocations made by the layers during the last forward pass, e.g.
+   * to check that inference in a steady state allocates nothing
+   **/
+  size_t forward_allocations() const { return net_.forward_allocations(); }
+
   /**
    * request to finish an ongoing training
    *
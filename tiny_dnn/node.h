@@ -84,6 +84,14 @@ class edge {
       vtype_(vtype),
       data_({vec_t(shape.size())}),
       grad_({vec_t(shape.size())}),
+      alias_(nullptr),
+      view_parent_(nullptr),
+      view_offset_(0),
+      view_first_(0),
+      view_count_(0),
+      view_all_(false),
+      external_(nullptr),
+      grad_enabled_(true),
       prev_(prev) {}
 
   void merge_grads(vec_t *dst) {
@@ -103,20 +111,219 @@ class edge {
   }
 
   void clear_grads() {
-    for (size_t sample = 0, sample_count = grad_.size(); sample < sample_count;
-         ++sample) {
-      auto &g = grad_[sample];
-      vectorize::fill(&g[0], g.size(), float_t{0});
+    if (grad_enabled_) {
+      fill_tensor(*get_gradient(), float_t{0});
+    } else {
+      // dropped, so that a gradient asked for later starts from zero
+      release_gradient();
+    }
+  }
+
+  /**
+   * whether the gradient of the data is kept; when it isn't (inference, see
+   * network::set_netphase), resizing and clearing the edge leave it out and
+   * it only takes memory if get_gradient() is called anyway. The gradient
+   * of weights is always kept.
+   **/
+  void set_gradient_enabled(bool enabled) {
+    if (is_trainable_weight(vtype_)) return;
+    grad_enabled_ = enabled;
+    if (!enabled) release_gradient();
+  }
+
+  bool gradient_enabled() const { return grad_enabled_; }
+
+  tensor_t *get_data() {
+    if (alias_) return alias_->get_data();
+    if (external_) return &data_;
+    if (view_parent_) {
+      sync_view(grad_enabled_);
+    } else if (!is_trainable_weight(vtype_)) {
+      pack(&data_block_, &data_, data_.size());
     }
+    return &data_;
   }
 
-  tensor_t *get_data() { return &data_; }
+  const tensor_t *get_data() const {
+    return const_cast<edge *>(this)->get_data();
+  }
 
-  const tensor_t *get_data() const { return &data_; }
+  /**
+   * share the data of another edge instead of holding a copy, e.g. the
+   * output of a layer passing its input through; nullptr to go back to the
+   * edge's own data
+   **/
+  void alias_data(edge *src) { alias_ = src; }
+
+  edge *alias() const { return alias_; }
+
+  /**
+   * make every sample of the data and gradient a view of the elements
+   * [offset, offset + shape().size()) of the same sample of another edge,
+   * e.g. an input of a concatenation being part of its output, so that
+   * neither has to be copied; with keep_data, the current data are first
+   * moved into the parent
+   **/
+  void view_features(edge *parent, size_t offset, bool keep_data) {
+    if (view_parent_ == parent && view_all_ && view_offset_ == offset) return;
+    tensor_t current;
+    if (keep_data) current = *get_data();
+
+    view_parent_ = parent;
+    view_offset_ = offset;
+    view_first_  = 0;
+    view_count_  = 0;
+    view_all_    = true;
+    data_.clear();
+    grad_.clear();
+    vec_t().swap(data_block_);
+    vec_t().swap(grad_block_);
+
+    if (!current.empty()) {
+      set_sample_count(current.size(), true);
+      tensor_t &data = *get_data();
+      for (size_t sample = 0; sample < current.size(); sample++) {
+        if (current[sample].size() != shape_.size()) continue;
+        std::copy(current[sample].begin(), current[sample].end(),
+                  data[sample].begin());
+      }
+    }
+  }
 
-  tensor_t *get_gradient() { return &grad_; }
+  /**
+   * make the data and gradient views of the samples [first, first + count)
+   * of another edge, e.g. a part of a batch being sliced
+   **/
+  void view_samples(edge *parent, size_t first, size_t count) {
+    if (view_parent_ == parent && !view_all_ && view_first_ == first &&
+        view_count_ == count) {
+      return;
+    }
+    view_parent_ = parent;
+    view_offset_ = 0;
+    view_first_  = first;
+    view_count_  = count;
+    view_all_    = false;
+    data_.clear();
+    grad_.clear();
+    vec_t().swap(data_block_);
+    vec_t().swap(grad_block_);
+  }
 
-  const tensor_t *get_gradient() const { return &grad_; }
+  /**
+   * make the samples of the data views of count * shape().size() elements
+   * owned by the caller, one sample after another, e.g. the input or output
+   * of nodes::forward_batch; they are read and written in place until
+   * unbind_data(), or until the edge is resized to another sample count
+   **/
+  void bind_data(float_t *data, size_t count) {
+    assert(!is_shared() && !is_trainable_weight(vtype_));
+    external_         = data;
+    const size_t size = shape_.size();
+    bool same         = data_.size() == count;
+    for (size_t sample = 0; same && sample < count; sample++) {
+      same = data_[sample].data() == data + sample * size;
+    }
+    if (same) return;
+
+    data_.clear();
+    data_.reserve(count);
+    for (size_t sample = 0; sample < count; sample++) {
+      float_t *row = data + sample * size;
+      data_.emplace_back(size, row_t::allocator_type(row, size));
+    }
+  }
+
+  /**
+   * forget the elements given to bind_data(), without reading them again;
+   * the edge goes back to its own data, whose values are not kept
+   **/
+  void unbind_data() {
+    if (!external_) return;
+    external_ = nullptr;
+    data_.clear();
+  }
+
+  // whether the data of this edge are a view of the given edge, in any way
+  bool is_view_of(const edge *parent) const { return view_parent_ == parent; }
+
+  // whether the data are held by another edge (alias or view)
+  bool is_shared() const { return alias_ || view_parent_; }
+
+  // the edge actually holding the data of this one
+  edge *storage() {
+    if (alias_) return alias_->storage();
+    return view_parent_ ? view_parent_->storage() : this;
+  }
+
+  /**
+   * give a view its own data and gradient again, with the values they have
+   * in the parent
+   **/
+  void detach_view() {
+    if (!view_parent_) return;
+    // copies of the rows of a view own their elements
+    tensor_t data = *get_data(), grad;
+    if (grad_enabled_) grad = *get_gradient();
+    view_parent_ = nullptr;
+    data_.clear();
+    grad_.clear();
+    data_.swap(data);
+    grad_.swap(grad);
+  }
+
+  /**
+   * resize the gradient (and the data) for the given number of samples; a
+   * view resizes its parent instead, unless it is a view of given samples
+   **/
+  void set_sample_count(size_t sample_count, bool data) {
+    auto resize = [sample_count](tensor_t *tensor) {
+      tensor->resize(sample_count, (*tensor)[0]);
+    };
+
+    if (view_parent_) {
+      if (view_all_) view_parent_->set_sample_count(sample_count, true);
+      return;
+    }
+    if (is_trainable_weight(vtype_)) {
+      if (data) resize(get_data());
+      resize(&grad_);
+      return;
+    }
+    if (data && external_ && sample_count != data_.size()) unbind_data();
+    if (data && alias_) {
+      alias_->set_sample_count(sample_count, true);
+    } else if (data && !external_) {
+      pack(&data_block_, &data_, sample_count);
+    }
+    if (grad_enabled_) pack(&grad_block_, &grad_, sample_count);
+  }
+
+  tensor_t *get_gradient() {
+    if (view_parent_) {
+      sync_view(true);
+    } else if (!is_trainable_weight(vtype_)) {
+      // a disabled gradient is allocated on demand, for the current batch
+      pack(&grad_block_, &grad_,
+           grad_enabled_ ? grad_.size() : get_data()->size());
+    }
+    return &grad_;
+  }
+
+  const tensor_t *get_gradient() const {
+    return const_cast<edge *>(this)->get_gradient();
+  }
+
+  /**
+   * free the data held by the edge, e.g. an activation computed again when
+   * the backward pass needs it (see nodes::set_checkpoints); the next
+   * resize allocates them again
+   **/
+  void release_data() {
+    if (is_trainable_weight(vtype_) || is_shared() || external_) return;
+    data_.clear();
+    vec_t().swap(data_block_);
+  }
 
   const std::vector<node *> &next() const { return next_; }
   node *prev() { return prev_; }
@@ -127,10 +334,99 @@ class edge {
   void add_next_node(node *next) { next_.push_back(next); }
 
  private:
+  /**
+   * keep the samples of the data (or gradient) in one NCHW block, the rows
+   * being views of their part of it (see contiguous_data); the block is
+   * only reallocated when it grows, and rows replaced from outside are
+   * moved back into it
+   **/
+  void pack(vec_t *block, tensor_t *rows, size_t count) {
+    const size_t size = shape_.size();
+    const size_t kept = std::min(rows->size(), count);
+    bool in_place     = block->size() >= count * size;
+    for (size_t sample = 0; in_place && sample < kept; sample++) {
+      in_place = (*rows)[sample].size() == size &&
+                 (*rows)[sample].data() == block->data() + sample * size;
+    }
+    if (in_place && kept == rows->size() && kept == count) return;
+
+    // new samples start as copies of the first one, as with resize()
+    if (in_place) {
+      rows->erase(rows->begin() + kept, rows->end());
+      for (size_t sample = kept; sample < count && kept > 0; sample++) {
+        std::copy(block->begin(), block->begin() + size,
+                  block->begin() + sample * size);
+      }
+    } else {
+      vec_t next(std::max(block->size(), count * size));
+      for (size_t sample = 0; sample < count && !rows->empty(); sample++) {
+        const row_t &src = (*rows)[sample < rows->size() ? sample : 0];
+        std::copy(src.begin(), src.begin() + std::min(src.size(), size),
+                  next.begin() + sample * size);
+      }
+      block->swap(next);
+      rows->clear();
+    }
+
+    rows->reserve(count);
+    for (size_t sample = rows->size(); sample < count; sample++) {
+      float_t *row = block->data() + sample * size;
+      rows->emplace_back(size, row_t::allocator_type(row, size));
+    }
+  }
+
+  void release_gradient() {
+    grad_.clear();
+    vec_t().swap(grad_block_);
+  }
+
+  // rebuild the rows of the view whenever those of the parent have moved
+  void sync_view(bool grads) {
+    const size_t count = view_first_ + view_count_;
+    if (!view_all_ &&
+        (view_parent_->get_data()->size() < count ||
+         (grads && view_parent_->get_gradient()->size() < count))) {
+      view_parent_->set_sample_count(
+        std::max(count, view_parent_->get_data()->size()), true);
+    }
+    sync_rows(view_parent_->get_data(), &data_);
+    if (grads) sync_rows(view_parent_->get_gradient(), &grad_);
+  }
+
+  void sync_rows(tensor_t *src, tensor_t *rows) const {
+    const size_t count = view_all_ ? src->size() : view_count_;
+
+    auto row = [&](size_t sample) {
+      return &(*src)[view_first_ + sample][view_offset_];
+    };
+    bool same = rows->size() == count;
+    for (size_t sample = 0; same && sample < count; sample++) {
+      same = (*rows)[sample].data() == row(sample);
+    }
+    if (same) return;
+
+    rows->clear();
+    rows->reserve(count);
+    for (size_t sample = 0; sample < count; sample++) {
+      rows->emplace_back(shape_.size(),
+                         row_t::allocator_type(row(sample), shape_.size()));
+    }
+  }
+
   shape3d shape_;
   vector_type vtype_;
   tensor_t data_;
   tensor_t grad_;
+  vec_t data_block_;          // samples of data_, unless weight or view
+  vec_t grad_block_;          // samples of grad_, unless weight or view
+  edge *alias_;               // edge whose data this one shares, if any
+  edge *view_parent_;         // edge this one is a view of, if any
+  size_t view_offset_;        // first element of the view in a sample
+  size_t view_first_;         // first sample of the view
+  size_t view_count_;         // number of samples of the view
+  bool view_all_;             // whether the view spans every sample
+  float_t *external_;         // elements given to bind_data(), if any
+  bool grad_enabled_;         // whether the gradient is kept
   node *prev_;                // previous node, "producer" of this tensor
   std::vector<node *> next_;  // next nodes, "consumers" of this tensor
 };
@@ -7,9 +7,17 @@
 */
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -20,6 +28,7 @@
 
 #include "tiny_dnn/layers/layer.h"
 #include "tiny_dnn/optimizers/optimizer.h"
+#include "tiny_dnn/util/memory_planner.h"
 #include "tiny_dnn/util/util.h"
 
 namespace cereal {
@@ -97,6 +106,59 @@ class nodes {
   virtual std::vector<tensor_t> forward(
     const std::vector<tensor_t> &first) = 0;  // NOLINT
 
+  /**
+   * forward pass of a single-input, single-output network over a batch of
+   * samples owned by the caller, without copying them: the input and
+   * output edges of the network are views of the two buffers during the
+   * call, so that the first layer reads the samples where they are and the
+   * last one writes its result in place. Once the layers have their
+   * buffers for the batch size, nothing is allocated either.
+   *
+   * @param in    batch samples of in_data_size() elements, one after
+   *              another; not written
+   * @param batch number of samples
+   * @param out   batch samples of out_data_size() elements, one after
+   *              another
+   **/
+  void forward_batch(const float_t *in, size_t batch, float_t *out) {
+    if (batch == 0) return;
+    edge *src = input_layer()->data_input();
+    edge *dst = output_layer()->data_output();
+    // the edges let go of the caller's buffers however the call ends
+    struct unbind_guard {
+      edge *src, *dst;
+      ~unbind_guard() {
+        src->unbind_data();
+        dst->unbind_data();
+      }
+    } guard{src, dst};
+
+    if (src->is_shared()) {
+      src->set_sample_count(batch, true);
+      const size_t size = src->shape().size();
+      tensor_t &data    = *src->get_data();
+      for (size_t sample = 0; sample < batch; sample++) {
+        std::copy(in + sample * size, in + (sample + 1) * size,
+                  data[sample].begin());
+      }
+    } else {
+      src->bind_data(const_cast<float_t *>(in), batch);
+    }
+    if (!dst->is_shared()) dst->bind_data(out, batch);
+
+    forward_layers();
+
+    // an output passed through or computed in place is in another edge
+    const tensor_t &result = *dst->get_data();
+    const size_t size      = dst->shape().size();
+    if (result[0].data() != out) {
+      for (size_t sample = 0; sample < batch; sample++) {
+        std::copy(result[sample].begin(), result[sample].end(),
+                  out + sample * size);
+      }
+    }
+  }
+
   /**
    * update weights and clear all gradients
    **/
@@ -121,6 +183,103 @@ class nodes {
     }
   }
 
+  /**
+   * keep or drop the gradients of the activations (see
+   * edge::set_gradient_enabled), which inference doesn't need
+   **/
+  void set_gradient_enabled(bool enabled) {
+    gradient_enabled_ = enabled;
+    for (auto l : nodes_) {
+      for (auto &e : l->inputs()) e->set_gradient_enabled(enabled);
+      for (auto &e : l->outputs()) e->set_gradient_enabled(enabled);
+    }
+  }
+
+  /**
+   * let the activations share a few buffers for inference (see
+   * memory_planner), until release_memory_plan()
+   **/
+  memory_plan plan_memory() {
+    setup(false);
+    return planner_.plan(nodes_);
+  }
+
+  void release_memory_plan() { planner_.release(); }
+
+  /**
+   * let every layer read the weights of the layer at the same position in
+   * a network of the same architecture (see layer::share_weights)
+   **/
+  void share_weights(nodes &src) {
+    if (src.nodes_.size() != nodes_.size()) {
+      throw nn_error("networks of different architectures");
+    }
+    for (size_t i = 0; i < nodes_.size(); i++) {
+      nodes_[i]->share_weights(*src.nodes_[i]);
+    }
+  }
+
+  /**
+   * in training, keep only the outputs of the given layers (positions in
+   * the order of the forward pass) once the forward pass is over: the
+   * activations of the layers between two checkpoints are freed as soon as
+   * their segment has run, and computed again from the previous checkpoint
+   * when backward() reaches the segment. This costs about one more forward
+   * pass for the activations of all segments but one. Layers whose outputs
+   * are read by a later segment, or which can't be run twice (see
+   * layer::is_recomputable), keep them too. No checkpoint (the default)
+   * keeps every activation.
+   **/
+  void set_checkpoints(const std::vector<size_t> &positions) {
+    for (auto p : positions) {
+      if (p >= nodes_.size()) throw nn_error("checkpoint out of range");
+    }
+    checkpoints_ = positions;
+    std::sort(checkpoints_.begin(), checkpoints_.end());
+    checkpoints_.erase(std::unique(checkpoints_.begin(), checkpoints_.end()),
+                       checkpoints_.end());
+    kept_.clear();
+  }
+
+  /**
+   * a checkpoint every sqrt(N) layers of the N, so that about 2 sqrt(N)
+   * activations are kept at any time; returns their positions
+   **/
+  std::vector<size_t> set_checkpoints_sqrt() {
+    const size_t n    = nodes_.size();
+    const size_t step = std::max(
+      size_t(1), static_cast<size_t>(std::lround(std::sqrt(double(n)))));
+    std::vector<size_t> positions;
+    for (size_t p = step - 1; p + 1 < n; p += step) positions.push_back(p);
+    set_checkpoints(positions);
+    return positions;
+  }
+
+  const std::vector<size_t> &checkpoints() const { return checkpoints_; }
+
+  /**
+   * run the layers which don't depend on one another, e.g. the branches of
+   * an inception module, at the same time: the forward and backward passes
+   * follow the dependencies between the layers (their edges) instead of the
+   * order of nodes_, a layer starting on a thread of its own as soon as
+   * those it depends on are over. In the backward pass, the layers reading
+   * the same edge still run one after another, as they write its gradient.
+   * A layer running alone keeps its own parallelism; once there are more
+   * layers running than cores, the next ones run on one thread each.
+   *
+   * The layers run in order anyway with a memory plan (see plan_memory) or
+   * checkpoints, which both rely on that order. Off by default.
+   **/
+  void set_parallel_branches(bool parallel) { parallel_branches_ = parallel; }
+
+  bool parallel_branches() const { return parallel_branches_; }
+
+  /**
+   * heap allocations made by the layers during the last forward pass (see
+   * heap_allocations), zero once the buffers for the batch size are there
+   **/
+  size_t forward_allocations() const { return forward_allocations_; }
+
   size_t size() const { return nodes_.size(); }
   iterator begin() { return nodes_.begin(); }
   iterator end() { return nodes_.end(); }
@@ -214,6 +373,11 @@ class nodes {
   }
 
  protected:
+  // the layers reading the input and writing the output of the network,
+  // when there is one of each
+  virtual layer *input_layer() const  = 0;
+  virtual layer *output_layer() const = 0;
+
   template <typename T>
   void push_back(T &&node) {
     push_back_impl(
@@ -262,10 +426,289 @@ class nodes {
     nodes_.push_back(&node);
   }
 
+  // forward pass of every layer, dropping the activations between the
+  // checkpoints in training (see set_checkpoints)
+  void forward_layers() {
+    const size_t allocations = heap_allocations();
+    kept_.clear();
+    if ((checkpoints_.empty() || !gradient_enabled_) && runs_concurrently()) {
+      for (auto l : nodes_) l->prepare_forward();
+      run_concurrently(forward_next_, forward_deps_, [this](size_t p) {
+        nodes_[p]->run_forward();
+      });
+    } else if (checkpoints_.empty() || !gradient_enabled_) {
+      for (auto l : nodes_) l->forward();
+    } else {
+      split_segments();
+      kept_.assign(nodes_.size(), false);
+      kept_storage_.clear();
+      size_t first = 0;
+      for (auto last : segment_ends_) {
+        for (size_t p = first; p <= last; p++) nodes_[p]->forward();
+        keep_outputs(first, last);
+        drop_outputs(first, last);
+        first = last + 1;
+      }
+    }
+    forward_allocations_ = heap_allocations() - allocations;
+  }
+
+  // backward pass of every layer, each checkpointed segment being run
+  // forward again first
+  void backward_layers() {
+    if (kept_.size() != nodes_.size() && runs_concurrently()) {
+      for (auto l = nodes_.rbegin(); l != nodes_.rend(); l++) {
+        (*l)->prepare_backward();
+      }
+      run_concurrently(backward_next_, backward_deps_, [this](size_t p) {
+        nodes_[p]->run_backward();
+      });
+      return;
+    }
+    if (kept_.size() != nodes_.size()) {
+      for (auto l = nodes_.rbegin(); l != nodes_.rend(); l++) {
+        (*l)->backward();
+      }
+      return;
+    }
+
+    for (size_t s = segment_ends_.size(); s-- > 0;) {
+      const size_t first = s == 0 ? 0 : segment_ends_[s - 1] + 1;
+      const size_t last  = segment_ends_[s];
+      for (size_t p = first; p <= last; p++) {
+        if (!kept_[p]) nodes_[p]->forward();
+      }
+      for (size_t p = last + 1; p-- > first;) nodes_[p]->backward();
+      drop_outputs(first, last);
+    }
+  }
+
   /* Nodes which this class has ownership */
   std::vector<std::shared_ptr<layer>> own_nodes_;
   /* List of all nodes which includes own_nodes */
   std::vector<layer *> nodes_;
+  /* Buffers shared by the activations in the test phase, if planned */
+  memory_planner planner_;
+  /* Whether the gradients of the activations are kept, i.e. training */
+  bool gradient_enabled_ = true;
+  /* Positions of the layers whose outputs are kept in training */
+  std::vector<size_t> checkpoints_;
+  /* Heap allocations of the last forward pass */
+  size_t forward_allocations_ = 0;
+  /* Whether independent layers run at the same time */
+  bool parallel_branches_ = false;
+
+ private:
+  // whether the layers are run following their dependencies, which are
+  // derived again whenever the layers have changed
+  bool runs_concurrently() {
+#ifdef CNN_SINGLE_THREAD
+    return false;
+#else
+    if (!parallel_branches_ || !planner_.empty()) return false;
+    if (scheduled_ != nodes_) build_dependencies();
+    return true;
+#endif
+  }
+
+  /**
+   * for every layer, the layers running after it in each pass and the
+   * number of those it waits for
+   **/
+  void build_dependencies() {
+    const size_t n = nodes_.size();
+    std::unordered_map<const node *, size_t> position;
+    for (size_t p = 0; p < n; p++) position[nodes_[p]] = p;
+
+    forward_next_.assign(n, std::vector<size_t>());
+    backward_next_.assign(n, std::vector<size_t>());
+    forward_deps_.assign(n, 0);
+    backward_deps_.assign(n, 0);
+    auto add = [](std::vector<std::vector<size_t>> &next,
+                  std::vector<size_t> &deps, size_t from, size_t to) {
+      auto &after = next[from];
+      if (std::find(after.begin(), after.end(), to) != after.end()) return;
+      after.push_back(to);
+      deps[to]++;
+    };
+
+    for (size_t p = 0; p < n; p++) {
+      for (auto &e : nodes_[p]->outputs()) {
+        std::vector<size_t> readers;
+        for (auto r : e->next()) {
+          auto it = position.find(r);
+          if (it != position.end()) readers.push_back(it->second);
+        }
+        std::sort(readers.begin(), readers.end());
+        for (auto r : readers) {
+          add(forward_next_, forward_deps_, p, r);
+          add(backward_next_, backward_deps_, r, p);
+        }
+        // the readers write the gradient of the edge in turn, the last one
+        // first as in the order of nodes_
+        for (size_t i = 1; i < readers.size(); i++) {
+          add(backward_next_, backward_deps_, readers[i], readers[i - 1]);
+        }
+      }
+    }
+    scheduled_ = nodes_;
+  }
+
+  /**
+   * run(p) for every position p once the runs it waits for (deps, next)
+   * are over; runs that can start together are made on threads of their
+   * own, a run that can't overlap with another one on the calling thread
+   **/
+  template <typename Run>
+  void run_concurrently(const std::vector<std::vector<size_t>> &next,
+                        std::vector<size_t> deps,
+                        Run run) {
+    const size_t cores =
+      std::max(1u, static_cast<unsigned>(std::thread::hardware_concurrency()));
+    std::vector<size_t> ready;
+    for (size_t p = 0; p < deps.size(); p++) {
+      if (deps[p] == 0) ready.push_back(p);
+    }
+    auto release = [&](size_t p) {
+      for (auto s : next[p]) {
+        if (--deps[s] == 0) ready.push_back(s);
+      }
+    };
+
+    std::mutex mutex;
+    std::condition_variable over;
+    std::vector<size_t> finished;
+    std::exception_ptr error;
+    std::vector<std::future<void>> tasks;
+    size_t running = 0;
+    while (!ready.empty() || running > 0) {
+      if (ready.size() == 1 && running == 0) {
+        const size_t p = ready.back();
+        ready.pop_back();
+        run(p);
+        release(p);
+        continue;
+      }
+
+      for (; !ready.empty(); ready.pop_back()) {
+        const size_t p = ready.back();
+        // more layers at a time than cores: no threads within the layer
+        const bool single = ++running > cores;
+        tasks.push_back(std::async(std::launch::async, [&, p, single] {
+          layer *l               = nodes_[p];
+          const bool parallelize = l->parallelize();
+          if (single) l->set_parallelize(false);
+          try {
+            run(p);
+          } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) error = std::current_exception();
+          }
+          l->set_parallelize(parallelize);
+          std::lock_guard<std::mutex> lock(mutex);
+          finished.push_back(p);
+          over.notify_one();
+        }));
+      }
+
+      std::vector<size_t> done;
+      bool failed;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        over.wait(lock, [&] { return !finished.empty(); });
+        done.swap(finished);
+        failed = static_cast<bool>(error);
+      }
+      for (auto p : done) {
+        running--;
+        // after an error, nothing else is started
+        if (!failed) release(p);
+      }
+    }
+    for (auto &t : tasks) t.wait();
+    if (error) std::rethrow_exception(error);
+  }
+
+  // positions of the last layer of every segment, the last one included
+  void split_segments() {
+    segment_ends_.clear();
+    for (auto p : checkpoints_) {
+      if (p + 1 < nodes_.size()) segment_ends_.push_back(p);
+    }
+    segment_ends_.push_back(nodes_.size() - 1);
+
+    segment_.assign(nodes_.size(), 0);
+    position_.clear();
+    for (size_t p = 0, s = 0; p < nodes_.size(); p++) {
+      segment_[p]          = s;
+      position_[nodes_[p]] = p;
+      if (p == segment_ends_[s]) s++;
+    }
+  }
+
+  // whether the layer must keep its outputs whatever the edges they share
+  bool must_keep(size_t p) const {
+    const layer *l = nodes_[p];
+    if (p == segment_ends_[segment_[p]] || !l->is_recomputable()) return true;
+    for (const auto &e : l->outputs()) {
+      if (e->next().empty()) return true;
+      for (auto n : e->next()) {
+        auto c = position_.find(n);
+        if (c == position_.end() || segment_[c->second] != segment_[p]) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  /**
+   * which layers of the segment keep their outputs; edges sharing their
+   * data (in-place layers, views) are kept or dropped together, as a layer
+   * run again would otherwise write over a kept output, or clear its
+   * gradient
+   **/
+  void keep_outputs(size_t first, size_t last) {
+    auto keep = [&](size_t p) {
+      kept_[p] = true;
+      for (auto &e : nodes_[p]->outputs()) kept_storage_.insert(e->storage());
+    };
+    for (size_t p = first; p <= last; p++) {
+      if (must_keep(p)) keep(p);
+    }
+    for (bool changed = true; changed;) {
+      changed = false;
+      for (size_t p = first; p <= last; p++) {
+        if (kept_[p]) continue;
+        for (auto &e : nodes_[p]->outputs()) {
+          if (kept_storage_.count(e->storage())) {
+            keep(p);
+            changed = true;
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  void drop_outputs(size_t first, size_t last) {
+    for (size_t p = first; p <= last; p++) {
+      if (kept_[p]) continue;
+      for (auto &e : nodes_[p]->outputs()) e->release_data();
+    }
+  }
+
+  std::vector<size_t> segment_ends_;
+  std::vector<size_t> segment_;  // segment of every layer
+  std::unordered_map<const node *, size_t> position_;
+  std::vector<bool> kept_;  // layers keeping their outputs, after forward
+  std::unordered_set<edge *> kept_storage_;
+
+  std::vector<layer *> scheduled_;  // layers the dependencies are for
+  std::vector<std::vector<size_t>> forward_next_;
+  std::vector<std::vector<size_t>> backward_next_;
+  std::vector<size_t> forward_deps_;
+  std::vector<size_t> backward_deps_;
 };
 
 /**
@@ -280,9 +723,7 @@ class sequential : public nodes {
 
     nodes_.back()->set_out_grads(&reordered_grad[0], 1);
 
-    for (auto l = nodes_.rbegin(); l != nodes_.rend(); l++) {
-      (*l)->backward();
-    }
+    backward_layers();
   }
 
   std::vector<tensor_t> forward(const std::vector<tensor_t> &first) override {
@@ -292,9 +733,7 @@ class sequential : public nodes {
 
     nodes_.front()->set_in_data(&reordered_data[0], 1);
 
-    for (auto l : nodes_) {
-      l->forward();
-    }
+    forward_layers();
 
     std::vector<const tensor_t *> out;
     nodes_.back()->output(out);
@@ -340,6 +779,10 @@ class sequential : public nodes {
   template <typename OutputArchive>
   void save_connections(OutputArchive &) const {}
 
+ protected:
+  layer *input_layer() const override { return nodes_.front(); }
+  layer *output_layer() const override { return nodes_.back(); }
+
  private:
   friend class nodes;
 
@@ -380,9 +823,7 @@ class graph : public nodes {
       output_layers_[i]->set_out_grads(&reordered_grad[i], 1);
     }
 
-    for (auto l = nodes_.rbegin(); l != nodes_.rend(); l++) {
-      (*l)->backward();
-    }
+    backward_layers();
   }
 
   std::vector<tensor_t> forward(const std::vector<tensor_t> &in_data) override {
@@ -402,9 +843,7 @@ class graph : public nodes {
                                                 1);
     }
 
-    for (auto l : nodes_) {
-      l->forward();
-    }
+    forward_layers();
     return merge_outs();
   }
 
@@ -450,6 +889,19 @@ class graph : public nodes {
     setup(false);
   }
 
+ protected:
+  layer *input_layer() const override {
+    if (input_layers_.size() != 1) throw nn_error("not a single-input graph");
+    return input_layers_[0];
+  }
+
+  layer *output_layer() const override {
+    if (output_layers_.size() != 1) {
+      throw nn_error("not a single-output graph");
+    }
+    return output_layers_[0];
+  }
+
  private:
   friend class nodes;
 
@@ -29,12 +29,18 @@
 #include "tiny_dnn/layers/input_layer.h"
 #include "tiny_dnn/layers/linear_layer.h"
 #include "tiny_dnn/layers/lrn_layer.h"
+#include "tiny_dnn/layers/lstm_cell_layer.h"
 #include "tiny_dnn/layers/max_pooling_layer.h"
 #include "tiny_dnn/layers/max_unpooling_layer.h"
 #include "tiny_dnn/layers/power_layer.h"
+#include "tiny_dnn/layers/quantize_layer.h"
+#include "tiny_dnn/layers/quantized_concat_layer.h"
 #include "tiny_dnn/layers/quantized_convolutional_layer.h"
 #include "tiny_dnn/layers/quantized_deconvolutional_layer.h"
+#include "tiny_dnn/layers/quantized_fully_connected_layer.h"
+#include "tiny_dnn/layers/quantized_relu_layer.h"
 #include "tiny_dnn/layers/recurrent_cell_layer.h"
+#include "tiny_dnn/layers/recurrent_layer.h"
 #include "tiny_dnn/layers/slice_layer.h"
 
 #include "tiny_dnn/activations/elu_layer.h"
@@ -48,13 +54,10 @@
 #include "tiny_dnn/activations/tanh_layer.h"
 #include "tiny_dnn/activations/tanh_p1m2_layer.h"
 
-#ifdef CNN_USE_GEMMLOWP
-#include "tiny_dnn/layers/quantized_fully_connected_layer.h"
-#endif  // CNN_USE_GEMMLOWP
-
 #include "tiny_dnn/lossfunctions/loss_function.h"
 #include "tiny_dnn/optimizers/optimizer.h"
 
+#include "tiny_dnn/util/calibration.h"
 #include "tiny_dnn/util/deform.h"
 #include "tiny_dnn/util/graph_visualizer.h"
 #include "tiny_dnn/util/product.h"
@@ -102,9 +105,11 @@ using dense = tiny_dnn::fully_connected_layer;
 
 using recurrent_cell = tiny_dnn::recurrent_cell_layer;
 
-#ifdef CNN_USE_GEMMLOWP
+using recurrent = tiny_dnn::recurrent_layer;
+
+using lstm_cell = tiny_dnn::lstm_cell_layer;
+
 using q_fc = tiny_dnn::quantized_fully_connected_layer;
-#endif
 
 using add = tiny_dnn::elementwise_add_layer;
 
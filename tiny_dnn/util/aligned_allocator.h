@@ -8,7 +8,9 @@
 #pragma once
 
 #include <stdlib.h>
+#include <atomic>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 #ifdef _WIN32
@@ -23,6 +25,21 @@
 
 namespace tiny_dnn {
 
+/**
+ * number of heap allocations made by the buffers of the library (vec_t,
+ * row_t and the scratch arenas) since the program started, all threads
+ * together;
+ * compared before and after a call, it tells whether the call allocated
+ **/
+inline std::atomic<size_t> &heap_allocation_counter() {
+  static std::atomic<size_t> count(0);
+  return count;
+}
+
+inline size_t heap_allocations() {
+  return heap_allocation_counter().load(std::memory_order_relaxed);
+}
+
 template <typename T, std::size_t alignment>
 class aligned_allocator {
  public:
@@ -53,6 +70,7 @@ class aligned_allocator {
   pointer allocate(size_type size, const void * = nullptr) {
     void *p = aligned_alloc(alignment, sizeof(T) * size);
     if (!p && size > 0) throw nn_error("failed to allocate");
+    heap_allocation_counter().fetch_add(1, std::memory_order_relaxed);
     return static_cast<pointer>(p);
   }
 
@@ -125,4 +143,102 @@ inline bool operator!=(const aligned_allocator<T1, alignment> &,
   return false;
 }
 
+/**
+ * the allocator of row_t, the samples of a tensor: an aligned_allocator
+ * that can also be built over a buffer it doesn't own. It hands that
+ * buffer out to a vector of at most view_size elements, which is then a
+ * view of it: its elements are left as they are, and the buffer is never
+ * freed (see edge::view_features). Larger sizes fall back to the heap,
+ * and copies of the vector own their data.
+ **/
+template <typename T, std::size_t alignment>
+class view_allocator {
+ public:
+  typedef T value_type;
+  typedef T *pointer;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef T &reference;
+  typedef const T &const_reference;
+  typedef const T *const_pointer;
+
+  // swapping two rows swaps what they view (move assignment copies into it)
+  typedef std::true_type propagate_on_container_swap;
+
+  template <typename U>
+  struct rebind {
+    typedef view_allocator<U, alignment> other;
+  };
+
+  view_allocator() : view_(nullptr), view_size_(0) {}
+
+  view_allocator(T *view, size_type view_size)
+    : view_(view), view_size_(view_size) {}
+
+  template <typename U>
+  view_allocator(const view_allocator<U, alignment> &)
+    : view_(nullptr), view_size_(0) {}
+
+  view_allocator select_on_container_copy_construction() const {
+    return view_allocator();
+  }
+
+  const void *view() const { return view_; }
+
+  pointer allocate(size_type size, const void * = nullptr) {
+    if (view_ && size <= view_size_) return view_;
+    return aligned_allocator<T, alignment>().allocate(size);
+  }
+
+  size_type max_size() const {
+    return ~static_cast<std::size_t>(0) / sizeof(T);
+  }
+
+  void deallocate(pointer ptr, size_type size) {
+    if (ptr != view_) aligned_allocator<T, alignment>().deallocate(ptr, size);
+  }
+
+  template <class U, class... Args>
+  void construct(U *ptr, Args &&... args) {
+    void *p = ptr;
+    ::new (p) U(std::forward<Args>(args)...);
+  }
+
+  template <class U>
+  void construct(U *ptr) {
+    void *p = ptr;
+    if (in_view(p)) {
+      ::new (p) U;  // keep the data of the viewed buffer
+    } else {
+      ::new (p) U();
+    }
+  }
+
+  template <class U>
+  void destroy(U *ptr) {
+    ptr->~U();
+  }
+
+ private:
+  bool in_view(const void *p) const {
+    return view_ && p >= static_cast<const void *>(view_) &&
+           p < static_cast<const void *>(view_ + view_size_);
+  }
+
+  pointer view_;
+  size_type view_size_;
+};
+
+template <typename T1, typename T2, std::size_t alignment>
+inline bool operator==(const view_allocator<T1, alignment> &a,
+                       const view_allocator<T2, alignment> &b) {
+  return a.view() == b.view();
+}
+
+template <typename T1, typename T2, std::size_t alignment>
+inline bool operator!=(const view_allocator<T1, alignment> &a,
+                       const view_allocator<T2, alignment> &b) {
+  return !(a == b);
+}
+
 }  // namespace tiny_dnn
@@ -0,0 +1,204 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "tiny_dnn/network.h"
+#include "tiny_dnn/util/nn_error.h"
+
+namespace tiny_dnn {
+
+struct batching_params {
+  /** most requests forwarded at once */
+  size_t max_batch = 32;
+  /** longest time a request waits for others to join its batch */
+  std::chrono::microseconds max_delay = std::chrono::microseconds(1000);
+};
+
+/**
+ * Serves single-sample predictions from many threads by batching them.
+ *
+ * predict() can be called from any thread: the request is pushed onto a
+ * lock-free queue and the future of its output is returned. A worker thread
+ * takes the requests in order of arrival and forwards them through the
+ * network in batches (see network::predict over buffers), a batch being run
+ * as soon as it has max_batch requests or its oldest one has waited for
+ * max_delay. The network must not be used otherwise while the engine runs.
+ *
+ *     batching_engine<sequential> engine(net);
+ *     std::future<vec_t> out = engine.predict(in);
+ *     vec_t y = out.get();
+ **/
+template <typename NetType>
+class batching_engine {
+ public:
+  typedef std::chrono::steady_clock clock;
+
+  explicit batching_engine(network<NetType> &net,
+                           const batching_params &params = batching_params())
+    : net_(net),
+      params_(params),
+      in_size_(net.in_data_size()),
+      out_size_(net.out_data_size()),
+      head_(nullptr),
+      running_(true),
+      idle_(false),
+      batches_(0),
+      requests_(0) {
+    if (params_.max_batch == 0) throw nn_error("max_batch must be positive");
+    net_.set_netphase(net_phase::test);
+    worker_ = std::thread([this] { run(); });
+  }
+
+  batching_engine(const batching_engine &) = delete;
+  batching_engine &operator=(const batching_engine &) = delete;
+
+  // the requests already made are served before the worker stops
+  ~batching_engine() {
+    running_ = false;
+    wake();
+    worker_.join();
+  }
+
+  std::future<vec_t> predict(const vec_t &in) {
+    if (in.size() != in_size_) throw nn_error("input size mismatch");
+    request *r                = new request(in);
+    std::future<vec_t> output = r->output.get_future();
+    r->next                   = head_.load();
+    while (!head_.compare_exchange_weak(r->next, r)) {
+    }
+    if (idle_) wake();
+    return output;
+  }
+
+  // batches run so far
+  size_t batches() const { return batches_; }
+
+  // requests served so far
+  size_t requests() const { return requests_; }
+
+ private:
+  struct request {
+    explicit request(const vec_t &in)
+      : input(in), arrival(clock::now()), next(nullptr) {}
+
+    vec_t input;
+    std::promise<vec_t> output;
+    clock::time_point arrival;
+    request *next;
+  };
+
+  typedef std::deque<std::unique_ptr<request>> request_queue;
+
+  void run() {
+    request_queue pending;
+    for (;;) {
+      // read first, so that the requests made before stopping are taken
+      const bool stopping = !running_;
+      take(&pending);
+      if (pending.empty()) {
+        if (stopping) return;
+        sleep_until(clock::now() + std::chrono::milliseconds(100));
+        continue;
+      }
+
+      const clock::time_point deadline =
+        pending.front()->arrival + params_.max_delay;
+      if (!stopping && pending.size() < params_.max_batch &&
+          clock::now() < deadline) {
+        sleep_until(deadline);
+        continue;
+      }
+      forward(&pending);
+    }
+  }
+
+  // move the requests of the queue to pending, oldest first
+  void take(request_queue *pending) {
+    request *r        = head_.exchange(nullptr);
+    request *reversed = nullptr;
+    while (r) {
+      request *next = r->next;
+      r->next       = reversed;
+      reversed      = r;
+      r             = next;
+    }
+    for (r = reversed; r; r = r->next) pending->emplace_back(r);
+  }
+
+  void forward(request_queue *pending) {
+    const size_t n = std::min(pending->size(), params_.max_batch);
+    in_.resize(n * in_size_);
+    out_.resize(n * out_size_);
+    for (size_t i = 0; i < n; i++) {
+      const vec_t &input = (*pending)[i]->input;
+      std::copy(input.begin(), input.end(), in_.begin() + i * in_size_);
+    }
+    // counted before the outputs are ready, for the callers waiting on them
+    batches_++;
+    requests_ += n;
+
+    try {
+      net_.predict(&in_[0], n, &out_[0]);
+      for (size_t i = 0; i < n; i++) {
+        auto first = out_.begin() + i * out_size_;
+        (*pending)[i]->output.set_value(vec_t(first, first + out_size_));
+      }
+    } catch (...) {
+      for (size_t i = 0; i < n; i++) {
+        (*pending)[i]->output.set_exception(std::current_exception());
+      }
+    }
+    pending->erase(pending->begin(), pending->begin() + n);
+  }
+
+  /**
+   * wait for a request (or the engine to stop) until the given time; the
+   * request made while idle_ is being set is seen by the check under the
+   * lock, a later one notifies
+   **/
+  void sleep_until(clock::time_point t) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_ = true;
+    if (!head_.load() && running_) wakeup_.wait_until(lock, t);
+    idle_ = false;
+  }
+
+  void wake() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wakeup_.notify_one();
+  }
+
+  network<NetType> &net_;
+  batching_params params_;
+  size_t in_size_;
+  size_t out_size_;
+  vec_t in_;   // inputs of the batch, one sample after another
+  vec_t out_;  // outputs of the batch
+
+  std::atomic<request *> head_;  // newest request of the queue
+  std::atomic<bool> running_;
+  std::atomic<bool> idle_;  // whether the worker waits for requests
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  std::atomic<size_t> batches_;
+  std::atomic<size_t> requests_;
+  std::thread worker_;
+};
+
+}  // namespace tiny_dnn
@@ -0,0 +1,491 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tiny_dnn/activations/relu_layer.h"
+#include "tiny_dnn/core/params/params.h"
+#include "tiny_dnn/layers/convolutional_layer.h"
+#include "tiny_dnn/layers/deconvolutional_layer.h"
+#include "tiny_dnn/layers/fully_connected_layer.h"
+#include "tiny_dnn/layers/max_pooling_layer.h"
+#include "tiny_dnn/layers/quantize_layer.h"
+#include "tiny_dnn/layers/quantized_convolutional_layer.h"
+#include "tiny_dnn/layers/quantized_deconvolutional_layer.h"
+#include "tiny_dnn/layers/quantized_fully_connected_layer.h"
+#include "tiny_dnn/layers/quantized_relu_layer.h"
+#include "tiny_dnn/network.h"
+#include "tiny_dnn/util/nn_error.h"
+
+#ifndef CNN_NO_SERIALIZATION
+#include "tiny_dnn/util/deserialization_helper.h"
+#include "tiny_dnn/util/serialization_helper.h"
+#endif  // CNN_NO_SERIALIZATION
+
+namespace tiny_dnn {
+
+/**
+ * how the static range of an activation is derived from the values observed
+ * during calibration
+ **/
+enum class calibration_method {
+  min_max,       ///< whole observed range
+  percentile,    ///< drops the outer (100 - percentile)% on each side
+  kl_divergence  ///< clipping threshold minimizing the information loss
+};
+
+struct calibration_params {
+  calibration_method method = calibration_method::min_max;
+  /** kept percentage of the values in percentile mode */
+  float_t percentile = float_t(99.99);
+  /** histogram resolution of the percentile and kl_divergence modes */
+  size_t bins = 2048;
+  /** number of samples forwarded at once */
+  size_t batch_size = 32;
+  /** engine of the layers replaced by quantize_network */
+  core::backend_t engine = core::backend_t::internal;
+  /** keep the activations as 8-bit codes between the quantized layers */
+  bool int8_activations = false;
+};
+
+/**
+ * distribution of the values seen on one edge of the network. The first
+ * pass over the calibration data records the range, the histogram bins are
+ * laid out over it for the second pass (only needed by the histogram based
+ * methods).
+ **/
+class activation_histogram {
+ public:
+  void observe(const tensor_t &t) {
+    for (const auto &v : t) {
+      for (const auto x : v) {
+        if (!counts_.empty()) {
+          add(x);
+        } else if (empty_) {
+          min_   = x;
+          max_   = x;
+          empty_ = false;
+        } else {
+          min_ = std::min(min_, x);
+          max_ = std::max(max_, x);
+        }
+      }
+    }
+  }
+
+  /** freezes the observed range and starts counting values into bins */
+  void start_histogram(size_t bins) {
+    counts_.assign(bins, 0);
+    abs_counts_.assign(bins, 0);
+  }
+
+  core::quantization_range range(const calibration_params &params) const {
+    core::quantization_range r;
+    if (empty_) return r;
+
+    switch (params.method) {
+      case calibration_method::min_max:
+        r.min = min_;
+        r.max = max_;
+        break;
+      case calibration_method::percentile: percentile_range(params, &r); break;
+      case calibration_method::kl_divergence: kl_range(&r); break;
+      default: throw nn_error("unknown calibration method");
+    }
+    // zero has to be exactly representable (zero padding, relu, bias-free
+    // channels)
+    r.min = std::min(r.min, float_t{0});
+    r.max = std::max(r.max, float_t{0});
+    return r;
+  }
+
+ private:
+  float_t abs_max() const { return std::max(std::abs(min_), std::abs(max_)); }
+
+  void add(float_t x) {
+    const size_t n = counts_.size();
+    if (max_ > min_) {
+      const float_t pos = std::max((x - min_) / (max_ - min_), float_t{0});
+      counts_[std::min(static_cast<size_t>(pos * n), n - 1)]++;
+    }
+    const float_t amax = abs_max();
+    if (amax > float_t{0}) {
+      const float_t pos = std::abs(x) / amax;
+      abs_counts_[std::min(static_cast<size_t>(pos * n), n - 1)]++;
+    }
+  }
+
+  void percentile_range(const calibration_params &params,
+                        core::quantization_range *r) const {
+    r->min = min_;
+    r->max = max_;
+    if (counts_.empty() || !(max_ > min_)) return;
+
+    const size_t n     = counts_.size();
+    const double width = static_cast<double>(max_ - min_) / n;
+    const double total = static_cast<double>(sum(counts_, 0, n));
+    const double tail  = total * (100.0 - params.percentile) / 100.0;
+
+    double acc = 0;
+    size_t lo  = 0;
+    for (; lo < n && acc + counts_[lo] <= tail; lo++) acc += counts_[lo];
+    acc       = 0;
+    size_t hi = n;
+    for (; hi > lo + 1 && acc + counts_[hi - 1] <= tail; hi--) {
+      acc += counts_[hi - 1];
+    }
+
+    r->min = static_cast<float_t>(min_ + lo * width);
+    r->max = static_cast<float_t>(min_ + hi * width);
+  }
+
+  /**
+   * entropy calibration: for every candidate threshold the clipped
+   * distribution P (outliers folded into its last bin) is merged down to the
+   * number of quantization levels (Q) and the threshold with the lowest
+   * KL(P || Q) wins.
+   **/
+  void kl_range(core::quantization_range *r) const {
+    r->min = min_;
+    r->max = max_;
+    if (abs_counts_.empty() || !(abs_max() > float_t{0})) return;
+
+    // uint8 spans [0, t] for non-negative data, [-t, t] otherwise
+    const size_t levels = min_ >= float_t{0} ? 255 : 128;
+    const size_t n      = abs_counts_.size();
+    if (n <= levels) return;
+
+    std::vector<double> p(n), q(n);
+    double best_kl   = std::numeric_limits<double>::max();
+    size_t best_bins = n;
+    double outliers  = static_cast<double>(sum(abs_counts_, levels, n));
+
+    for (size_t i = levels; i <= n; i++) {
+      for (size_t k = 0; k < i; k++) p[k] = static_cast<double>(abs_counts_[k]);
+      p[i - 1] += outliers;
+      if (i < n) outliers -= abs_counts_[i];
+
+      // merge i bins into the quantization levels and spread every level
+      // back over the bins that were non-empty
+      for (size_t j = 0; j < levels; j++) {
+        const size_t start = j * i / levels;
+        const size_t end   = (j + 1) * i / levels;
+        double merged      = 0;
+        size_t nonzero     = 0;
+        for (size_t k = start; k < end; k++) {
+          merged += abs_counts_[k];
+          nonzero += abs_counts_[k] != 0;
+        }
+        for (size_t k = start; k < end; k++) {
+          q[k] = abs_counts_[k] != 0 ? merged / nonzero : 0;
+        }
+      }
+
+      const double kl = divergence(p, q, i);
+      if (kl < best_kl) {
+        best_kl   = kl;
+        best_bins = i;
+      }
+    }
+
+    const float_t t = abs_max() * best_bins / n;
+    r->min          = std::max(min_, -t);
+    r->max          = std::min(max_, t);
+  }
+
+  static size_t sum(const std::vector<size_t> &v, size_t begin, size_t end) {
+    size_t s = 0;
+    for (size_t i = begin; i < end; i++) s += v[i];
+    return s;
+  }
+
+  // KL(p || q) over the first n bins, q is smoothed where p is non-zero
+  static double divergence(const std::vector<double> &p,
+                           const std::vector<double> &q,
+                           size_t n) {
+    const double eps = 1e-4;
+    double sum_p     = 0;
+    double sum_q     = 0;
+    for (size_t k = 0; k < n; k++) {
+      sum_p += p[k];
+      sum_q += q[k];
+    }
+    if (sum_p == 0 || sum_q == 0) return std::numeric_limits<double>::max();
+
+    double kl = 0;
+    for (size_t k = 0; k < n; k++) {
+      if (p[k] == 0) continue;
+      const double pk = p[k] / sum_p;
+      const double qk = std::max(q[k] / sum_q, eps / n);
+      kl += pk * std::log(pk / qk);
+    }
+    return kl;
+  }
+
+  bool empty_  = true;
+  float_t min_ = float_t{0};
+  float_t max_ = float_t{0};
+  std::vector<size_t> counts_;      // over [min, max]
+  std::vector<size_t> abs_counts_;  // of |x| over [0, max(|min|, |max|)]
+};
+
+/**
+ * runs the float network over a representative dataset and returns the range
+ * of every activation: [0] is the network input, [i + 1] the output of the
+ * i-th layer. empty ranges are returned for edges that only carried a single
+ * value.
+ **/
+inline std::vector<core::quantization_range> calibrate_quantization_ranges(
+  network<sequential> &net,
+  const std::vector<vec_t> &data,
+  const calibration_params &params = calibration_params()) {
+  if (data.empty()) throw nn_error("calibration dataset is empty");
+  if (params.batch_size == 0) throw nn_error("batch size must be positive");
+
+  std::vector<activation_histogram> hist(net.depth() + 1);
+  const size_t passes = params.method == calibration_method::min_max ? 1 : 2;
+
+  for (size_t pass = 0; pass < passes; pass++) {
+    if (pass == 1) {
+      for (auto &h : hist) h.start_histogram(params.bins);
+    }
+    for (size_t i = 0; i < data.size(); i += params.batch_size) {
+      const size_t end = std::min(i + params.batch_size, data.size());
+      const tensor_t in(data.begin() + i, data.begin() + end);
+      std::vector<tensor_t> batch(end - i);
+      for (size_t j = i; j < end; j++) batch[j - i].push_back(data[j]);
+
+      net.predict(batch);
+
+      hist[0].observe(in);
+      std::vector<const tensor_t *> out;
+      for (size_t l = 0; l < net.depth(); l++) {
+        net[l]->output(out);
+        hist[l + 1].observe(*out[0]);
+      }
+    }
+  }
+
+  std::vector<core::quantization_range> ranges;
+  for (const auto &h : hist) ranges.push_back(h.range(params));
+  return ranges;
+}
+
+namespace detail {
+
+#ifndef CNN_NO_SERIALIZATION
+// re-creates l as the layer registered under type, which has to serialize the
+// same fields, and copies the weights over
+template <typename T>
+std::shared_ptr<layer> convert_layer(const T &l, const std::string &type) {
+  std::stringstream ss;
+  {
+    cereal::BinaryOutputArchive oa(ss);
+    oa(type);
+    serialization_buddy::serialize(oa, const_cast<T &>(l));
+    oa(static_cast<const layer &>(l));
+  }
+  cereal::BinaryInputArchive ia(ss);
+  std::shared_ptr<layer> converted = layer::load_layer(ia);
+  ia(*converted);
+  return converted;
+}
+
+inline std::shared_ptr<layer> clone_layer(const layer &l) {
+  std::stringstream ss;
+  {
+    cereal::BinaryOutputArchive oa(ss);
+    layer::save_layer(oa, l);
+    oa(l);
+  }
+  cereal::BinaryInputArchive ia(ss);
+  std::shared_ptr<layer> cloned = layer::load_layer(ia);
+  ia(*cloned);
+  return cloned;
+}
+#endif  // CNN_NO_SERIALIZATION
+
+template <typename Quantized>
+void set_static_ranges(layer *l,
+                       const core::quantization_range &in_range,
+                       const core::quantization_range &out_range,
+                       core::backend_t engine,
+                       bool int8_input  = false,
+                       bool int8_output = false) {
+  auto &q = dynamic_cast<Quantized &>(*l);
+  q.set_quantization_ranges(in_range, out_range);
+  q.set_int8_io(int8_input, int8_output);
+  q.set_backend_type(engine);
+}
+
+}  // namespace detail
+
+/**
+ * builds the quantized counterpart of a float network. convolutional,
+ * deconvolutional and fully-connected layers are replaced by quantized
+ * layers running on the given engine with the static ranges of
+ * calibrate_quantization_ranges, every other layer is copied as it is.
+ *
+ * With int8_activations the quantized layers hand their 8-bit codes directly
+ * to each other: relu following a quantized layer is folded into its output
+ * range, max pooling and relu run on the codes, and a dequantize_layer is put
+ * in front of any other layer (and at the end), so only the network input
+ * and output are float.
+ **/
+inline network<sequential> quantize_network(
+  network<sequential> &net,
+  const std::vector<core::quantization_range> &ranges,
+  core::backend_t engine = core::backend_t::internal,
+  bool int8_activations  = false) {
+#ifndef CNN_NO_SERIALIZATION
+  if (ranges.size() != net.depth() + 1) {
+    throw nn_error("number of ranges doesn't match the network depth");
+  }
+
+  network<sequential> quantized(net.name());
+  // whether the current edge carries codes of edge_range
+  bool coded = false;
+  core::quantization_range edge_range;
+
+  for (size_t i = 0; i < net.depth(); i++) {
+    const layer *l = net[i];
+    const bool is_quantized =
+      dynamic_cast<const convolutional_layer *>(l) ||
+      dynamic_cast<const deconvolutional_layer *>(l) ||
+      dynamic_cast<const fully_connected_layer *>(l);
+    const core::quantization_range in_range = coded ? edge_range : ranges[i];
+    core::quantization_range out_range      = ranges[i + 1];
+    bool fuse_relu                          = false;
+    bool int8_output                        = false;
+
+    if (int8_activations && is_quantized && out_range.is_static()) {
+      int8_output = true;
+      if (i + 1 < net.depth() && dynamic_cast<const relu_layer *>(net[i + 1]) &&
+          ranges[i + 2].is_static()) {
+        // [0, max] clamps negative values to the code of 0
+        out_range = ranges[i + 2];
+        fuse_relu = true;
+      }
+    }
+
+    if (coded && !is_quantized) {
+      if (dynamic_cast<const relu_layer *>(l)) {
+        quantized << std::make_shared<quantized_relu_layer>(l->in_shape()[0],
+                                                            edge_range);
+        continue;
+      }
+      if (!dynamic_cast<const max_pooling_layer *>(l)) {
+        quantized << std::make_shared<dequantize_layer>(l->in_shape()[0],
+                                                        edge_range);
+        coded = false;
+      }
+    }
+
+    std::shared_ptr<layer> q;
+    if (auto conv = dynamic_cast<const convolutional_layer *>(l)) {
+      q = detail::convert_layer(*conv, "q_conv");
+      detail::set_static_ranges<quantized_convolutional_layer>(
+        q.get(), in_range, out_range, engine, coded, int8_output);
+    } else if (auto deconv = dynamic_cast<const deconvolutional_layer *>(l)) {
+      q = detail::convert_layer(*deconv, "q_deconv");
+      detail::set_static_ranges<quantized_deconvolutional_layer>(
+        q.get(), in_range, out_range, engine, coded, int8_output);
+    } else if (auto fc = dynamic_cast<const fully_connected_layer *>(l)) {
+      q = detail::convert_layer(*fc, "q_fully_connected");
+      detail::set_static_ranges<quantized_fully_connected_layer>(
+        q.get(), in_range, out_range, engine, coded, int8_output);
+    } else {
+      q = detail::clone_layer(*l);
+    }
+    quantized << std::move(q);
+
+    if (is_quantized) {
+      coded      = int8_output;
+      edge_range = out_range;
+    }
+    if (fuse_relu) i++;
+  }
+
+  if (coded) {
+    quantized << std::make_shared<dequantize_layer>(
+      net[net.depth() - 1]->out_shape()[0], edge_range);
+  }
+  return quantized;
+#else
+  CNN_UNREFERENCED_PARAMETER(net);
+  CNN_UNREFERENCED_PARAMETER(ranges);
+  CNN_UNREFERENCED_PARAMETER(engine);
+  CNN_UNREFERENCED_PARAMETER(int8_activations);
+  throw nn_error("tiny-dnn was not built with Serialization support");
+#endif  // CNN_NO_SERIALIZATION
+}
+
+/**
+ * activation ranges learned by quantization-aware training, in the layout of
+ * calibrate_quantization_ranges: the convolutional and fully-connected layers
+ * with fake quantization enabled provide their input/output ranges, relu and
+ * max pooling carry them on; the remaining edges get an empty range.
+ **/
+inline std::vector<core::quantization_range> fake_quantization_ranges(
+  network<sequential> &net) {
+  std::vector<core::quantization_range> ranges(net.depth() + 1);
+
+  for (size_t i = 0; i < net.depth(); i++) {
+    const layer *l = net[i];
+    if (auto conv = dynamic_cast<const convolutional_layer *>(l)) {
+      if (!conv->fake_quantization()) continue;
+      ranges[i]     = conv->input_range();
+      ranges[i + 1] = conv->output_range();
+    } else if (auto fc = dynamic_cast<const fully_connected_layer *>(l)) {
+      if (!fc->fake_quantization()) continue;
+      ranges[i]     = fc->input_range();
+      ranges[i + 1] = fc->output_range();
+    } else if (dynamic_cast<const relu_layer *>(l) && ranges[i].is_static()) {
+      ranges[i + 1].max = ranges[i].max;
+    } else if (dynamic_cast<const max_pooling_layer *>(l)) {
+      ranges[i + 1] = ranges[i];
+    }
+  }
+  return ranges;
+}
+
+/**
+ * converts a network trained with fake quantization into its quantized
+ * counterpart, with the ranges learned in training baked into the
+ * quantized layers.
+ **/
+inline network<sequential> quantize_network(
+  network<sequential> &net,
+  core::backend_t engine = core::backend_t::internal,
+  bool int8_activations  = false) {
+  return quantize_network(net, fake_quantization_ranges(net), engine,
+                          int8_activations);
+}
+
+/**
+ * post-training static quantization: calibrates the activation ranges of the
+ * float network on a representative dataset and returns the quantized
+ * network using them, so inference doesn't scan activations for their range.
+ **/
+inline network<sequential> quantize_network(
+  network<sequential> &net,
+  const std::vector<vec_t> &calibration_data,
+  const calibration_params &params = calibration_params()) {
+  return quantize_network(
+    net, calibrate_quantization_ranges(net, calibration_data, params),
+    params.engine, params.int8_activations);
+}
+
+}  // namespace tiny_dnn
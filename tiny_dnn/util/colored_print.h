@@ -7,6 +7,8 @@
 */
 #pragma once
 
+#include <cassert>
+#include <cstdarg>
 #include <string>
 
 #include "tiny_dnn/config.h"
@@ -22,77 +22,121 @@ inline void vector_div(vec_t &x, float_t denom) {
 
 namespace detail {
 
-inline void moments_impl_calc_mean(size_t num_examples,
-                                   size_t channels,
-                                   size_t spatial_dim,
-                                   const tensor_t &in,
-                                   vec_t &mean) {
-  for (size_t i = 0; i < num_examples; i++) {
-    for (size_t j = 0; j < channels; j++) {
-      float_t &rmean = mean.at(j);
-      const auto it  = in[i].begin() + (j * spatial_dim);
-      rmean          = std::accumulate(it, it + spatial_dim, rmean);
-    }
-  }
+/**
+ * number of blocks of samples reduced in parallel by the moments, merged
+ * in order afterwards; fixed by the batch size, so that the result does not
+ * depend on the number of threads
+ **/
+inline size_t moments_blocks(size_t num_examples) {
+  return std::min(num_examples, size_t(16));
 }
 
-inline void moments_impl_calc_variance(size_t num_examples,
-                                       size_t channels,
-                                       size_t spatial_dim,
-                                       const tensor_t &in,
-                                       const vec_t &mean,
-                                       vec_t &variance) {
-  assert(mean.size() >= channels);
-  for (size_t i = 0; i < num_examples; i++) {
-    for (size_t j = 0; j < channels; j++) {
-      float_t &rvar    = variance[j];
-      const auto it    = in[i].begin() + (j * spatial_dim);
-      const float_t ex = mean[j];
-      rvar             = std::accumulate(it, it + spatial_dim, rvar,
-                             [ex](float_t current, float_t x) {
-                               return current + pow(x - ex, float_t{2.0});
-                             });
-    }
-  }
-  vector_div(
-    variance,
-    std::max(float_t{1.0f},
-             static_cast<float_t>(num_examples * spatial_dim) - float_t{1.0f}));
+// first sample of block b (b == blocks for the end)
+inline size_t moments_block_begin(size_t b,
+                                  size_t blocks,
+                                  size_t num_examples) {
+  return b * num_examples / blocks;
 }
 
+// count, mean and sum of squared deviations of part of a channel
+struct moments_accumulator {
+  moments_accumulator() : n(0), mean(0), m2(0) {}
+
+  // Chan et al.'s pairwise update, stable unlike sum(x^2) - sum(x)^2
+  void merge(float_t nb, float_t mean_b, float_t m2_b) {
+    const float_t total = n + nb;
+    if (total == 0) return;
+    const float_t delta = mean_b - mean;
+    mean += delta * nb / total;
+    m2 += m2_b + delta * delta * n * nb / total;
+    n = total;
+  }
+
+  void merge(const moments_accumulator &other) {
+    merge(other.n, other.mean, other.m2);
+  }
+
+  float_t n;
+  float_t mean;
+  float_t m2;
+};
+
 }  // namespace detail
 
 /**
- * calculate mean/variance across channels
+ * calculate mean across channels
  */
 inline void moments(const tensor_t &in,
                     size_t spatial_dim,
                     size_t channels,
                     vec_t &mean) {
   const size_t num_examples = in.size();
+  const size_t blocks       = detail::moments_blocks(num_examples);
   assert(in[0].size() == spatial_dim * channels);
 
-  mean.resize(channels);
-  vectorize::fill(&mean[0], mean.size(), float_t{0.0});
-  detail::moments_impl_calc_mean(num_examples, channels, spatial_dim, in, mean);
+  // sums of every block, then of the blocks
+  vec_t sums(blocks * channels, float_t{0});
+  for_i(blocks, [&](size_t b) {
+    float_t *sum = &sums[b * channels];
+    for (size_t i = detail::moments_block_begin(b, blocks, num_examples);
+         i < detail::moments_block_begin(b + 1, blocks, num_examples); i++) {
+      const float_t *x = &in[i][0];
+      for (size_t j = 0; j < channels; j++, x += spatial_dim) {
+        sum[j] = std::accumulate(x, x + spatial_dim, sum[j]);
+      }
+    }
+  });
+
+  mean.assign(channels, float_t{0});
+  for (size_t b = 0; b < blocks; b++) {
+    vectorize::reduce(&sums[b * channels], channels, &mean[0]);
+  }
   vector_div(mean, (float_t)num_examples * spatial_dim);
 }
 
+/**
+ * calculate mean/variance across channels
+ *
+ * A single pass over the data: the samples are split in blocks reduced in
+ * parallel, every row of a channel (hot in cache) giving its mean and sum of
+ * squared deviations, merged with those of the other rows and blocks.
+ */
 inline void moments(const tensor_t &in,
                     size_t spatial_dim,
                     size_t channels,
                     vec_t &mean,
                     vec_t &variance) {
   const size_t num_examples = in.size();
+  const size_t blocks       = detail::moments_blocks(num_examples);
   assert(in[0].size() == spatial_dim * channels);
 
-  // calc mean
-  moments(in, spatial_dim, channels, mean);
+  std::vector<detail::moments_accumulator> acc(blocks * channels);
+  for_i(blocks, [&](size_t b) {
+    detail::moments_accumulator *a = &acc[b * channels];
+    for (size_t i = detail::moments_block_begin(b, blocks, num_examples);
+         i < detail::moments_block_begin(b + 1, blocks, num_examples); i++) {
+      const float_t *x = &in[i][0];
+      for (size_t j = 0; j < channels; j++, x += spatial_dim) {
+        const float_t row_mean =
+          std::accumulate(x, x + spatial_dim, float_t{0}) / spatial_dim;
+        float_t m2 = 0;
+        for (size_t k = 0; k < spatial_dim; k++) {
+          m2 += (x[k] - row_mean) * (x[k] - row_mean);
+        }
+        a[j].merge(float_t(spatial_dim), row_mean, m2);
+      }
+    }
+  });
 
+  mean.resize(channels);
   variance.resize(channels);
-  vectorize::fill(&variance[0], variance.size(), float_t{0.0});
-  detail::moments_impl_calc_variance(num_examples, channels, spatial_dim, in,
-                                     mean, variance);
+  for (size_t j = 0; j < channels; j++) {
+    detail::moments_accumulator total;
+    for (size_t b = 0; b < blocks; b++) total.merge(acc[b * channels + j]);
+    mean[j]     = total.mean;
+    variance[j] =
+      total.m2 / std::max(float_t{1}, float_t(num_examples * spatial_dim) - 1);
+  }
 }
 
 }  // namespace tiny_dnn
@@ -0,0 +1,185 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "tiny_dnn/layers/layer.h"
+
+namespace tiny_dnn {
+
+/**
+ * memory of the activations of a network, in bytes per sample
+ **/
+struct memory_plan {
+  size_t naive_bytes   = 0;  // every activation in its own buffer
+  size_t planned_bytes = 0;  // activations sharing the slots of the plan
+  size_t slots         = 0;  // number of buffers shared by the activations
+};
+
+/**
+ * Reuse of the activation buffers of a network in the test phase.
+ *
+ * Every edge holds its data for the lifetime of the network, which training
+ * needs (the backward pass reads them again) but inference doesn't: once the
+ * last consumer of an edge has run, its buffer can hold a later activation.
+ * Over the order in which the layers run, the planner computes the interval
+ * during which the data of each edge are live, then assigns the edges to
+ * slots by best fit, an edge going to a slot whose last edge is dead before
+ * the new one is written. The planned edges become views of their slot (see
+ * edge::view_features).
+ *
+ * Edges sharing their data (views, pass-through and in-place layers) are
+ * planned as one buffer, live from the first write to the last read of any
+ * of them. The inputs and outputs of the network, those without producer or
+ * consumer, keep their own buffers.
+ **/
+class memory_planner {
+ public:
+  /**
+   * @param order layers in the order of the forward pass
+   **/
+  memory_plan plan(const std::vector<layer *> &order) {
+    release();
+
+    std::unordered_map<const node *, int> position;
+    for (size_t i = 0; i < order.size(); i++) {
+      position[order[i]] = static_cast<int>(i);
+      order[i]->share_storage();
+    }
+    // outputs of pass-through and in-place layers are their inputs (see
+    // layer::share_input)
+    for (auto l : order) l->share_input();
+
+    // live interval of every buffer, pinned when it can't be planned
+    memory_plan report;
+    std::unordered_set<edge *> edges;
+    std::unordered_map<edge *, buffer> buffers;
+    std::vector<edge *> roots;
+    auto add = [&](edge *e) {
+      if (edges.insert(e).second) {
+        report.naive_bytes += e->shape().size() * sizeof(float_t);
+      }
+      edge *root = e->storage();
+      if (buffers.find(root) == buffers.end()) {
+        buffers[root] = buffer(root->shape().size());
+        roots.push_back(root);
+      }
+      buffer &b = buffers[root];
+
+      auto p = position.find(e->prev());
+      if (p == position.end()) {
+        b.pinned = true;
+      } else {
+        b.first = std::min(b.first, p->second);
+      }
+      if (e->next().empty()) b.pinned = true;
+      for (auto n : e->next()) {
+        auto c = position.find(n);
+        if (c == position.end()) {
+          b.pinned = true;
+        } else {
+          b.last = std::max(b.last, c->second);
+        }
+      }
+    };
+    for (auto l : order) {
+      for (auto &e : l->inputs()) {
+        if (!is_trainable_weight(e->vtype())) add(e.get());
+      }
+      for (auto &e : l->outputs()) {
+        if (!is_trainable_weight(e->vtype())) add(e.get());
+      }
+    }
+
+    std::stable_sort(roots.begin(), roots.end(), [&](edge *a, edge *b) {
+      return buffers[a].first < buffers[b].first;
+    });
+
+    std::vector<int> slot_last;  // last reader of each slot
+    std::vector<size_t> slot_size;
+    std::vector<std::pair<edge *, size_t>> assignment;
+    for (auto root : roots) {
+      const buffer &b = buffers[root];
+      if (b.pinned) {
+        report.planned_bytes += b.size * sizeof(float_t);
+        continue;
+      }
+
+      // the smallest free slot large enough, else the largest one (grown)
+      size_t best = slot_size.size();
+      for (size_t s = 0; s < slot_size.size(); s++) {
+        if (slot_last[s] >= b.first) continue;
+        if (best == slot_size.size()) {
+          best = s;
+        } else if (slot_size[best] < b.size) {
+          if (slot_size[s] > slot_size[best]) best = s;
+        } else if (slot_size[s] >= b.size && slot_size[s] < slot_size[best]) {
+          best = s;
+        }
+      }
+      if (best == slot_size.size()) {
+        slot_last.push_back(b.last);
+        slot_size.push_back(b.size);
+      } else {
+        slot_last[best] = b.last;
+        slot_size[best] = std::max(slot_size[best], b.size);
+      }
+      assignment.emplace_back(root, best);
+    }
+
+    for (auto size : slot_size) {
+      slots_.push_back(std::make_shared<edge>(nullptr, shape3d(size, 1, 1),
+                                              vector_type::data));
+      slots_.back()->set_gradient_enabled(false);
+      report.planned_bytes += size * sizeof(float_t);
+    }
+    for (auto &a : assignment) {
+      a.first->view_features(slots_[a.second].get(), 0, false);
+      planned_.push_back(a.first);
+    }
+    report.slots = slots_.size();
+    return report;
+  }
+
+  /**
+   * give every planned edge its own buffer back, e.g. before training
+   **/
+  void release() {
+    for (auto e : planned_) e->detach_view();
+    planned_.clear();
+    slots_.clear();
+  }
+
+  bool empty() const { return planned_.empty(); }
+
+ private:
+  struct buffer {
+    explicit buffer(size_t size = 0)
+      : size(size),
+        first(std::numeric_limits<int>::max()),
+        last(-1),
+        pinned(false) {}
+
+    size_t size;  // elements per sample
+    int first;    // position of the first writer
+    int last;     // position of the last reader
+    bool pinned;  // whether the buffer is kept for the whole network
+  };
+
+  std::vector<std::shared_ptr<edge>> slots_;
+  std::vector<edge *> planned_;
+};
+
+}  // namespace tiny_dnn
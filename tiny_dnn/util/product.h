@@ -11,7 +11,9 @@
 #include <immintrin.h>
 #endif
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
 #include <numeric>
 
@@ -45,6 +47,22 @@ struct scalar_generic {
                                             const register_type &v3) {
     return v1 * v2 + v3;
   }
+  static CNN_MUST_INLINE register_type sub(const register_type &v1,
+                                           const register_type &v2) {
+    return v1 - v2;
+  }
+  static CNN_MUST_INLINE register_type div(const register_type &v1,
+                                           const register_type &v2) {
+    return v1 / v2;
+  }
+  static CNN_MUST_INLINE register_type exp(const register_type &v) {
+    return std::exp(v);
+  }
+  // v where bit 0 of bits is set, zero elsewhere
+  static CNN_MUST_INLINE register_type select(const register_type &v,
+                                              uint32_t bits) {
+    return (bits & 1) ? v : register_type(0);
+  }
 
   template <typename aligned>
   static CNN_MUST_INLINE register_type load(const value_type *px) {
@@ -85,6 +103,46 @@ struct float_sse {
                                             const register_type &v3) {
     return _mm_add_ps(_mm_mul_ps(v1, v2), v3);
   }
+  static CNN_MUST_INLINE register_type sub(const register_type &v1,
+                                           const register_type &v2) {
+    return _mm_sub_ps(v1, v2);
+  }
+  static CNN_MUST_INLINE register_type div(const register_type &v1,
+                                           const register_type &v2) {
+    return _mm_div_ps(v1, v2);
+  }
+  // Cephes expf: 2^n * exp(r), |r| <= ln(2) / 2, exp(r) being a polynomial
+  static CNN_MUST_INLINE register_type exp(const register_type &v) {
+    __m128 x = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-88.3762626647949f)),
+                          _mm_set1_ps(88.3762626647949f));
+    // n = floor(x / ln(2) + 1/2), without the SSE4.1 rounding
+    __m128 n = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(1.44269504088896341f)),
+                          _mm_set1_ps(0.5f));
+    const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(n));
+    n = _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, n), _mm_set1_ps(1.0f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(0.693359375f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(-2.12194440e-4f)));
+
+    __m128 y = _mm_set1_ps(1.9875691500e-4f);
+    y        = madd(y, x, _mm_set1_ps(1.3981999507e-3f));
+    y        = madd(y, x, _mm_set1_ps(8.3334519073e-3f));
+    y        = madd(y, x, _mm_set1_ps(4.1665795894e-2f));
+    y        = madd(y, x, _mm_set1_ps(1.6666665459e-1f));
+    y        = madd(y, x, _mm_set1_ps(5.0000001201e-1f));
+    y = madd(y, _mm_mul_ps(x, x), _mm_add_ps(x, _mm_set1_ps(1.0f)));
+
+    const __m128i e =
+      _mm_add_epi32(_mm_cvttps_epi32(n), _mm_set1_epi32(127));
+    return _mm_mul_ps(y, _mm_castsi128_ps(_mm_slli_epi32(e, 23)));
+  }
+  // lanes of v whose bit in bits is set, zero elsewhere
+  static CNN_MUST_INLINE register_type select(const register_type &v,
+                                              uint32_t bits) {
+    const __m128i lanes = _mm_and_si128(_mm_set1_epi32(int(bits)),
+                                        _mm_setr_epi32(1, 2, 4, 8));
+    const __m128 on = _mm_cmpneq_ps(_mm_cvtepi32_ps(lanes), _mm_setzero_ps());
+    return _mm_and_ps(v, on);
+  }
 
   template <typename aligned>
   static CNN_MUST_INLINE register_type load(const value_type *px);
@@ -143,6 +201,25 @@ struct double_sse {
                                             const register_type &v3) {
     return _mm_add_pd(_mm_mul_pd(v1, v2), v3);
   }
+  static CNN_MUST_INLINE register_type sub(const register_type &v1,
+                                           const register_type &v2) {
+    return _mm_sub_pd(v1, v2);
+  }
+  static CNN_MUST_INLINE register_type div(const register_type &v1,
+                                           const register_type &v2) {
+    return _mm_div_pd(v1, v2);
+  }
+  static CNN_MUST_INLINE register_type exp(const register_type &v) {
+    alignas(16) double tmp[2];
+    _mm_store_pd(tmp, v);
+    return _mm_set_pd(std::exp(tmp[1]), std::exp(tmp[0]));
+  }
+  static CNN_MUST_INLINE register_type select(const register_type &v,
+                                              uint32_t bits) {
+    const __m128i on = _mm_set_epi64x(-int64_t((bits >> 1) & 1),
+                                      -int64_t(bits & 1));
+    return _mm_and_pd(v, _mm_castsi128_pd(on));
+  }
 
   template <typename aligned>
   static CNN_MUST_INLINE register_type load(const value_type *px);
@@ -214,6 +291,58 @@ struct float_avx {
     return _mm256_add_ps(_mm256_mul_ps(v1, v2), v3);
   }
 #endif
+  static CNN_MUST_INLINE register_type sub(const register_type &v1,
+                                           const register_type &v2) {
+    return _mm256_sub_ps(v1, v2);
+  }
+  static CNN_MUST_INLINE register_type div(const register_type &v1,
+                                           const register_type &v2) {
+    return _mm256_div_ps(v1, v2);
+  }
+  // float_sse::exp on eight lanes
+  static CNN_MUST_INLINE register_type exp(const register_type &v) {
+    __m256 x = _mm256_min_ps(
+      _mm256_max_ps(v, _mm256_set1_ps(-88.3762626647949f)),
+      _mm256_set1_ps(88.3762626647949f));
+    const __m256 n = _mm256_floor_ps(
+      _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)),
+                    _mm256_set1_ps(0.5f)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(0.693359375f)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(-2.12194440e-4f)));
+
+    __m256 y = _mm256_set1_ps(1.9875691500e-4f);
+    y        = madd(y, x, _mm256_set1_ps(1.3981999507e-3f));
+    y        = madd(y, x, _mm256_set1_ps(8.3334519073e-3f));
+    y        = madd(y, x, _mm256_set1_ps(4.1665795894e-2f));
+    y        = madd(y, x, _mm256_set1_ps(1.6666665459e-1f));
+    y        = madd(y, x, _mm256_set1_ps(5.0000001201e-1f));
+    y = madd(y, _mm256_mul_ps(x, x), _mm256_add_ps(x, _mm256_set1_ps(1.0f)));
+
+#ifdef CNN_USE_AVX2
+    const __m256i e = _mm256_slli_epi32(
+      _mm256_add_epi32(_mm256_cvttps_epi32(n), _mm256_set1_epi32(127)), 23);
+#else
+    // no 256-bit integer arithmetic before AVX2
+    const __m256i i  = _mm256_cvttps_epi32(n);
+    const __m128i lo = _mm_slli_epi32(
+      _mm_add_epi32(_mm256_castsi256_si128(i), _mm_set1_epi32(127)), 23);
+    const __m128i hi = _mm_slli_epi32(
+      _mm_add_epi32(_mm256_extractf128_si256(i, 1), _mm_set1_epi32(127)), 23);
+    const __m256i e =
+      _mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1);
+#endif
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(e));
+  }
+  static CNN_MUST_INLINE register_type select(const register_type &v,
+                                              uint32_t bits) {
+    const __m256 lanes = _mm256_and_ps(
+      _mm256_castsi256_ps(_mm256_set1_epi32(int(bits))),
+      _mm256_castsi256_ps(_mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128)));
+    const __m256 on =
+      _mm256_cmp_ps(_mm256_cvtepi32_ps(_mm256_castps_si256(lanes)),
+                    _mm256_setzero_ps(), _CMP_NEQ_OQ);
+    return _mm256_and_ps(v, on);
+  }
 
   template <typename aligned>
   static CNN_MUST_INLINE register_type load(const value_type *px);
@@ -278,6 +407,27 @@ struct double_avx {
     return _mm256_add_pd(_mm256_mul_pd(v1, v2), v3);
   }
 #endif
+  static CNN_MUST_INLINE register_type sub(const register_type &v1,
+                                           const register_type &v2) {
+    return _mm256_sub_pd(v1, v2);
+  }
+  static CNN_MUST_INLINE register_type div(const register_type &v1,
+                                           const register_type &v2) {
+    return _mm256_div_pd(v1, v2);
+  }
+  static CNN_MUST_INLINE register_type exp(const register_type &v) {
+    alignas(32) double tmp[4];
+    _mm256_store_pd(tmp, v);
+    return _mm256_set_pd(std::exp(tmp[3]), std::exp(tmp[2]),
+                         std::exp(tmp[1]), std::exp(tmp[0]));
+  }
+  static CNN_MUST_INLINE register_type select(const register_type &v,
+                                              uint32_t bits) {
+    const __m256i on = _mm256_setr_epi64x(
+      -int64_t(bits & 1), -int64_t((bits >> 1) & 1),
+      -int64_t((bits >> 2) & 1), -int64_t((bits >> 3) & 1));
+    return _mm256_and_pd(v, _mm256_castsi256_pd(on));
+  }
 
   template <typename aligned>
   static CNN_MUST_INLINE register_type load(const value_type *px);
@@ -532,6 +682,77 @@ CNN_MUST_INLINE void reduce(const typename T::value_type *src,
   }
 }
 
+template <typename T, typename src_aligned, typename dst_aligned>
+CNN_MUST_INLINE void masked_scale(const typename T::value_type *src,
+                                  const uint32_t *mask,
+                                  typename T::value_type c,
+                                  std::size_t size,
+                                  typename T::value_type *dst) {
+  auto factor = T::set1(c);
+  auto sz     = T::unroll_size;
+  auto n1     = size / sz;
+  auto remain = size % sz;
+  // unroll_size divides 32, so the bits of a register never straddle words
+  const uint32_t lanes = (uint32_t(1) << sz) - 1;
+  for (size_t i = 0; i < n1; ++i) {
+    const size_t idx    = i * sz;
+    const uint32_t bits = (mask[idx / 32] >> (idx % 32)) & lanes;
+    auto s              = T::template load<src_aligned>(&src[idx]);
+    s                   = T::select(T::mul(s, factor), bits);
+    T::template store<dst_aligned>(&dst[idx], s);
+  }
+  for (size_t i = n1 * sz; i < n1 * sz + remain; ++i) {
+    dst[i] = ((mask[i / 32] >> (i % 32)) & 1) ? c * src[i] : 0;
+  }
+}
+
+// dst[i] = f(src[i]), f mapping a register to a register; the tail goes
+// through a register as well, so that every element gets the same rounding
+template <typename T, typename src_aligned, typename dst_aligned, typename F>
+CNN_MUST_INLINE void map(const typename T::value_type *src,
+                         std::size_t size,
+                         typename T::value_type *dst,
+                         F f) {
+  auto sz     = T::unroll_size;
+  auto n1     = size / sz;
+  auto remain = size % sz;
+  for (size_t i = 0; i < n1; ++i) {
+    auto s = T::template load<src_aligned>(&src[i * sz]);
+    T::template store<dst_aligned>(&dst[i * sz], f(s));
+  }
+  if (remain) {
+    alignas(32) typename T::value_type tmp[T::unroll_size] = {};
+    std::copy(&src[n1 * sz], &src[n1 * sz] + remain, tmp);
+    T::template store<std::true_type>(
+      tmp, f(T::template load<std::true_type>(tmp)));
+    std::copy(tmp, tmp + remain, &dst[n1 * sz]);
+  }
+}
+
+template <typename T, typename src_aligned, typename dst_aligned>
+CNN_MUST_INLINE void sigmoid(const typename T::value_type *src,
+                             std::size_t size,
+                             typename T::value_type *dst) {
+  const auto one = T::set1(1);
+  map<T, src_aligned, dst_aligned>(
+    src, size, dst, [&](const typename T::register_type &x) {
+      return T::div(one, T::add(one, T::exp(T::sub(T::zero(), x))));
+    });
+}
+
+// tanh(x) = 1 - 2 / (1 + exp(2x)), the clamped exp keeping it finite
+template <typename T, typename src_aligned, typename dst_aligned>
+CNN_MUST_INLINE void tanh(const typename T::value_type *src,
+                          std::size_t size,
+                          typename T::value_type *dst) {
+  const auto one = T::set1(1);
+  const auto two = T::set1(2);
+  map<T, src_aligned, dst_aligned>(
+    src, size, dst, [&](const typename T::register_type &x) {
+      return T::sub(one, T::div(two, T::add(one, T::exp(T::mul(two, x)))));
+    });
+}
+
 template <typename T>
 void fill(T *dst, size_t size, T value) {
   std::fill(dst, dst + size, value);
@@ -735,6 +956,88 @@ void reduce(const T *src, std::size_t size, T *dst) {
   }
 }
 
+/// dst[i] = c * src[i] where bit i of the packed mask is set, 0 elsewhere
+template <typename T>
+void masked_scale(const T *src,
+                  const uint32_t *mask,
+                  T c,
+                  std::size_t size,
+                  T *dst) {
+  bool src_aligned =
+    CNN_VECTORIZE_TYPE::is_aligned((CNN_VECTORIZE_TYPE::value_type *)src);
+  bool dst_aligned =
+    CNN_VECTORIZE_TYPE::is_aligned((CNN_VECTORIZE_TYPE::value_type *)dst);
+  if (src_aligned) {
+    if (dst_aligned) {
+      detail::masked_scale<CNN_VECTORIZE_TYPE, std::true_type, std::true_type>(
+        src, mask, c, size, dst);
+    } else {
+      detail::masked_scale<CNN_VECTORIZE_TYPE, std::true_type,
+                           std::false_type>(src, mask, c, size, dst);
+    }
+  } else {
+    if (dst_aligned) {
+      detail::masked_scale<CNN_VECTORIZE_TYPE, std::false_type,
+                           std::true_type>(src, mask, c, size, dst);
+    } else {
+      detail::masked_scale<CNN_VECTORIZE_TYPE, std::false_type,
+                           std::false_type>(src, mask, c, size, dst);
+    }
+  }
+}
+
+/// dst[i] = 1 / (1 + exp(-src[i])), within a few ulps of std::exp
+template <typename T>
+void sigmoid(const T *src, std::size_t size, T *dst) {
+  bool src_aligned =
+    CNN_VECTORIZE_TYPE::is_aligned((CNN_VECTORIZE_TYPE::value_type *)src);
+  bool dst_aligned =
+    CNN_VECTORIZE_TYPE::is_aligned((CNN_VECTORIZE_TYPE::value_type *)dst);
+  if (src_aligned) {
+    if (dst_aligned) {
+      detail::sigmoid<CNN_VECTORIZE_TYPE, std::true_type, std::true_type>(
+        src, size, dst);
+    } else {
+      detail::sigmoid<CNN_VECTORIZE_TYPE, std::true_type, std::false_type>(
+        src, size, dst);
+    }
+  } else {
+    if (dst_aligned) {
+      detail::sigmoid<CNN_VECTORIZE_TYPE, std::false_type, std::true_type>(
+        src, size, dst);
+    } else {
+      detail::sigmoid<CNN_VECTORIZE_TYPE, std::false_type, std::false_type>(
+        src, size, dst);
+    }
+  }
+}
+
+/// dst[i] = tanh(src[i]), within about 1e-7 of std::tanh
+template <typename T>
+void tanh(const T *src, std::size_t size, T *dst) {
+  bool src_aligned =
+    CNN_VECTORIZE_TYPE::is_aligned((CNN_VECTORIZE_TYPE::value_type *)src);
+  bool dst_aligned =
+    CNN_VECTORIZE_TYPE::is_aligned((CNN_VECTORIZE_TYPE::value_type *)dst);
+  if (src_aligned) {
+    if (dst_aligned) {
+      detail::tanh<CNN_VECTORIZE_TYPE, std::true_type, std::true_type>(
+        src, size, dst);
+    } else {
+      detail::tanh<CNN_VECTORIZE_TYPE, std::true_type, std::false_type>(
+        src, size, dst);
+    }
+  } else {
+    if (dst_aligned) {
+      detail::tanh<CNN_VECTORIZE_TYPE, std::false_type, std::true_type>(
+        src, size, dst);
+    } else {
+      detail::tanh<CNN_VECTORIZE_TYPE, std::false_type, std::false_type>(
+        src, size, dst);
+    }
+  }
+}
+
 template <typename T>
 CNN_MUST_INLINE void fill(T *dst, std::size_t size, T value) {
 #if defined(_MSC_VER)
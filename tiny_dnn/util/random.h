@@ -7,6 +7,11 @@
 */
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
 #include <limits>
 #include <random>
 #include <type_traits>
@@ -25,13 +30,118 @@ class random_generator {
 
   std::mt19937 &operator()() { return gen_; }
 
-  void set_seed(unsigned int seed) { gen_.seed(seed); }
+  void set_seed(unsigned int seed) {
+    gen_.seed(seed);
+    seed_   = seed;
+    stream_ = 0;
+  }
+
+  unsigned int seed() const { return seed_; }
+
+  // id of a new philox_stream, numbered from 0 again at every set_seed();
+  // distinct ids however many threads create streams at once
+  uint32_t next_stream() { return stream_.fetch_add(1); }
 
  private:
   // avoid gen_(0) for MSVC known issue
   // https://connect.microsoft.com/VisualStudio/feedback/details/776456
-  random_generator() : gen_(1) {}
+  random_generator() : gen_(1), seed_(1), stream_(0) {}
   std::mt19937 gen_;
+  unsigned int seed_;
+  std::atomic<uint32_t> stream_;
+};
+
+/**
+ * Counter-based random numbers (Philox4x32-10).
+ *
+ * J K Salmon, M A Moraes, R O Dror, D E Shaw,
+ * Parallel random numbers: as easy as 1, 2, 3
+ * Proc. SC11, 2011
+ *
+ * Every block of four 32-bit values is a pure function of the key of the
+ * stream and of a counter, so that a value is addressed by its indices
+ * (e.g. sample and element) instead of being drawn in sequence: any part of
+ * a stream can be generated from any thread, in any order, with the same
+ * result whatever the number of threads.
+ **/
+class philox_stream {
+ public:
+  typedef std::array<uint32_t, 4> block;
+
+  philox_stream(uint32_t seed, uint32_t stream) : key0_(seed), key1_(stream) {}
+
+  // a new stream keyed by the global seed (see set_random_seed)
+  philox_stream()
+    : philox_stream(random_generator::get_instance().seed(),
+                    random_generator::get_instance().next_stream()) {}
+
+  block operator()(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3) const {
+    block c       = {{c0, c1, c2, c3}};
+    uint32_t key0 = key0_, key1 = key1_;
+    for (int round = 0; round < 10; round++) {
+      const uint64_t p0 = uint64_t(0xD2511F53) * c[0];
+      const uint64_t p1 = uint64_t(0xCD9E8D57) * c[2];
+      c = {{uint32_t(p1 >> 32) ^ c[1] ^ key0, uint32_t(p1),
+            uint32_t(p0 >> 32) ^ c[3] ^ key1, uint32_t(p0)}};
+      key0 += 0x9E3779B9;
+      key1 += 0xBB67AE85;
+    }
+    return c;
+  }
+
+  // element e of row (i, j): word e % 4 of block (e / 4, i, j, 0)
+  block row_block(uint32_t i, uint32_t j, size_t e) const {
+    return (*this)(static_cast<uint32_t>(e / 4), i, j, 0);
+  }
+
+  /**
+   * uniform values in [0, 1) of elements [first, first + n) of row (i, j)
+   **/
+  template <typename T>
+  void uniform(uint32_t i, uint32_t j, size_t first, size_t n, T *dst) const {
+    block b = row_block(i, j, first);
+    for (size_t e = first; e < first + n; e++) {
+      if (e % 4 == 0) b = row_block(i, j, e);
+      dst[e - first] = to_unit<T>(b[e % 4]);
+    }
+  }
+
+  /**
+   * bits of elements [0, n) of row (i, j), packed 32 to a word, element e
+   * being set iff to_unit() of its draw is <= p; compared as integers, a
+   * word costs eight blocks and no conversion to floating point
+   **/
+  void bernoulli(uint32_t i,
+                 uint32_t j,
+                 size_t n,
+                 double p,
+                 uint32_t *dst) const {
+    // to_unit(x) <= p  <=>  (x >> 8) <= p * 2^24, both sides being scaled
+    // by a power of two
+    const int64_t threshold =
+      p < 0 ? -1 : int64_t(std::floor(std::min(p, 1.0) * 16777216.0));
+    for (size_t w = 0; w < (n + 31) / 32; w++) {
+      uint32_t word = 0;
+      for (size_t e = w * 32; e < std::min(n, w * 32 + 32); e += 4) {
+        const block b = row_block(i, j, e);
+        for (size_t k = 0; k < 4 && e + k < n; k++) {
+          const bool on = int64_t(b[k] >> 8) <= threshold;
+          word |= uint32_t(on) << ((e + k) % 32);
+        }
+      }
+      dst[w] = word;
+    }
+  }
+
+  // [0, 1) from the upper 24 bits, exact in single precision
+  template <typename T>
+  static T to_unit(uint32_t x) {
+    return T(x >> 8) * (T(1) / T(16777216));
+  }
+
+ private:
+  uint32_t key0_;
+  uint32_t key1_;
 };
 
 template <typename T>
@@ -0,0 +1,153 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "tiny_dnn/util/aligned_allocator.h"
+
+namespace tiny_dnn {
+
+/**
+ * Bump allocator for the temporaries of a kernel call.
+ *
+ * Allocating moves a pointer forward in a block; everything allocated since
+ * a mark is freed at once by rewinding to it (see scratch_scope). Blocks are
+ * only added when the current ones are full, and are merged into one when
+ * the arena is empty again, so that once the largest call has run, later
+ * calls allocate nothing from the heap.
+ *
+ * Each thread has its own arena (see local()), no locking is involved.
+ **/
+class scratch_arena {
+ public:
+  static constexpr size_t alignment = 64;
+
+  struct position {
+    size_t block  = 0;
+    size_t offset = 0;
+  };
+
+  // the arena of the calling thread
+  static scratch_arena &local() {
+    thread_local scratch_arena arena;
+    return arena;
+  }
+
+  void *allocate(size_t bytes) {
+    bytes = (bytes + alignment - 1) / alignment * alignment;
+    while (top_.block < blocks_.size() &&
+           blocks_[top_.block].size() - top_.offset < bytes) {
+      top_.block++;
+      top_.offset = 0;
+    }
+    if (top_.block == blocks_.size()) {
+      blocks_.emplace_back(std::max({bytes, capacity(), size_t(min_block)}));
+    }
+    void *p = blocks_[top_.block].data() + top_.offset;
+    top_.offset += bytes;
+    return p;
+  }
+
+  template <typename T>
+  T *allocate(size_t n) {
+    return static_cast<T *>(allocate(n * sizeof(T)));
+  }
+
+  position mark() const { return top_; }
+
+  /**
+   * free everything allocated since the mark was taken
+   **/
+  void rewind(position mark) {
+    top_ = mark;
+    if (top_.block == 0 && top_.offset == 0 && blocks_.size() > 1) {
+      const size_t size = capacity();
+      blocks_.clear();
+      blocks_.emplace_back(size);
+    }
+  }
+
+  void reset() { rewind(position()); }
+
+  // bytes held by the arena, in use or not
+  size_t capacity() const {
+    size_t size = 0;
+    for (const auto &b : blocks_) size += b.size();
+    return size;
+  }
+
+ private:
+  static constexpr size_t min_block = 4096;
+
+  std::vector<std::vector<char, aligned_allocator<char, alignment>>> blocks_;
+  position top_;
+};
+
+/**
+ * temporaries of the current thread's arena, freed when the scope ends
+ *
+ *     scratch_scope scratch;
+ *     float_t *tmp = scratch.allocate<float_t>(n);
+ **/
+class scratch_scope {
+ public:
+  scratch_scope() : arena_(scratch_arena::local()), mark_(arena_.mark()) {}
+
+  scratch_scope(const scratch_scope &) = delete;
+  scratch_scope &operator=(const scratch_scope &) = delete;
+
+  ~scratch_scope() { arena_.rewind(mark_); }
+
+  template <typename T>
+  T *allocate(size_t n) {
+    return arena_.allocate<T>(n);
+  }
+
+ private:
+  scratch_arena &arena_;
+  scratch_arena::position mark_;
+};
+
+/**
+ * allocator drawing from the arena of the current thread, for standard
+ * containers used within a scratch_scope; deallocating is left to the scope
+ **/
+template <typename T>
+class scratch_allocator {
+ public:
+  typedef T value_type;
+
+  scratch_allocator() = default;
+
+  template <typename U>
+  scratch_allocator(const scratch_allocator<U> &) {}  // NOLINT
+
+  T *allocate(size_t n) { return scratch_arena::local().allocate<T>(n); }
+
+  void deallocate(T *, size_t) {}
+};
+
+template <typename T, typename U>
+inline bool operator==(const scratch_allocator<T> &,
+                       const scratch_allocator<U> &) {
+  return true;
+}
+
+template <typename T, typename U>
+inline bool operator!=(const scratch_allocator<T> &,
+                       const scratch_allocator<U> &) {
+  return false;
+}
+
+template <typename T>
+using scratch_vector = std::vector<T, scratch_allocator<T>>;
+
+}  // namespace tiny_dnn
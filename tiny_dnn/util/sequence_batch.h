@@ -0,0 +1,107 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "tiny_dnn/util/nn_error.h"
+
+namespace tiny_dnn {
+
+/**
+ * Lengths of the sequences of a batch, every sample being padded to the
+ * same number of steps.
+ *
+ * The steps actually present are packed time-major with the samples sorted
+ * by decreasing length, so that the sequences still running at step t are
+ * the first active(t) ones: the packed rows offset(t) .. offset(t) +
+ * active(t) - 1 are step t of the samples of rank 0 .. active(t) - 1, and
+ * the batch shrinks as sequences finish. A batch without padding packs as
+ * rows r = t * batch_size() + sample.
+ **/
+class sequence_batch {
+ public:
+  sequence_batch() : steps_(0), offset_(1, 0) {}
+
+  /**
+   * @param lengths [in] number of steps of every sample
+   * @param steps   [in] number of steps every sample is padded to
+   **/
+  sequence_batch(const std::vector<size_t> &lengths, size_t steps)
+    : lengths_(lengths), steps_(steps) {
+    for (auto l : lengths_) {
+      if (l > steps_) throw nn_error("sequence longer than the padded steps");
+    }
+
+    order_.resize(lengths_.size());
+    std::iota(order_.begin(), order_.end(), size_t(0));
+    std::stable_sort(order_.begin(), order_.end(), [&](size_t a, size_t b) {
+      return lengths_[a] > lengths_[b];
+    });
+
+    active_.assign(steps_, 0);
+    offset_.assign(steps_ + 1, 0);
+    for (size_t t = 0; t < steps_; t++) {
+      while (active_[t] < order_.size() && lengths_[order_[active_[t]]] > t) {
+        active_[t]++;
+      }
+      offset_[t + 1] = offset_[t] + active_[t];
+    }
+
+    packed_step_.resize(packed_size());
+    packed_rank_.resize(packed_size());
+    for (size_t t = 0; t < steps_; t++) {
+      for (size_t k = 0; k < active_[t]; k++) {
+        packed_step_[offset_[t] + k] = t;
+        packed_rank_[offset_[t] + k] = k;
+      }
+    }
+  }
+
+  // a batch of sequences without padding
+  static sequence_batch full(size_t batch_size, size_t steps) {
+    return sequence_batch(std::vector<size_t>(batch_size, steps), steps);
+  }
+
+  bool empty() const { return lengths_.empty(); }
+
+  size_t batch_size() const { return lengths_.size(); }
+
+  size_t steps() const { return steps_; }
+
+  const std::vector<size_t> &lengths() const { return lengths_; }
+
+  // sample of the given rank, ranked by decreasing length
+  size_t sample(size_t rank) const { return order_[rank]; }
+
+  // number of sequences still running at step t
+  size_t active(size_t t) const { return active_[t]; }
+
+  // first packed row of step t
+  size_t offset(size_t t) const { return offset_[t]; }
+
+  // number of steps actually present in the batch
+  size_t packed_size() const { return offset_[steps_]; }
+
+  size_t packed_step(size_t row) const { return packed_step_[row]; }
+
+  size_t packed_rank(size_t row) const { return packed_rank_[row]; }
+
+ private:
+  std::vector<size_t> lengths_;
+  size_t steps_;
+  std::vector<size_t> order_;
+  std::vector<size_t> active_;
+  std::vector<size_t> offset_;
+  std::vector<size_t> packed_step_;
+  std::vector<size_t> packed_rank_;
+};
+
+}  // namespace tiny_dnn
@@ -7,6 +7,7 @@
 */
 #pragma once
 
+#include <cstring>
 #include <string>
 #include <utility>
 #include <vector>
@@ -71,6 +72,103 @@ inline void arc(Archive &ar, Type &&arg, Types &&... args) {
   arc(ar, std::forward<Types>(args)...);
 }
 
+/**
+ * quantization settings saved after the other fields of the convolutional,
+ * deconvolutional and fully-connected layers, float and quantized alike, so
+ * that one can be loaded as the other (see convert_layer). Their version:
+ * 1: calibrated input/output ranges
+ * 2: int8 input/output
+ * 3: fake quantization state of the float layers (unused by the others)
+ **/
+constexpr std::uint32_t quantization_version = 3;
+
+struct quantization_fields {
+  tiny_dnn::core::quantization_range in_range;
+  tiny_dnn::core::quantization_range out_range;
+  bool int8_input  = false;
+  bool int8_output = false;
+  tiny_dnn::core::fake_quantization_params fake;
+};
+
+inline quantization_fields quantization_of(
+  const tiny_dnn::core::conv_params &params) {
+  quantization_fields q;
+  q.in_range    = params.in_range;
+  q.out_range   = params.out_range;
+  q.int8_input  = params.int8_input;
+  q.int8_output = params.int8_output;
+  return q;
+}
+
+inline quantization_fields quantization_of(
+  const tiny_dnn::core::deconv_params &params) {
+  quantization_fields q;
+  q.in_range    = params.in_range;
+  q.out_range   = params.out_range;
+  q.int8_input  = params.int8_input;
+  q.int8_output = params.int8_output;
+  return q;
+}
+
+inline quantization_fields quantization_of(
+  const tiny_dnn::core::fully_params &params) {
+  quantization_fields q;
+  q.in_range    = params.in_range_;
+  q.out_range   = params.out_range_;
+  q.int8_input  = params.int8_input_;
+  q.int8_output = params.int8_output_;
+  return q;
+}
+
+template <class Archive>
+void save_quantization(Archive &ar, quantization_fields q) {
+  std::uint32_t version = quantization_version;
+  arc(ar, make_nvp("quantization_version", version),
+      make_nvp("in_range", q.in_range), make_nvp("out_range", q.out_range),
+      make_nvp("int8_input", q.int8_input),
+      make_nvp("int8_output", q.int8_output),
+      make_nvp("fake_quantization", q.fake));
+}
+
+template <class Archive>
+std::uint32_t load_quantization_version(Archive &ar) {
+  std::uint32_t version;
+  arc(ar, make_nvp("quantization_version", version));
+  return version;
+}
+
+// a json file written before the quantization fields doesn't have them
+inline std::uint32_t load_quantization_version(cereal::JSONInputArchive &ar) {
+  const char *next = ar.getNodeName();
+  if (!next || std::strcmp(next, "quantization_version") != 0) return 0;
+  std::uint32_t version;
+  arc(ar, make_nvp("quantization_version", version));
+  return version;
+}
+
+/**
+ * the fields saved by save_quantization, defaults (ranges computed at every
+ * forward) for those missing from an older file
+ **/
+template <class Archive>
+quantization_fields load_quantization(Archive &ar) {
+  quantization_fields q;
+  const std::uint32_t version = load_quantization_version(ar);
+  if (version > quantization_version) {
+    throw tiny_dnn::nn_error("unsupported version of quantization fields");
+  }
+  if (version >= 1) {
+    arc(ar, make_nvp("in_range", q.in_range),
+        make_nvp("out_range", q.out_range));
+  }
+  if (version >= 2) {
+    arc(ar, make_nvp("int8_input", q.int8_input),
+        make_nvp("int8_output", q.int8_output));
+  }
+  if (version >= 3) arc(ar, make_nvp("fake_quantization", q.fake));
+  return q;
+}
+
 }  // namespace detail
 
 namespace cereal {
@@ -184,6 +282,9 @@ struct LoadAndConstruct<tiny_dnn::convolutional_layer> {
 
     construct(in.width_, in.height_, w_width, w_height, in.depth_, out_ch, tbl,
               pad_type, has_bias, w_stride, h_stride);
+    const auto q = ::detail::load_quantization(ar);
+    if (q.fake.enabled) construct->enable_fake_quantization(q.fake.momentum);
+    construct->set_quantization_ranges(q.fake.in_range, q.fake.out_range);
   }
 };
 
@@ -211,6 +312,21 @@ struct LoadAndConstruct<tiny_dnn::deconvolutional_layer> {
 
     construct(in.width_, in.height_, w_width, w_height, in.depth_, out_ch, tbl,
               pad_type, has_bias, w_stride, h_stride);
+    ::detail::load_quantization(ar);  // unused by the float layer
+  }
+};
+
+template <>
+struct LoadAndConstruct<tiny_dnn::dequantize_layer> {
+  template <class Archive>
+  static void load_and_construct(
+    Archive &ar, cereal::construct<tiny_dnn::dequantize_layer> &construct) {
+    tiny_dnn::shape3d in_shape;
+    tiny_dnn::core::quantization_range range;
+
+    ::detail::arc(ar, ::detail::make_nvp("in_size", in_shape),
+                  ::detail::make_nvp("range", range));
+    construct(in_shape, range);
   }
 };
 
@@ -243,6 +359,9 @@ struct LoadAndConstruct<tiny_dnn::fully_connected_layer> {
                   ::detail::make_nvp("out_size", out_dim),
                   ::detail::make_nvp("has_bias", has_bias));
     construct(in_dim, out_dim, has_bias);
+    const auto q = ::detail::load_quantization(ar);
+    if (q.fake.enabled) construct->enable_fake_quantization(q.fake.momentum);
+    construct->set_quantization_ranges(q.fake.in_range, q.fake.out_range);
   }
 };
 
@@ -305,6 +424,21 @@ struct LoadAndConstruct<tiny_dnn::lrn_layer> {
   }
 };
 
+template <>
+struct LoadAndConstruct<tiny_dnn::lstm_cell_layer> {
+  template <class Archive>
+  static void load_and_construct(
+    Archive &ar, cereal::construct<tiny_dnn::lstm_cell_layer> &construct) {
+    size_t in_dim, out_dim;
+    bool has_bias;
+
+    ::detail::arc(ar, ::detail::make_nvp("in_size", in_dim),
+                  ::detail::make_nvp("out_size", out_dim),
+                  ::detail::make_nvp("has_bias", has_bias));
+    construct(in_dim, out_dim, has_bias);
+  }
+};
+
 template <>
 struct LoadAndConstruct<tiny_dnn::max_pooling_layer> {
   template <class Archive>
@@ -356,6 +490,37 @@ struct LoadAndConstruct<tiny_dnn::power_layer> {
   }
 };
 
+template <>
+struct LoadAndConstruct<tiny_dnn::quantize_layer> {
+  template <class Archive>
+  static void load_and_construct(
+    Archive &ar, cereal::construct<tiny_dnn::quantize_layer> &construct) {
+    tiny_dnn::shape3d in_shape;
+    tiny_dnn::core::quantization_range range;
+
+    ::detail::arc(ar, ::detail::make_nvp("in_size", in_shape),
+                  ::detail::make_nvp("range", range));
+    construct(in_shape, range);
+  }
+};
+
+template <>
+struct LoadAndConstruct<tiny_dnn::quantized_concat_layer> {
+  template <class Archive>
+  static void load_and_construct(
+    Archive &ar,
+    cereal::construct<tiny_dnn::quantized_concat_layer> &construct) {
+    std::vector<tiny_dnn::shape3d> in_shapes;
+    std::vector<tiny_dnn::core::quantization_range> in_ranges;
+    tiny_dnn::core::quantization_range out_range;
+
+    ::detail::arc(ar, ::detail::make_nvp("in_size", in_shapes),
+                  ::detail::make_nvp("in_ranges", in_ranges),
+                  ::detail::make_nvp("out_range", out_range));
+    construct(in_shapes, in_ranges, out_range);
+  }
+};
+
 template <>
 struct LoadAndConstruct<tiny_dnn::quantized_convolutional_layer> {
   template <class Archive>
@@ -380,6 +545,9 @@ struct LoadAndConstruct<tiny_dnn::quantized_convolutional_layer> {
 
     construct(in.width_, in.height_, w_width, w_height, in.depth_, out_ch, tbl,
               pad_type, has_bias, w_stride, h_stride);
+    const auto q = ::detail::load_quantization(ar);
+    construct->set_quantization_ranges(q.in_range, q.out_range);
+    construct->set_int8_io(q.int8_input, q.int8_output);
   }
 };
 
@@ -407,6 +575,9 @@ struct LoadAndConstruct<tiny_dnn::quantized_deconvolutional_layer> {
 
     construct(in.width_, in.height_, w_width, w_height, in.depth_, out_ch, tbl,
               pad_type, has_bias, w_stride, h_stride);
+    const auto q = ::detail::load_quantization(ar);
+    construct->set_quantization_ranges(q.in_range, q.out_range);
+    construct->set_int8_io(q.int8_input, q.int8_output);
   }
 };
 
@@ -423,6 +594,24 @@ struct LoadAndConstruct<tiny_dnn::quantized_fully_connected_layer> {
                   ::detail::make_nvp("out_size", out_dim),
                   ::detail::make_nvp("has_bias", has_bias));
     construct(in_dim, out_dim, has_bias);
+    const auto q = ::detail::load_quantization(ar);
+    construct->set_quantization_ranges(q.in_range, q.out_range);
+    construct->set_int8_io(q.int8_input, q.int8_output);
+  }
+};
+
+template <>
+struct LoadAndConstruct<tiny_dnn::quantized_relu_layer> {
+  template <class Archive>
+  static void load_and_construct(
+    Archive &ar,
+    cereal::construct<tiny_dnn::quantized_relu_layer> &construct) {
+    tiny_dnn::shape3d in_shape;
+    tiny_dnn::core::quantization_range range;
+
+    ::detail::arc(ar, ::detail::make_nvp("in_size", in_shape),
+                  ::detail::make_nvp("range", range));
+    construct(in_shape, range);
   }
 };
 
@@ -446,6 +635,29 @@ struct LoadAndConstruct<tiny_dnn::recurrent_cell_layer> {
   }
 };
 
+template <>
+struct LoadAndConstruct<tiny_dnn::recurrent_layer> {
+  template <class Archive>
+  static void load_and_construct(
+    Archive &ar, cereal::construct<tiny_dnn::recurrent_layer> &construct) {
+    size_t in_dim, out_dim, seq_len, bptt;
+    bool has_bias;
+
+    ::detail::arc(ar, ::detail::make_nvp("in_size", in_dim),
+                  ::detail::make_nvp("out_size", out_dim),
+                  ::detail::make_nvp("seq_len", seq_len),
+                  ::detail::make_nvp("bptt", bptt),
+                  ::detail::make_nvp("has_bias", has_bias));
+    auto al = tiny_dnn::layer::load_layer(ar);
+    // a nullptr is passed to avoid creating unused activation layer.
+    construct(in_dim, out_dim, seq_len, has_bias, nullptr);
+    construct->set_bptt(bptt);
+    // set the activation to the loaded value
+    construct->set_activation(
+      std::static_pointer_cast<tiny_dnn::activation_layer>(al));
+  }
+};
+
 template <>
 struct LoadAndConstruct<tiny_dnn::slice_layer> {
   template <class Archive>
@@ -665,6 +877,9 @@ struct serialization_buddy {
                   ::detail::make_nvp("has_bias", params_.has_bias),
                   ::detail::make_nvp("w_stride", params_.w_stride),
                   ::detail::make_nvp("h_stride", params_.h_stride));
+    auto q = ::detail::quantization_of(params_);
+    q.fake = layer.fake_quant_;
+    ::detail::save_quantization(ar, q);
   }
 
   template <class Archive>
@@ -680,6 +895,13 @@ struct serialization_buddy {
                   ::detail::make_nvp("has_bias", params_.has_bias),
                   ::detail::make_nvp("w_stride", params_.w_stride),
                   ::detail::make_nvp("h_stride", params_.h_stride));
+    ::detail::save_quantization(ar, ::detail::quantization_of(params_));
+  }
+
+  template <class Archive>
+  static inline void serialize(Archive &ar, tiny_dnn::dequantize_layer &layer) {
+    ::detail::arc(ar, ::detail::make_nvp("in_size", layer.in_shape_),
+                  ::detail::make_nvp("range", layer.range_));
   }
 
   template <class Archive>
@@ -696,6 +918,9 @@ struct serialization_buddy {
     ::detail::arc(ar, ::detail::make_nvp("in_size", params_.in_size_),
                   ::detail::make_nvp("out_size", params_.out_size_),
                   ::detail::make_nvp("has_bias", params_.has_bias_));
+    auto q = ::detail::quantization_of(params_);
+    q.fake = layer.fake_quant_;
+    ::detail::save_quantization(ar, q);
   }
 
   template <class Archive>
@@ -726,6 +951,14 @@ struct serialization_buddy {
                   ::detail::make_nvp("region", layer.region_));
   }
 
+  template <class Archive>
+  static inline void serialize(Archive &ar, tiny_dnn::lstm_cell_layer &layer) {
+    auto &params_ = layer.params_;
+    ::detail::arc(ar, ::detail::make_nvp("in_size", params_.in_size_),
+                  ::detail::make_nvp("out_size", params_.out_size_),
+                  ::detail::make_nvp("has_bias", params_.has_bias_));
+  }
+
   template <class Archive>
   static inline void serialize(Archive &ar,
                                tiny_dnn::max_pooling_layer &layer) {
@@ -753,6 +986,20 @@ struct serialization_buddy {
                   ::detail::make_nvp("scale", layer.scale_));
   }
 
+  template <class Archive>
+  static inline void serialize(Archive &ar, tiny_dnn::quantize_layer &layer) {
+    ::detail::arc(ar, ::detail::make_nvp("in_size", layer.in_shape_),
+                  ::detail::make_nvp("range", layer.range_));
+  }
+
+  template <class Archive>
+  static inline void serialize(Archive &ar,
+                               tiny_dnn::quantized_concat_layer &layer) {
+    ::detail::arc(ar, ::detail::make_nvp("in_size", layer.in_shapes_),
+                  ::detail::make_nvp("in_ranges", layer.in_ranges_),
+                  ::detail::make_nvp("out_range", layer.out_range_));
+  }
+
   template <class Archive>
   static inline void serialize(Archive &ar,
                                tiny_dnn::quantized_convolutional_layer &layer) {
@@ -766,6 +1013,7 @@ struct serialization_buddy {
                   ::detail::make_nvp("has_bias", params_.has_bias),
                   ::detail::make_nvp("w_stride", params_.w_stride),
                   ::detail::make_nvp("h_stride", params_.h_stride));
+    ::detail::save_quantization(ar, ::detail::quantization_of(params_));
   }
 
   template <class Archive>
@@ -781,6 +1029,7 @@ struct serialization_buddy {
                   ::detail::make_nvp("has_bias", params_.has_bias),
                   ::detail::make_nvp("w_stride", params_.w_stride),
                   ::detail::make_nvp("h_stride", params_.h_stride));
+    ::detail::save_quantization(ar, ::detail::quantization_of(params_));
   }
 
   template <class Archive>
@@ -790,6 +1039,14 @@ struct serialization_buddy {
     ::detail::arc(ar, ::detail::make_nvp("in_size", params_.in_size_),
                   ::detail::make_nvp("out_size", params_.out_size_),
                   ::detail::make_nvp("has_bias", params_.has_bias_));
+    ::detail::save_quantization(ar, ::detail::quantization_of(params_));
+  }
+
+  template <class Archive>
+  static inline void serialize(Archive &ar,
+                               tiny_dnn::quantized_relu_layer &layer) {
+    ::detail::arc(ar, ::detail::make_nvp("in_size", layer.in_shape_),
+                  ::detail::make_nvp("range", layer.range_));
   }
 
   template <class Archive>
@@ -802,6 +1059,17 @@ struct serialization_buddy {
     tiny_dnn::layer::save_layer(ar, *params_.activation_);
   }
 
+  template <class Archive>
+  static inline void serialize(Archive &ar, tiny_dnn::recurrent_layer &layer) {
+    auto &params_ = layer.params_;
+    ::detail::arc(ar, ::detail::make_nvp("in_size", params_.in_size_),
+                  ::detail::make_nvp("out_size", params_.out_size_),
+                  ::detail::make_nvp("seq_len", params_.seq_len_),
+                  ::detail::make_nvp("bptt", params_.bptt_),
+                  ::detail::make_nvp("has_bias", params_.has_bias_));
+    tiny_dnn::layer::save_layer(ar, *params_.activation_);
+  }
+
   template <class Archive>
   static inline void serialize(Archive &ar, tiny_dnn::slice_layer &layer) {
     ::detail::arc(ar, ::detail::make_nvp("in_size", layer.in_shape_),
@@ -886,6 +1154,20 @@ void serialize(Archive &ar, tiny_dnn::index3d<T> &idx) {
 
 namespace core {
 
+template <class Archive>
+void serialize(Archive &ar, tiny_dnn::core::quantization_range &range) {
+  ::detail::arc(ar, ::detail::make_nvp("min", range.min),
+                ::detail::make_nvp("max", range.max));
+}
+
+template <class Archive>
+void serialize(Archive &ar, tiny_dnn::core::fake_quantization_params &fake) {
+  ::detail::arc(ar, ::detail::make_nvp("enabled", fake.enabled),
+                ::detail::make_nvp("momentum", fake.momentum),
+                ::detail::make_nvp("in_range", fake.in_range),
+                ::detail::make_nvp("out_range", fake.out_range));
+}
+
 template <class Archive>
 void serialize(Archive &ar, tiny_dnn::core::connection_table &tbl) {
   ::detail::arc(ar, ::detail::make_nvp("rows", tbl.rows_),
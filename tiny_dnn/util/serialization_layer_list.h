@@ -20,6 +20,7 @@ void register_layers(T* h) {
   h->template register_layer<concat_layer>("concat");
   h->template register_layer<convolutional_layer>("conv");
   h->template register_layer<deconvolutional_layer>("deconv");
+  h->template register_layer<dequantize_layer>("dequantize");
   h->template register_layer<dropout_layer>("dropout");
   h->template register_layer<fully_connected_layer>("fully_connected");
   h->template register_layer<global_average_pooling_layer>(
@@ -27,14 +28,19 @@ void register_layers(T* h) {
   h->template register_layer<input_layer>("input");
   h->template register_layer<linear_layer>("linear");
   h->template register_layer<lrn_layer>("lrn");
+  h->template register_layer<lstm_cell_layer>("lstm_cell");
   h->template register_layer<max_pooling_layer>("maxpool");
   h->template register_layer<max_unpooling_layer>("maxunpool");
   h->template register_layer<power_layer>("power");
+  h->template register_layer<quantize_layer>("quantize");
+  h->template register_layer<quantized_concat_layer>("q_concat");
   h->template register_layer<quantized_convolutional_layer>("q_conv");
   h->template register_layer<quantized_deconvolutional_layer>("q_deconv");
   h->template register_layer<quantized_fully_connected_layer>(
     "q_fully_connected");
+  h->template register_layer<quantized_relu_layer>("q_relu");
   h->template register_layer<recurrent_cell_layer>("recurrent_cell");
+  h->template register_layer<recurrent_layer>("recurrent");
   h->template register_layer<slice_layer>("slice");
 
   h->template register_layer<sigmoid_layer>("sigmoid");
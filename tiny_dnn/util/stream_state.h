@@ -0,0 +1,80 @@
+/*
+    Copyright (c) 2013, Taiga Nomi and the respective contributors
+    All rights reserved.
+
+    Use of this source code is governed by a BSD-style license that can be found
+    in the LICENSE file.
+*/
+#pragma once
+
+#include <iomanip>
+#include <limits>
+#include <vector>
+
+#include "tiny_dnn/util/util.h"
+
+namespace tiny_dnn {
+
+/**
+ * Recurrent state of one stream fed to a network one frame at a time.
+ *
+ * Holds a vector for every state channel of the network's layers (see
+ * layer::state_channels), in the order of the layers. A stream_state is
+ * created by network::create_stream_state() and advanced by network::step(),
+ * which stacks the states of many streams into a single batch.
+ **/
+class stream_state {
+ public:
+  stream_state() {}
+
+  explicit stream_state(const std::vector<size_t> &sizes) {
+    for (auto size : sizes) states_.emplace_back(size, float_t{0});
+  }
+
+  // back to the initial (zero) state, e.g. at the start of a new stream
+  void reset() {
+    for (auto &s : states_) std::fill(s.begin(), s.end(), float_t{0});
+  }
+
+  size_t size() const { return states_.size(); }
+
+  vec_t &operator[](size_t i) { return states_[i]; }
+
+  const vec_t &operator[](size_t i) const { return states_[i]; }
+
+  void save(std::ostream &os,
+            const int precision = std::numeric_limits<float_t>::digits10 + 2)
+    const {
+    os << std::setprecision(precision);
+    for (auto &s : states_) {
+      for (auto v : s) os << v << " ";
+    }
+  }
+
+  void load(std::istream &is,
+            const int precision = std::numeric_limits<float_t>::digits10 + 2) {
+    is >> std::setprecision(precision);
+    for (auto &s : states_) {
+      for (auto &v : s) is >> v;
+    }
+  }
+
+ private:
+  std::vector<vec_t> states_;
+};
+
+template <typename Char, typename CharTraits>
+std::basic_ostream<Char, CharTraits> &operator<<(
+  std::basic_ostream<Char, CharTraits> &os, const stream_state &s) {
+  s.save(os);
+  return os;
+}
+
+template <typename Char, typename CharTraits>
+std::basic_istream<Char, CharTraits> &operator>>(
+  std::basic_istream<Char, CharTraits> &is, stream_state &s) {
+  s.load(is);
+  return is;
+}
+
+}  // namespace tiny_dnn
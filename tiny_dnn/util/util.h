@@ -62,7 +62,26 @@ typedef size_t layer_size_t;  // for backward compatibility
 
 typedef std::vector<float_t, aligned_allocator<float_t, 64>> vec_t;
 
-typedef std::vector<vec_t> tensor_t;
+/**
+ * a sample of a tensor_t. It is a vector like vec_t, and is built from one
+ * implicitly, but it can also be a view of elements held elsewhere, e.g.
+ * its part of the block of an edge or of a buffer of the caller (see
+ * view_allocator and edge::view_features). Copies of a view own their
+ * elements.
+ **/
+class row_t : public std::vector<float_t, view_allocator<float_t, 64>> {
+ public:
+  typedef std::vector<float_t, view_allocator<float_t, 64>> base_type;
+
+  using base_type::base_type;
+
+  row_t() {}
+
+  explicit row_t(const vec_t &v)  // NOLINT
+    : base_type(v.begin(), v.end()) {}
+};
+
+typedef std::vector<row_t> tensor_t;
 
 template <typename T>
 using xtensor_t = xt::xexpression<T>;
@@ -313,7 +332,34 @@ inline std::vector<vector_type> std_input_order(bool has_bias) {
   }
 }
 
+/**
+ * the samples of a tensor as one block, each row following the previous
+ * one in memory (e.g. the data of an edge, see edge::pack), so that the
+ * batch can be used as a matrix; nullptr if they aren't
+ **/
+inline const float_t *contiguous_data(const tensor_t &tensor) {
+  if (tensor.empty()) return nullptr;
+  const float_t *first = tensor[0].data();
+  const size_t size    = tensor[0].size();
+  for (size_t sample = 1; sample < tensor.size(); sample++) {
+    if (tensor[sample].size() != size ||
+        tensor[sample].data() != first + sample * size) {
+      return nullptr;
+    }
+  }
+  return first;
+}
+
+inline float_t *contiguous_data(tensor_t &tensor) {
+  return const_cast<float_t *>(
+    contiguous_data(static_cast<const tensor_t &>(tensor)));
+}
+
 inline void fill_tensor(tensor_t &tensor, float_t value) {
+  if (float_t *data = contiguous_data(tensor)) {
+    vectorize::fill(data, tensor.size() * tensor[0].size(), value);
+    return;
+  }
   for (auto &t : tensor) {
     vectorize::fill(&t[0], t.size(), value);
   }
@@ -12,6 +12,44 @@
 namespace tiny_dnn {
 namespace weight_init {
 
+namespace detail {
+
+/**
+ * The random fillers draw every weight from a new philox_stream by its
+ * index, so that the blocks of a large weight vector are filled in parallel
+ * with the same values whatever the number of threads.
+ **/
+inline void uniform_fill(vec_t *weight, float_t min, float_t max) {
+  const philox_stream rng;
+  for_(true, 0, weight->size(), [&](const blocked_range &r) {
+    float_t *w = &(*weight)[r.begin()];
+    rng.uniform(0, 0, r.begin(), r.end() - r.begin(), w);
+    for (size_t i = 0; i < r.end() - r.begin(); i++) {
+      w[i] = min + (max - min) * w[i];
+    }
+  });
+}
+
+inline void gaussian_fill(vec_t *weight, float_t mean, float_t sigma) {
+  const philox_stream rng;
+  const float_t two_pi = float_t(6.283185307179586);
+  for_(true, 0, weight->size(), [&](const blocked_range &r) {
+    for (size_t i = r.begin(); i < r.end(); i++) {
+      // Box-Muller: weights 2k and 2k + 1 share the uniforms of block k
+      const philox_stream::block b = rng(static_cast<uint32_t>(i / 2), 1, 0, 0);
+
+      const float_t u1     = 1 - philox_stream::to_unit<float_t>(b[0]);
+      const float_t u2     = philox_stream::to_unit<float_t>(b[1]);
+      const float_t radius = std::sqrt(-2 * std::log(u1));
+      const float_t angle  = two_pi * u2;
+      (*weight)[i] =
+        mean + sigma * radius * (i % 2 ? std::sin(angle) : std::cos(angle));
+    }
+  });
+}
+
+}  // namespace detail
+
 class function {
  public:
   virtual void fill(vec_t *weight, size_t fan_in, size_t fan_out) = 0;
@@ -42,7 +80,7 @@ class xavier : public scalable {
   void fill(vec_t *weight, size_t fan_in, size_t fan_out) override {
     const float_t weight_base = std::sqrt(scale_ / (fan_in + fan_out));
 
-    uniform_rand(weight->begin(), weight->end(), -weight_base, weight_base);
+    detail::uniform_fill(weight, -weight_base, weight_base);
   }
 };
 
@@ -63,7 +101,7 @@ class lecun : public scalable {
 
     const float_t weight_base = scale_ / std::sqrt(float_t(fan_in));
 
-    uniform_rand(weight->begin(), weight->end(), -weight_base, weight_base);
+    detail::uniform_fill(weight, -weight_base, weight_base);
   }
 };
 
@@ -76,7 +114,7 @@ class gaussian : public scalable {
     CNN_UNREFERENCED_PARAMETER(fan_in);
     CNN_UNREFERENCED_PARAMETER(fan_out);
 
-    gaussian_rand(weight->begin(), weight->end(), float_t{0}, scale_);
+    detail::gaussian_fill(weight, float_t{0}, scale_);
   }
 };
 
@@ -103,7 +141,7 @@ class he : public scalable {
 
     const float_t sigma = std::sqrt(scale_ / fan_in);
 
-    gaussian_rand(weight->begin(), weight->end(), float_t{0}, sigma);
+    detail::gaussian_fill(weight, float_t{0}, sigma);
   }
 };
 